@@ -1,3 +1,4 @@
 #include <GameEngine/user_interface/user_interface.hpp>
 #include <GameEngine/graphics/graphics.hpp>
+#include <GameEngine/multithreading/multithreading.hpp>
 #include <GameEngine/Engine.hpp>
\ No newline at end of file
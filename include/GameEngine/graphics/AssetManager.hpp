@@ -0,0 +1,159 @@
+#pragma once
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/SwapChain.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <GameEngine/multithreading/AsyncIO.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <functional>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace GameEngine
+{
+    ///< Loading state of an asset
+    enum AssetState {ASSET_LOADING, ASSET_READY, ASSET_FAILED};
+
+    // State of a loaded asset, shared by its handles and the AssetManager
+    struct AssetEntry
+    {
+        std::shared_ptr<const std::string> path; // interned by the AssetManager, kept alive by the entry as handles can outlive the manager
+        std::type_index type;
+        std::atomic<int> state{ASSET_LOADING};
+        std::string error; // reason of the failure, valid once the state is ASSET_FAILED
+        JobCounter counter; // reaches zero once the loading job returned
+        unsigned int unused_collects = 0; // number of AssetManager::collect calls since the asset has no handle
+        std::shared_ptr<void> asset; // the loaded object (typed by the handles)
+        AssetEntry(const std::shared_ptr<const std::string>& _path, std::type_index _type) : path(_path), type(_type) {}
+    };
+
+    // Handle to an asset of an AssetManager. Handles are returned before the asset is loaded, and are cheap to copy:
+    // the asset stays loaded as long as a handle to it exists.
+    template<typename T>
+    class Asset
+    {
+    public:
+        ///< An empty handle
+        Asset() {}
+        Asset(const std::shared_ptr<AssetEntry>& entry) : _entry(entry) {}
+    public:
+        ///< Returns true if the handle refers to an asset
+        bool valid() const {return _entry != nullptr;}
+        ///< Returns true if the asset is loaded
+        bool ready() const {return _entry != nullptr && _entry->state.load(std::memory_order_acquire) == ASSET_READY;}
+        ///< Returns true if the asset failed to load
+        bool failed() const {return _entry != nullptr && _entry->state.load(std::memory_order_acquire) == ASSET_FAILED;}
+        ///< Returns the asset if it is loaded, or nullptr (to skip or replace it while loading)
+        T* get() const {return ready() ? static_cast<T*>(_entry->asset.get()) : nullptr;}
+        ///< Wait for the asset to be loaded (see JobSystem::wait) and return it. Throws an error if it failed to load.
+        T& wait() const
+        {
+            if (_entry == nullptr)
+            {
+                THROW_ERROR("can't wait for an empty asset handle")
+            }
+            JobSystem::wait(_entry->counter);
+            if (failed())
+            {
+                THROW_ERROR("failed to load the asset '" + *_entry->path + "': " + _entry->error)
+            }
+            return *static_cast<T*>(_entry->asset.get());
+        }
+        ///< Returns the normalized path of the asset
+        const std::string& path() const {return *_entry->path;}
+    public:
+        std::shared_ptr<AssetEntry> _entry;
+    };
+
+    // Loads the assets of files in background jobs, once per path and type: loading a file already loaded (or being loaded) returns a handle
+    // to the same object. Paths are interned, so that identical paths are stored once and the loaded assets are found by pointer.
+    // Files are read with AsyncIO, then turned into an object by the loader of its type (Shader has a default loader, Image loading from files
+    // is not implemented yet and its assets fail).
+    // The assets are reference counted by their handles, and unloaded by 'collect' once no handle refers to them.
+    class AssetManager
+    {
+    public:
+        ///< Creates an object from the path and the content of its file (empty if the loader was set not to read the file). Runs in a job.
+        template<typename T>
+        using Loader = std::function<std::shared_ptr<T>(const std::string& path, const std::vector<unsigned char>& content)>;
+        struct Key
+        {
+            std::type_index type;
+            const std::string* path;
+            bool operator==(const Key& other) const {return type == other.type && path == other.path;}
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const {return key.type.hash_code() ^ std::hash<const std::string*>()(key.path);}
+        };
+        struct LoaderEntry
+        {
+            std::shared_ptr<void> loader; // a Loader<T>
+            bool read_file;
+        };
+    public:
+        AssetManager() = delete;
+        ///< Create a manager loading the Shader assets on the given GPU (starts the JobSystem and AsyncIO if needed)
+        AssetManager(const GPU& gpu);
+        AssetManager(const AssetManager& other) = delete;
+        ///< Waits for the loads in progress. Assets still referenced by handles stay alive until their last handle is destroyed.
+        ~AssetManager();
+    public:
+        ///< Set the loader of the assets of type T. If 'read_file' is false, the loader gets an empty content and reads the file itself.
+        template<typename T>
+        void set_loader(const Loader<T>& loader, bool read_file = true)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _loaders[std::type_index(typeid(T))] = {std::make_shared<Loader<T>>(loader), read_file};
+        }
+        ///< Returns a handle to the asset of the file, starting to load it if it is not loaded or being loaded yet.
+        ///< Throws an error if no loader was set for the type.
+        template<typename T>
+        Asset<T> load(const std::string& path)
+        {
+            std::type_index type(typeid(T));
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::shared_ptr<AssetEntry> entry = _find(type, path);
+            if (entry == nullptr)
+            {
+                std::unordered_map<std::type_index, LoaderEntry>::const_iterator loader = _loaders.find(type);
+                if (loader == _loaders.end())
+                {
+                    THROW_ERROR("no loader was set for the type of the asset '" + path + "'")
+                }
+                std::shared_ptr<Loader<T>> typed_loader = std::static_pointer_cast<Loader<T>>(loader->second.loader);
+                entry = _create(type, path);
+                _start(entry, [typed_loader](const std::string& file_path, const std::vector<unsigned char>& content)
+                {
+                    return std::static_pointer_cast<void>((*typed_loader)(file_path, content));
+                }, loader->second.read_file);
+            }
+            return Asset<T>(entry);
+        }
+        ///< Unload the assets that no handle refers to anymore. An asset is destroyed once it stayed unused for 'delay' calls,
+        ///< so that the frames in flight are done with it. To call once per frame.
+        void collect(unsigned int delay = SwapChain::max_frames_in_flight + 1);
+        ///< Number of assets loaded or being loaded
+        size_t size() const;
+        ///< Returns the path in the form used to identify the assets: absolute, normalized, with '/' separators
+        static std::string normalize_path(const std::string& path);
+    public:
+        const GPU& gpu;
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, std::shared_ptr<const std::string>> _paths; // interned normalized paths, removed by 'collect' once unused
+        std::unordered_map<Key, std::shared_ptr<AssetEntry>, KeyHash> _assets;
+        std::unordered_map<std::type_index, LoaderEntry> _loaders;
+    protected:
+        // Returns the entry of an asset, or nullptr. Called with the mutex locked.
+        std::shared_ptr<AssetEntry> _find(std::type_index type, const std::string& path);
+        // Add the entry of an asset. Called with the mutex locked.
+        std::shared_ptr<AssetEntry> _create(std::type_index type, const std::string& path);
+        // Read the file and run the loader in a job
+        static void _start(const std::shared_ptr<AssetEntry>& entry,
+                           const std::function<std::shared_ptr<void>(const std::string&, const std::vector<unsigned char>&)>& loader, bool read_file);
+    };
+}
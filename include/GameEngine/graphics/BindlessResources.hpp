@@ -0,0 +1,65 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // Global arrays of sampled images, samplers and storage buffers, in a single descriptor set bound once per command buffer.
+    // Shaders index the arrays with indices passed in push constants (see shaders/include/bindless.glsl),
+    // so materials store indices instead of descriptor sets. Requires GPU::_bindless_enabled.
+    class BindlessResources
+    {
+    public:
+        enum Binding {SAMPLED_IMAGES = 0, SAMPLERS = 1, STORAGE_BUFFERS = 2};
+        ///< Push constant range of the pipelines using the bindless set, for the resource indices of a draw
+        static const uint32_t push_constants_size = 128;
+    public:
+        BindlessResources() = delete;
+        ///< The array sizes are clamped to the limits of the device
+        BindlessResources(const GPU& gpu, unsigned int max_frames_in_flight,
+                          uint32_t max_sampled_images = 16384, uint32_t max_samplers = 256, uint32_t max_storage_buffers = 16384);
+        BindlessResources(const BindlessResources& other) = delete;
+        ~BindlessResources();
+    public:
+        ///< Add an image to the sampled images array, and return its index. Thread safe.
+        uint32_t add_image(VkImageView image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        ///< Add a sampler to the samplers array, and return its index. Thread safe.
+        uint32_t add_sampler(VkSampler sampler);
+        ///< Add a buffer range to the storage buffers array, and return its index. Thread safe.
+        uint32_t add_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+        ///< Release an index. It is reused once the frames in flight that might still read it are done. Thread safe.
+        void remove(Binding binding, uint32_t index);
+        ///< Layout of the bindless set, to use as set 0 of the pipeline layouts
+        VkDescriptorSetLayout layout() const;
+        ///< Push constant range to use in the pipeline layouts
+        VkPushConstantRange push_constant_range() const;
+        ///< Bind the bindless set as set 'set_index'
+        void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set_index = 0) const;
+    public:
+        // Indices of an array: never used ones, released ones waiting for the frames in flight, and released ones ready to be reused
+        struct Slots
+        {
+            uint32_t capacity = 0;
+            uint32_t next = 0;
+            std::vector<std::vector<uint32_t>> pending; // indexed by frame in flight
+            std::vector<uint32_t> free;
+        };
+        const GPU& gpu;
+        VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+        VkDescriptorPool _pool = VK_NULL_HANDLE;
+        VkDescriptorSet _set = VK_NULL_HANDLE;
+        std::mutex _mutex;
+        Slots _slots[3]; // indexed by Binding
+        unsigned int _frame_index = 0;
+    public:
+        ///< Recycle the indices released before the previous use of the frame resources
+        void _begin_frame(unsigned int frame_index);
+        uint32_t _allocate_slot(Binding binding);
+        void _write(Binding binding, uint32_t index, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer);
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // A buffer in device local memory, for the data that doesn't change once uploaded (vertices, indices...).
+    // The content is copied from a host visible staging buffer on the transfer queue (or on the graphics queue if there is none).
+    class Buffer
+    {
+    public:
+        Buffer() = delete;
+        ///< Create a buffer with the given usage and upload 'size' bytes of 'data' to it. Returns once the upload is done:
+        ///< inside a job the job is suspended meanwhile, otherwise the thread runs jobs (see JobSystem::wait).
+        ///< If 'data' is nullptr, the content is left undefined, for the buffers written by the GPU.
+        Buffer(const GPU& gpu, const void* data, VkDeviceSize size, VkBufferUsageFlags usage);
+        Buffer(const Buffer& other) = delete;
+        ~Buffer();
+    public:
+        ///< Size of the buffer in bytes
+        VkDeviceSize size() const;
+    public:
+        const GPU& gpu;
+        VkBuffer _vk_buffer = VK_NULL_HANDLE;
+        VkDeviceMemory _vk_memory = VK_NULL_HANDLE;
+        VkDeviceSize _size;
+    public:
+        ///< Create a buffer and bind it to a new allocation with the given memory properties.
+        ///< If the graphics, transfer and compute queues are of different families, the buffer is shared by all of them.
+        static void _create(const GPU& gpu, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                            VkBuffer& buffer, VkDeviceMemory& memory);
+        ///< Copy the data to the buffer through a staging buffer, and wait for the copy
+        void _upload(const void* data, VkDeviceSize size);
+    };
+}
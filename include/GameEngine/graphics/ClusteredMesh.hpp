@@ -0,0 +1,81 @@
+#pragma once
+#include <GameEngine/graphics/Buffer.hpp>
+#include <GameEngine/graphics/Mesh.hpp>
+#include <GameEngine/graphics/MeshData.hpp>
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace GameEngine
+{
+    class GPU;
+    class Shader;
+    class DescriptorSets;
+
+    // A mesh split in meshlets (see MeshData::build_meshlets), culled each frame against the view by a compute shader (shaders/meshlets/cull.comp),
+    // preferably on the async compute queue (see SwapChain::async_compute_commands). The culling writes the indirect draw commands:
+    //  - with mesh shaders, each visible meshlet is drawn by a workgroup of the mesh shader (shaders/meshlets/meshlet.mesh)
+    //  - otherwise, the triangles of the visible meshlets are appended to an index buffer drawn with the vertex inputs of the mesh
+    // The vertices are QUANTIZED and INTERLEAVED. The culling results are per frame in flight, so a mesh is culled for a single view per frame.
+    class ClusteredMesh
+    {
+    public:
+        ///< View the meshlets are culled against, in the object space of the mesh
+        struct View
+        {
+            float frustum[6][4]; ///< planes (a, b, c, d) with a unit normal pointing inside: a.x + b.y + c.z + d >= 0 inside the frustum
+            float camera[3]; ///< position of the camera
+        };
+    public:
+        ClusteredMesh() = delete;
+        ///< Upload a mesh (reordered beforehand with MeshData::optimize) and its meshlets. Throws an error if it has no triangle, too many meshlets,
+        ///< or with mesh shaders if the meshlets are larger than the outputs of meshlet.mesh (64 vertices and 124 triangles).
+        ClusteredMesh(const GPU& gpu, const MeshData& data, unsigned int max_frames_in_flight,
+                      unsigned int max_vertices = 64, unsigned int max_triangles = 124);
+        ClusteredMesh(const ClusteredMesh& other) = delete;
+        ///< Evict the sets of the buffers from the DescriptorSets the mesh was culled or drawn with, which must still exist
+        ~ClusteredMesh();
+    public:
+        ///< The vertices, and all the triangles for the draws without culling (depth only passes...)
+        Mesh mesh;
+    public:
+        ///< Returns true if the meshlets are drawn by mesh shaders
+        bool mesh_shaders() const;
+        ///< Number of meshlets
+        uint32_t meshlet_count() const;
+        ///< Record the culling of the meshlets for the given frame with shaders/meshlets/cull.comp. If 'async' is false the command buffer
+        ///< is on the graphics queue, and a barrier makes the results visible to the draws recorded after it.
+        void cull(VkCommandBuffer command_buffer, unsigned int frame_index, DescriptorSets& descriptor_sets, const Shader& culling_shader,
+                  const View& view, bool async) const;
+        ///< Pipeline layout of the mesh shader pipelines, from the reflection of the mesh shader (shaders/meshlets/meshlet.mesh):
+        ///< set 0 holds the meshlet buffers, and the push constants are those of the shader
+        VkPipelineLayout mesh_shader_layout(DescriptorSets& descriptor_sets, const Shader& mesh_shader) const;
+        ///< Record the draw of the meshlets left by the culling of the frame with the bound pipeline: a mesh shader pipeline of 'mesh_shader' with
+        ///< the mesh_shader_layout if mesh_shaders() is true, otherwise a pipeline with the vertex inputs of the mesh (see Mesh::vertex_input).
+        ///< 'mesh_shader' is only needed with mesh shaders.
+        void draw(VkCommandBuffer command_buffer, unsigned int frame_index, DescriptorSets& descriptor_sets, const Shader* mesh_shader = nullptr) const;
+    public:
+        // Culling results of a frame in flight
+        struct FrameOutput
+        {
+            std::unique_ptr<Buffer> visible; // indices of the visible meshlets
+            std::unique_ptr<Buffer> commands; // VkDrawMeshTasksIndirectCommandNV, then VkDrawIndexedIndirectCommand
+            std::unique_ptr<Buffer> indices; // triangles of the visible meshlets, nullptr with mesh shaders
+        };
+        const GPU& gpu;
+        uint32_t _meshlet_count;
+        std::unique_ptr<Buffer> _meshlets;
+        std::unique_ptr<Buffer> _meshlet_vertices;
+        std::unique_ptr<Buffer> _meshlet_triangles;
+        std::vector<FrameOutput> _frames;
+        mutable std::mutex _descriptor_sets_mutex;
+        mutable std::vector<DescriptorSets*> _descriptor_sets; // caching sets of the buffers, which are evicted on destruction
+    public:
+        ///< Returns the set of the meshlet buffers of a frame bound by the set 0 of the culling or mesh shader
+        VkDescriptorSet _set(DescriptorSets& descriptor_sets, unsigned int frame_index, const Shader& shader) const;
+        ///< Returns the layout of the set 0 of the culling or mesh shader, from its reflection
+        VkDescriptorSetLayout _set_layout(DescriptorSets& descriptor_sets, const Shader& shader) const;
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // Command pools of each frame in flight and each recording thread.
+    // A thread only ever allocates from its own pools, so no locking is needed, and all the pools of a frame are reset at once
+    // when the frame's resources are reused, instead of resetting command buffers one by one.
+    class CommandPools
+    {
+    public:
+        ///< Command pool of a thread for a frame, and the command buffers allocated from it
+        struct ThreadPool
+        {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> primaries;
+            std::vector<VkCommandBuffer> secondaries;
+            size_t used_primaries = 0;
+            size_t used_secondaries = 0;
+        };
+    public:
+        CommandPools() = delete;
+        CommandPools(const GPU& gpu, uint32_t queue_family, unsigned int max_frames_in_flight, unsigned int max_threads = 64);
+        CommandPools(const CommandPools& other) = delete;
+        ~CommandPools();
+    public:
+        const GPU& gpu;
+        uint32_t _queue_family;
+        unsigned int _max_threads;
+        std::vector<std::vector<ThreadPool>> _pools; // indexed by frame in flight, then by thread index
+    public:
+        ///< Returns a command buffer of the calling thread's pool for the given frame. It is valid until the frame's pools are reset.
+        VkCommandBuffer _allocate(unsigned int frame_index, VkCommandBufferLevel level);
+        ///< Reset all the pools of a frame. The GPU must be done with the frame and no thread must be recording for it.
+        void _reset(unsigned int frame_index);
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // Allocates descriptor sets from descriptor pools created on demand. A full pool is replaced by a new (bigger) one,
+    // and all the sets are freed at once by resetting the pools. Not thread safe.
+    class DescriptorAllocator
+    {
+    public:
+        ///< Number of descriptors of each type in a pool, per set the pool can hold
+        struct PoolRatio
+        {
+            VkDescriptorType type;
+            float ratio;
+        };
+    public:
+        DescriptorAllocator() = delete;
+        DescriptorAllocator(const GPU& gpu, VkDescriptorPoolCreateFlags flags = 0, uint32_t initial_sets_per_pool = 64);
+        DescriptorAllocator(const DescriptorAllocator& other) = delete;
+        ~DescriptorAllocator();
+    public:
+        ///< Allocate a set of the given layout. 'variable_count' is the number of descriptors of a variable sized last binding (if any).
+        ///< If 'pool' is not nullptr it is set to the pool of the set, to free it individually.
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout, uint32_t variable_count = 0, VkDescriptorPool* pool = nullptr);
+        ///< Free a set allocated from the given pool. The allocator must have been created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        ///< and the GPU must not be using the set anymore.
+        void free(VkDescriptorSet set, VkDescriptorPool pool);
+        ///< Free all the sets allocated. The GPU must not be using them anymore.
+        void reset();
+    public:
+        static const std::vector<PoolRatio> _pool_ratios;
+        static const uint32_t _max_sets_per_pool = 4096;
+        const GPU& gpu;
+        VkDescriptorPoolCreateFlags _flags;
+        uint32_t _sets_per_pool;
+        VkDescriptorPool _current_pool = VK_NULL_HANDLE;
+        std::vector<VkDescriptorPool> _used_pools; // pools sets were allocated from since the last reset (including the current one)
+        std::vector<VkDescriptorPool> _free_pools; // pools reset and ready to be reused
+    protected:
+        VkDescriptorPool _grab_pool();
+    };
+}
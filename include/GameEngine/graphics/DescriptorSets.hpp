@@ -0,0 +1,87 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/graphics/DescriptorAllocator.hpp>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+namespace GameEngine
+{
+    class GPU;
+
+    ///< The resource bound to a binding of a descriptor set (a buffer, an image or a texel buffer view, depending on the descriptor type)
+    struct DescriptorWrite
+    {
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        VkDescriptorBufferInfo buffer = {VK_NULL_HANDLE, 0, VK_WHOLE_SIZE};
+        VkDescriptorImageInfo image = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+        VkBufferView texel_buffer = VK_NULL_HANDLE; ///< for the uniform and storage texel buffers
+    };
+
+    // Descriptor set layouts and descriptor sets of the engine:
+    // - the layouts are cached by the hash of their bindings, so that identical layouts are created once
+    // - the sets rebuilt each frame are allocated from per frame and per thread pools, reset all at once when the frame begins
+    // - the sets whose content never changes are cached by the hash of their content, so they are allocated and written once,
+    //   and freed when one of their resources is evicted (see evict_buffer)
+    class DescriptorSets
+    {
+    public:
+        DescriptorSets() = delete;
+        DescriptorSets(const GPU& gpu, unsigned int max_frames_in_flight, unsigned int max_threads = 64);
+        DescriptorSets(const DescriptorSets& other) = delete;
+        ~DescriptorSets();
+    public:
+        ///< Returns a layout with the given bindings (created on the first request). Thread safe.
+        VkDescriptorSetLayout layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+        ///< Returns a set written with the given resources, valid until the frame's pools are reset. Thread safe.
+        VkDescriptorSet frame_set(unsigned int frame_index, VkDescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes);
+        ///< Returns a set written with the given resources, that lives as long as this object or until one of its resources is evicted.
+        ///< Requesting the same layout and resources again returns the same set. Thread safe.
+        VkDescriptorSet immutable_set(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes);
+        ///< Free the immutable sets using a resource, to call when it is destroyed: the cache is keyed by the resource handles,
+        ///< which can be reused by new resources. The GPU must not be using the sets anymore. Thread safe.
+        void evict_buffer(VkBuffer buffer);
+        void evict_image_view(VkImageView image_view);
+        void evict_texel_buffer(VkBufferView texel_buffer);
+    public:
+        struct LayoutKey
+        {
+            std::vector<VkDescriptorSetLayoutBinding> bindings; // sorted by binding, pImmutableSamplers is ignored
+            std::vector<VkSampler> immutable_samplers; // the immutable samplers of all the bindings, in order
+            VkDescriptorSetLayoutCreateFlags flags;
+            bool operator==(const LayoutKey& other) const;
+        };
+        struct SetKey
+        {
+            VkDescriptorSetLayout layout;
+            std::vector<DescriptorWrite> writes;
+            bool operator==(const SetKey& other) const;
+        };
+        struct KeyHash
+        {
+            size_t operator()(const LayoutKey& key) const;
+            size_t operator()(const SetKey& key) const;
+        };
+        const GPU& gpu;
+        unsigned int _max_threads;
+        std::mutex _layout_mutex;
+        std::unordered_map<LayoutKey, VkDescriptorSetLayout, KeyHash> _layouts;
+        std::mutex _immutable_mutex;
+        DescriptorAllocator _immutable_allocator;
+        std::unordered_map<SetKey, std::pair<VkDescriptorSet, VkDescriptorPool>, KeyHash> _immutable_sets; // set and the pool it was allocated from
+        std::vector<std::vector<std::unique_ptr<DescriptorAllocator>>> _frame_allocators; // indexed by frame in flight, then by thread index
+    public:
+        ///< Free the sets of a frame. The GPU must be done with the frame, and no thread must be writing sets for it.
+        void _reset(unsigned int frame_index);
+        ///< Write the resources in a set
+        void _write(VkDescriptorSet set, const std::vector<DescriptorWrite>& writes);
+        ///< Free the immutable sets with a write for which 'uses' returns true
+        template<typename Uses>
+        void _evict(Uses uses);
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/utilities/LinearAllocator.hpp>
+#include <vector>
+#include <functional>
+
+namespace GameEngine
+{
+    class CommandPools;
+    class FrameAllocators;
+
+    // An ordered set of draw lists, each recorded in a secondary command buffer.
+    // The lists can be recorded concurrently from any threads (each index by a single thread), and are then executed in order in a primary command buffer.
+    class DrawLists
+    {
+    public:
+        DrawLists() = delete;
+        ///< Prepare the recording of 'count' draw lists for the given frame. If render_pass is not VK_NULL_HANDLE, the lists continue the given subpass.
+        ///< The lists are stored in the frame allocators, so the object must not outlive the frame.
+        DrawLists(CommandPools& pools, FrameAllocators& allocators, unsigned int frame_index, unsigned int count,
+                  VkRenderPass render_pass = VK_NULL_HANDLE, uint32_t subpass = 0, VkFramebuffer framebuffer = VK_NULL_HANDLE);
+        ~DrawLists();
+    public:
+        ///< Number of draw lists
+        unsigned int size() const;
+        ///< Record the draw list of given index by calling 'recording' with its command buffer. Thread safe for distinct indexes.
+        void record(unsigned int index, const std::function<void(VkCommandBuffer)>& recording);
+        ///< Record the execution of the recorded draw lists in order into a primary command buffer. Lists that were not recorded are skipped.
+        void execute(VkCommandBuffer primary) const;
+    public:
+        CommandPools& _pools;
+        FrameAllocators& _allocators;
+        unsigned int _frame_index;
+        VkCommandBufferInheritanceInfo _inheritance;
+        ArenaVector<VkCommandBuffer> _command_buffers;
+    };
+}
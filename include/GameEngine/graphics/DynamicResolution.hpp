@@ -0,0 +1,61 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/graphics/Image.hpp>
+#include <vector>
+#include <memory>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // Renders the scene in an internal render target whose resolution is adjusted to keep the GPU time of a frame under budget.
+    // The render target is allocated at full resolution, and the scene is rendered in its top left region, which is then upscaled to the swap chain image.
+    class DynamicResolution
+    {
+    public:
+        DynamicResolution() = delete;
+        DynamicResolution(const GPU& gpu, unsigned int max_frames_in_flight);
+        ~DynamicResolution();
+    public:
+        ///< If true, the scene is rendered at a dynamic resolution
+        bool enabled = false;
+        ///< GPU time budget of a frame in seconds
+        double target_frame_time = 1./60.;
+        ///< Minimum and maximum resolution scale
+        double min_scale = 0.5;
+        double max_scale = 1.;
+        ///< Number of frames over which the GPU time is averaged before adjusting the scale
+        unsigned int adjustment_period = 8;
+        ///< The scale is increased only if the GPU time is below this fraction of the budget, so that it doesn't oscillate around the budget
+        double increase_threshold = 0.85;
+    public:
+        ///< Returns the current resolution scale
+        double scale() const;
+        ///< Returns the average GPU time of the last frames in seconds (-1 if not measured yet)
+        double gpu_frame_time() const;
+    public:
+        const GPU& gpu;
+        double _scale = 1.;
+        double _gpu_frame_time = -1.;
+        bool _timestamps_supported = false;
+        uint64_t _timestamp_mask;
+        VkQueryPool _vk_query_pool = VK_NULL_HANDLE;
+        std::vector<bool> _queries_written; // for each frame in flight, true if its timestamps were written
+        double _accumulated_time = 0.;
+        unsigned int _accumulated_frames = 0;
+        std::unique_ptr<Image> _render_target;
+        VkExtent2D _render_extent = {0, 0};
+    public:
+        ///< Returns true if the scene can be rendered at a dynamic resolution and upscaled to images of the given format
+        bool _supported(VkFormat output_format) const;
+        ///< Read the GPU time of the last use of this frame's resources, update the scale, and record the start of the scene rendering
+        void _begin(VkCommandBuffer command_buffer, unsigned int frame_index, VkExtent2D output_extent, VkFormat output_format);
+        ///< Record the end of the scene rendering
+        void _end(VkCommandBuffer command_buffer, unsigned int frame_index);
+        ///< Record the upscaling of the rendered region to the output image (in the TRANSFER_DST_OPTIMAL layout)
+        void _upscale(VkCommandBuffer command_buffer, VkImage output_image, VkExtent2D output_extent);
+    protected:
+        void _update_scale(double frame_time);
+    };
+}
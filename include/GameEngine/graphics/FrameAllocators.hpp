@@ -0,0 +1,27 @@
+#pragma once
+#include <GameEngine/utilities/LinearAllocator.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+    // Linear allocators of each frame in flight and each thread, for the temporary CPU data of a frame.
+    // All the allocators of a frame are reset at once when the frame's fence signaled, so the steady state frame loop does no heap allocation.
+    class FrameAllocators
+    {
+    public:
+        FrameAllocators() = delete;
+        FrameAllocators(unsigned int max_frames_in_flight, unsigned int max_threads = 64, size_t block_size = 64*1024);
+        FrameAllocators(const FrameAllocators& other) = delete;
+        ~FrameAllocators();
+    public:
+        ///< Returns the calling thread's allocator for the given frame. Its allocations are valid until the frame's allocators are reset.
+        LinearAllocator& get(unsigned int frame_index);
+    public:
+        unsigned int _max_threads;
+        std::vector<std::vector<LinearAllocator>> _allocators; // indexed by frame in flight, then by thread index
+    public:
+        ///< Reset all the allocators of a frame. No thread must still be using the frame's allocations.
+        void _reset(unsigned int frame_index);
+    };
+}
@@ -4,6 +4,8 @@
 #include <set>
 #include <string>
 #include <optional>
+#include <memory>
+#include <mutex>
 #include <GameEngine/utilities/External.hpp>
 #include <GameEngine/Engine.hpp>
 
@@ -11,6 +13,7 @@ namespace GameEngine
 {
     class Window;
     class Handles;
+    class ObjectCache;
 
     class GPU
     {
@@ -19,7 +22,11 @@ namespace GameEngine
 
     public:
         GPU() = delete;
-        GPU(VkPhysicalDevice device, const Handles& events, const std::vector<std::string>& extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME});
+        GPU(VkPhysicalDevice device, const Handles& events, const std::vector<std::string>& extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+                                                                                                            VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                                                                                                            VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+                                                                                                            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+                                                                                                            VK_NV_MESH_SHADER_EXTENSION_NAME});
         GPU(const GPU& other);
         ~GPU();
         // Device name
@@ -49,7 +56,18 @@ namespace GameEngine
         std::optional<VkQueue> _compute_queue;
         std::optional<VkQueue> _present_queue;
         std::set<std::string> _enabled_extensions;
+        bool _present_wait_enabled = false; // true if the present id and present wait features are enabled
+        bool _bindless_enabled = false; // true if the descriptor indexing features needed by BindlessResources are enabled
+        bool _mesh_shader_enabled = false; // true if the mesh shader feature is enabled (VK_NV_mesh_shader, used by ClusteredMesh)
+        PFN_vkCmdDrawMeshTasksIndirectNV _vk_draw_mesh_tasks_indirect = nullptr;
+        uint32_t _max_draw_mesh_tasks_count = 0; // maximum number of mesh shader workgroups of a draw
         VkDevice _logical_device;
+        std::shared_ptr<VkDevice_T> _device; // owns _logical_device, declared before the cache so that the cache is released first
+        std::shared_ptr<ObjectCache> _object_cache; // pipeline layouts, render passes, samplers and pipelines shared by the whole device
+        std::shared_ptr<std::mutex> _queue_mutex; // locked to submit to the queues, which can be used from several threads (uploads and frames)
+    public:
+        // returns the index of a memory type allowed by the type bits and with the given properties
+        uint32_t _find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) const;
     protected:
         // add a queue family of given type to the selected families
         std::optional<uint32_t> _select_queue_family(std::vector<VkQueueFamilyProperties>& queue_families,
@@ -0,0 +1,76 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace GameEngine
+{
+    // Allocation callbacks passed to every Vulkan call of the engine, so that the host memory used by the driver can be monitored.
+    // The allocations are counted per allocation scope, and small allocations can be served from pooled size classes.
+    class HostAllocator
+    {
+    public:
+        ///< Host memory usage of an allocation scope
+        struct Statistics
+        {
+            size_t bytes = 0; ///< currently allocated bytes (as requested by the driver)
+            size_t count = 0; ///< currently live allocations
+            size_t peak_bytes = 0; ///< highest value reached by 'bytes'
+            size_t total_allocations = 0; ///< allocations made since the start
+            size_t internal_bytes = 0; ///< bytes the driver reported allocating by itself (executable memory)
+        };
+        static const unsigned int n_scopes = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+        static const unsigned int n_size_classes = 7; // from 64 to 4096 bytes (header included)
+    public:
+        ///< If true, allocations of up to 4 kB (with an alignment of at most 16) are served from free lists that are never given back to the system.
+        ///< Can be changed at any time, each allocation remembers how it was made.
+        static std::atomic<bool> pooling;
+    public:
+        ///< The callbacks to pass to the Vulkan functions
+        static const VkAllocationCallbacks* callbacks();
+        ///< Memory usage of an allocation scope
+        static Statistics statistics(VkSystemAllocationScope scope);
+        ///< Memory usage summed over all scopes. Its peak is the highest total reached, not the sum of the peaks of the scopes.
+        static Statistics total();
+        ///< Name of an allocation scope
+        static std::string scope_name(VkSystemAllocationScope scope);
+        ///< Print the memory usage of each scope
+        static void report(std::ostream& out);
+        ///< Give the unused pooled blocks back to the system
+        static void trim();
+    public:
+        // Stored right before each returned pointer
+        struct alignas(16) Header
+        {
+            void* block; // start of the underlying allocation
+            size_t size; // size requested by the driver
+            uint32_t scope;
+            int32_t size_class; // -1 if the block is not pooled
+        };
+        struct Counters
+        {
+            std::atomic<size_t> bytes{0};
+            std::atomic<size_t> count{0};
+            std::atomic<size_t> peak_bytes{0};
+            std::atomic<size_t> total_allocations{0};
+            std::atomic<size_t> internal_bytes{0};
+        };
+        static VkAllocationCallbacks _callbacks;
+        static Counters _counters[n_scopes];
+        static Counters _total_counters; // only 'bytes' and 'peak_bytes', summed over all scopes
+        static std::mutex _pool_mutexes[n_size_classes];
+        static std::vector<void*> _free_blocks[n_size_classes];
+    public:
+        static void* VKAPI_CALL _allocate(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void* VKAPI_CALL _reallocate(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void VKAPI_CALL _free(void* user_data, void* memory);
+        static void VKAPI_CALL _internal_allocation(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+        static void VKAPI_CALL _internal_free(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    };
+}
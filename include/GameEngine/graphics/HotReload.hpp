@@ -0,0 +1,80 @@
+#pragma once
+#include "Shader.hpp"
+#include <GameEngine/utilities/FileWatcher.hpp>
+#include <GameEngine/utilities/DerivedDataCache.hpp>
+#include <GameEngine/multithreading/JobCounter.hpp>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace GameEngine
+{
+    // Reloads the assets whose files are modified while the engine runs.
+    // Shaders are rebuilt in background jobs: a GLSL source is compiled to SPIR-V with an external compiler (glslc by default),
+    // the new module is created, and the cached pipelines built from the previous module are compiled again with it.
+    // The rebuilt shaders are swapped in by update() between two frames, and the replaced modules and pipelines
+    // are destroyed by the ObjectCache once the frames in flight are done with them.
+    // With a DerivedDataCache, the SPIR-V is cached by the content of the source, of the '.glsl' includes of the watched directories
+    // and the compiler command, so that a source changed back to a previous version is not compiled again.
+    class HotReload
+    {
+    public:
+        ///< A shader reloaded when its file changes
+        struct WatchedShader
+        {
+            Shader* shader;
+            std::string spirv_path;
+            std::string source_path; ///< GLSL source compiled to spirv_path, or empty if the SPIR-V file itself is watched
+        };
+        ///< A shader being rebuilt in the background
+        struct Rebuild
+        {
+            Shader* shader;
+            VkShaderModule module; // the module being replaced
+            std::unique_ptr<Shader> replacement; // nullptr if the rebuild failed
+            JobCounter counter;
+        };
+    public:
+        HotReload() = delete;
+        ///< Watch the files of the directories. 'compiler' is the GLSL compiler, called as: compiler "source" -o "output".
+        ///< The compiled shaders are cached in 'cache' if it is not nullptr (it must outlive this object).
+        HotReload(const GPU& gpu, const std::vector<std::string>& directories, const std::string& compiler = "glslc", DerivedDataCache* cache = nullptr);
+        HotReload(const HotReload& other) = delete;
+        ///< Waits for the rebuilds in progress, and discards them
+        ~HotReload();
+    public:
+        ///< Rebuild the shader when its SPIR-V file changes, or when its GLSL source changes if 'source_path' is not empty (compiled to 'spirv_path' then).
+        ///< GLSL shaders are also rebuilt when a '.glsl' include of the watched directories changes.
+        void watch(Shader& shader, const std::string& spirv_path, const std::string& source_path = "");
+        ///< Call 'reload' with the path of the file from update() when the file changes (for the assets other than the shaders, like textures)
+        void watch(const std::string& path, const std::function<void(const std::string&)>& reload);
+        ///< Stop watching the shader (to call before destroying it). Waits for its rebuild if one is in progress.
+        void forget(const Shader& shader);
+        ///< Start the rebuilds of the shaders whose files changed, swap in the finished ones, and call the reload functions of the other changed files.
+        ///< To call between two frames, from the thread rendering them.
+        void update();
+    public:
+        const GPU& gpu;
+        std::string _compiler;
+        DerivedDataCache* _cache;
+        FileWatcher _watcher;
+        std::unordered_map<std::string, std::vector<WatchedShader>> _shaders; // watched shaders of each watched file
+        std::unordered_map<std::string, std::vector<std::function<void(const std::string&)>>> _reloads; // reload functions of each watched file
+        std::vector<std::unique_ptr<Rebuild>> _rebuilds; // rebuilds in progress
+        std::vector<WatchedShader> _postponed; // shaders modified again while being rebuilt
+    protected:
+        void _start(const WatchedShader& watched);
+        // Build the replacement of a shader and compile the cached pipelines using it. Runs in a job.
+        static void _rebuild(const WatchedShader& watched, Rebuild& rebuild, const std::string& compiler, DerivedDataCache* cache,
+                             const std::vector<std::string>& directories, bool recursive);
+        // Compile a GLSL source to its SPIR-V file, or write the SPIR-V cached for the same sources and compiler
+        static void _compile(const WatchedShader& watched, const std::string& compiler, DerivedDataCache* cache,
+                             const std::vector<std::string>& directories, bool recursive);
+        // Replace the module of the shader by the rebuilt one
+        void _swap(Rebuild& rebuild);
+        // Destroy the rebuilt module and the pipelines compiled with it
+        void _discard(Rebuild& rebuild);
+    };
+}
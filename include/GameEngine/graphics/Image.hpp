@@ -15,6 +15,8 @@ namespace GameEngine
         Image() = delete;
         Image(const GPU& gpu, const std::string& file_path);
         Image(const GPU& gpu, unsigned int width, unsigned int height, Format format, const std::vector<unsigned char>& data);
+        ///< Create an uninitialized image in GPU memory, with the given Vulkan format and usage (for render targets)
+        Image(const GPU& gpu, unsigned int width, unsigned int height, VkFormat format, VkImageUsageFlags usage);
         ~Image();
     public:
         const GPU& gpu;
@@ -22,6 +24,13 @@ namespace GameEngine
         unsigned int height;
         Format _format;
         VkFormat _vk_image_format;
-        VkImage _vk_image;
+        VkImage _vk_image = VK_NULL_HANDLE;
+        VkDeviceMemory _vk_memory = VK_NULL_HANDLE;
+    public:
+        ///< Record a layout transition of the color of an image, with the given synchronization scopes
+        static void _layout_transition(VkCommandBuffer command_buffer, VkImage image,
+                                       VkImageLayout old_layout, VkImageLayout new_layout,
+                                       VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                                       VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
     };
-}
\ No newline at end of file
+}
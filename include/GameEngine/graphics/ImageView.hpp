@@ -15,7 +15,7 @@ namespace GameEngine
     public:
         const Image& image;
         VkImageView _vk_image_view;
-        VkPipelineLayout _vk_graphic_pipeline;
+        VkPipelineLayout _vk_graphic_pipeline; // owned by the GPU's object cache
     protected:
         void _set_vk_image_view();
         void _set_graphic_pipeline();
@@ -0,0 +1,39 @@
+#pragma once
+#include <GameEngine/graphics/MeshData.hpp>
+#include <vector>
+
+namespace GameEngine
+{
+    ///< LOD of a mesh instance, kept from frame to frame and updated by LodSelection::update
+    struct LodState
+    {
+        unsigned int lod = 0; ///< LOD to draw
+        unsigned int previous_lod = 0; ///< LOD fading out during a cross-fade
+        float fade = 1.f; ///< progress of the cross-fade from previous_lod to lod, 1 when there is none
+        ///< If true, both LODs are drawn: lod with 'fade' and previous_lod with 1 - 'fade' (see shaders/include/lod.glsl)
+        bool fading() const;
+    };
+
+    // Runtime selection of the LOD of the mesh instances: the coarsest LOD whose simplification error, projected on screen, is below a number of pixels.
+    class LodSelection
+    {
+    public:
+        ///< Maximum error on screen in pixels
+        float pixel_error = 1.f;
+        ///< A coarser LOD is only selected once its error is below (1 - hysteresis) * pixel_error, so that an instance at the switching distance doesn't pop back and forth
+        float hysteresis = 0.25f;
+        ///< Duration of the cross-fade between two LODs in seconds. 0 switches instantly.
+        float fade_duration = 0.f;
+    public:
+        ///< Set the perspective projection: vertical field of view in radians and height of the rendered viewport in pixels
+        void set_projection(float vertical_fov, float viewport_height);
+        ///< Returns the size in pixels of an object space error, at given distance from the camera, for an instance of given scale
+        float projected_error(float error, float distance, float scale = 1.f) const;
+        ///< Returns the coarsest LOD whose projected error is below 'max_pixel_error'
+        unsigned int select(const std::vector<MeshLod>& lods, float distance, float scale, float max_pixel_error) const;
+        ///< Update the LOD of an instance at 'distance' from the camera, 'elapsed' seconds after its last update
+        void update(LodState& state, const std::vector<MeshLod>& lods, float distance, float scale, float elapsed) const;
+    public:
+        float _pixels_per_unit = 1.f; // at a distance of 1
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <GameEngine/graphics/Buffer.hpp>
+#include <GameEngine/graphics/MeshData.hpp>
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <memory>
+#include <vector>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // A mesh in device local vertex and index buffers, with its LODs (see MeshData::generate_lods) in ranges of the same index buffer.
+    // The indices are 16 bits when there are at most 65536 vertices.
+    // With the SEPARATE_POSITIONS layout the positions are in their own stream, so that the depth and shadow passes only fetch the positions.
+    // QUANTIZED vertices take 16 bytes instead of 48, and are decoded by the functions of shaders/include/quantization.glsl
+    // with the bounds of the mesh. The vertex shader inputs are at locations:
+    //  - FULL_PRECISION: 0 position (vec3), 1 normal (vec3), 2 uv (vec2), 3 tangent (vec4)
+    //  - QUANTIZED: 0 position and bitangent sign (vec4), 1 octahedral normal and tangent (vec4), 2 uv (vec2)
+    class Mesh
+    {
+    public:
+        ///< Layout of the vertices in memory
+        enum Layout
+        {
+            INTERLEAVED, ///< a single stream of whole vertices
+            SEPARATE_POSITIONS ///< a stream of positions, and a stream of the other attributes
+        };
+        ///< Format of the vertex attributes
+        enum Format
+        {
+            FULL_PRECISION, ///< 32 bits floats
+            QUANTIZED ///< QuantizedVertex (see MeshData::quantize)
+        };
+    public:
+        Mesh() = delete;
+        ///< Upload a mesh (reordered beforehand with MeshData::optimize). Throws an error if it has no triangle.
+        Mesh(const GPU& gpu, const MeshData& data, Layout layout = SEPARATE_POSITIONS, Format format = QUANTIZED);
+        Mesh(const Mesh& other) = delete;
+        ~Mesh();
+    public:
+        ///< Set the vertex bindings and attributes of the state of a pipeline drawing the mesh.
+        ///< With 'positions_only', the position is the only input (for the depth only passes).
+        void vertex_input(PipelineState& state, bool positions_only = false) const;
+        ///< Record the binding of the vertex and index buffers and the draw of the given LOD of the mesh (clamped to the coarsest one)
+        void draw(VkCommandBuffer command_buffer, bool positions_only = false, uint32_t instance_count = 1, unsigned int lod = 0) const;
+        ///< LODs from the finest to the coarsest, at least one
+        const std::vector<MeshLod>& lods() const;
+        Layout layout() const;
+        Format format() const;
+        ///< Bounds to decode the quantized positions and uvs (offset 0 and scale 1 with the FULL_PRECISION format)
+        const QuantizationBounds& bounds() const;
+        uint32_t vertex_count() const;
+        uint32_t index_count() const;
+        VkIndexType index_type() const;
+    public:
+        const GPU& gpu;
+        Layout _layout;
+        Format _format;
+        QuantizationBounds _bounds;
+        uint32_t _vertex_count;
+        uint32_t _index_count;
+        VkIndexType _index_type;
+        std::vector<MeshLod> _lods;
+        std::unique_ptr<Buffer> _vertices; // whole vertices, or the positions with the SEPARATE_POSITIONS layout
+        std::unique_ptr<Buffer> _attributes; // the other attributes with the SEPARATE_POSITIONS layout, nullptr otherwise
+        std::unique_ptr<Buffer> _indices;
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace GameEngine
+{
+    ///< A vertex of an imported mesh
+    struct Vertex
+    {
+        float position[3];
+        float normal[3];
+        float tangent[4]; ///< w is the sign of the bitangent: cross(normal, tangent.xyz) * w
+        float uv[2];
+    };
+
+    ///< A vertex quantized to 16 bytes by MeshData::quantize (decoded by shaders/include/quantization.glsl)
+    struct QuantizedVertex
+    {
+        uint16_t position[4]; ///< unorm in the bounding box of the mesh. w is the bitangent sign: 0 for -1, 65535 for +1.
+        int8_t normal[2]; ///< octahedral encoding, snorm
+        int8_t tangent[2]; ///< octahedral encoding, snorm
+        uint16_t uv[2]; ///< unorm in the uv bounds of the mesh
+    };
+
+    ///< Decoding of the quantized positions and uvs: value = offset + unorm * scale
+    struct QuantizationBounds
+    {
+        float position_offset[3];
+        float position_scale[3];
+        float uv_offset[2];
+        float uv_scale[2];
+    };
+
+    ///< A level of detail of a mesh: a range of its indices drawn with its vertices
+    struct MeshLod
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        float error; ///< maximum distance from the vertices and triangle centers of the full detail surface to this LOD, in object space
+    };
+
+    ///< A cluster of neighbouring triangles of a mesh, culled as a whole (see ClusteredMesh). Matches the Meshlet struct of shaders/include/meshlets.glsl.
+    struct Meshlet
+    {
+        float center[3]; ///< bounding sphere
+        float radius;
+        float cone_axis[3]; ///< normal cone: all the triangles face away from a camera at c if dot(center - c, cone_axis) >= cone_cutoff * |center - c| + radius
+        float cone_cutoff; ///< 1 if the normals are too spread for the meshlet to ever face away
+        uint32_t vertex_offset; ///< first vertex in MeshletData::vertices
+        uint32_t triangle_offset; ///< first triangle in MeshletData::triangles
+        uint32_t vertex_count;
+        uint32_t triangle_count;
+    };
+
+    ///< The meshlets of a mesh: each has a list of the mesh vertices it uses, and triangles indexing this list
+    struct MeshletData
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> vertices; ///< indices in MeshData::vertices
+        std::vector<uint32_t> triangles; ///< three 8 bits indices in the vertices of the meshlet per triangle: a | b << 8 | c << 16
+    };
+
+    // The geometry of a mesh on the CPU side: an indexed triangle list, reordered at import time for the GPU (see optimize).
+    // The LODs share the vertices, their triangles follow each other in the indices.
+    class MeshData
+    {
+    public:
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices; ///< three per triangle
+        std::vector<MeshLod> lods; ///< from the finest to the coarsest, empty if all the indices are a single LOD
+    public:
+        ///< Reorder the triangles for the post transform vertex cache then for overdraw, and the vertices in order of first use
+        void optimize(float overdraw_threshold = 1.05f);
+        ///< Reorder the triangles so that they reuse the recently transformed vertices (Forsyth's linear speed algorithm)
+        void optimize_vertex_cache();
+        ///< Split the triangles (in vertex cache order) in clusters, and draw the outward facing clusters first so that they occlude the others
+        ///< (Sander et al. 2007). 'threshold' is how much the vertex cache miss ratio can degrade to make smaller clusters.
+        void optimize_overdraw(float threshold = 1.05f);
+        ///< Reorder the vertices in order of first use by the triangles, and remove the unused ones
+        void optimize_vertex_fetch();
+        ///< Returns the triangles of the first LOD simplified by edge collapses of least quadric error (Garland and Heckbert 1997),
+        ///< until there are at most 'target_index_count' indices or the quadric error of the next collapse (a root mean square distance to
+        ///< the planes of the collapsed triangles, which underestimates the largest deviation) exceeds 'max_error'.
+        ///< The vertices are collapsed onto existing ones, so the result indexes the same vertices. The vertices on borders only move along the borders,
+        ///< and the vertices on attribute seams are kept. 'result_error' is set, if not nullptr, to the maximum distance from the vertices and
+        ///< triangle centers of the first LOD to the result.
+        std::vector<uint32_t> simplify(size_t target_index_count, float max_error, float* result_error = nullptr) const;
+        ///< Append up to 'max_lods' - 1 simplified LODs, each with 'reduction' times the triangles of the previous one, and fill 'lods'.
+        ///< Stops when the measured error (see simplify) would exceed 'max_error' or the simplification stalls. To call after optimize: the LODs are reordered the same way.
+        void generate_lods(unsigned int max_lods = 6, float reduction = 0.5f, float max_error = 1e30f);
+        ///< Split the triangles of the first LOD in meshlets of at most 'max_vertices' (256 at most) vertices and 'max_triangles' triangles.
+        ///< The triangles are taken in order, so they should be ordered for the vertex cache beforehand (see optimize) for the meshlets to be compact.
+        MeshletData build_meshlets(unsigned int max_vertices = 64, unsigned int max_triangles = 124) const;
+        ///< Returns the vertices quantized to a third of their size, and sets the bounds to decode them.
+        ///< Positions and uvs keep 16 bits relative to their bounds, normals and tangents 8 bits per component in octahedral encoding.
+        std::vector<QuantizedVertex> quantize(QuantizationBounds& bounds) const;
+        ///< Average number of vertices transformed per triangle with a FIFO post transform cache (between 0.5 and 3, lower is better)
+        float acmr(unsigned int cache_size = 16) const;
+    public:
+        ///< Octahedral encoding of a unit vector to two snorm values: the vector is projected on the octahedron |x|+|y|+|z| = 1,
+        ///< whose lower half is folded over the upper one. The rounding minimizing the angular error is chosen.
+        static void _encode_octahedral(const float* vector, int8_t* encoded);
+        static void _decode_octahedral(const int8_t* encoded, float* vector);
+        ///< Quantize a value in [offset, offset + scale] to an unorm
+        static uint16_t _quantize_unorm16(float value, float offset, float scale);
+    public:
+        // FIFO vertex cache simulation. A vertex is in the cache if it was transformed less than 'size' transforms ago.
+        struct FifoCache
+        {
+            std::vector<uint32_t> timestamps; // of the last transform of each vertex
+            uint32_t size;
+            uint32_t time;
+            FifoCache(size_t n_vertices, uint32_t cache_size);
+            ///< Returns the number of vertices of the triangle that had to be transformed
+            unsigned int triangle(const uint32_t* triangle);
+            ///< Empty the cache
+            void reset();
+        };
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <GameEngine/multithreading/JobCounter.hpp>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace GameEngine
+{
+    // Device wide caches of the Vulkan objects described by their creation state: pipeline layouts, render passes, samplers and pipelines.
+    // Identical states share a single object, created on the first request and destroyed with the cache.
+    // Lookups are hash table finds under a shared lock, so they can be done from any thread for each draw.
+    class ObjectCache
+    {
+    public:
+        ObjectCache() = delete;
+        ObjectCache(VkDevice device);
+        ObjectCache(const ObjectCache& other) = delete;
+        ~ObjectCache();
+    public:
+        ///< Returns a pipeline layout with the given set layouts and push constant ranges
+        VkPipelineLayout pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants = {});
+        ///< Returns a render pass with the given state
+        VkRenderPass render_pass(const RenderPassState& state);
+        ///< Returns a sampler with the given creation info (whose pNext must be nullptr)
+        VkSampler sampler(const VkSamplerCreateInfo& info);
+        ///< Returns a graphics or compute pipeline with the given state (compiled on the calling thread if it is not in the cache yet)
+        VkPipeline pipeline(const PipelineState& state);
+        ///< Returns the pipeline with the given state if it is already compiled, or VK_NULL_HANDLE
+        VkPipeline find_pipeline(const PipelineState& state);
+        ///< Compile the pipelines of the given states in background jobs (one per state). If counter is not null, it counts the unfinished compilations.
+        ///< Used to compile the commonly used shader variants ahead of time, while find_pipeline lets the renderer skip (or replace) draws whose pipeline is not ready.
+        ///< The states failing to compile are skipped (their error is printed), and are never found by find_pipeline.
+        void precompile(const std::vector<PipelineState>& states, JobCounter* counter = nullptr);
+        ///< Returns the states of the cached pipelines built from the given shader module
+        std::vector<PipelineState> pipelines_using(VkShaderModule module);
+        ///< Remove the pipelines built from the given shader module from the cache (when the module is replaced).
+        ///< They are destroyed once the frames in flight are done with them.
+        void evict_pipelines(VkShaderModule module);
+        ///< Destroy a shader module once the frames in flight are done with the pipelines built from it
+        void retire(VkShaderModule module);
+    public:
+        ///< An object destroyed once enough frames began since it was retired
+        struct Retired
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            VkShaderModule module = VK_NULL_HANDLE;
+            unsigned int frames = 0; // number of frames begun since it was retired
+        };
+    public:
+        struct PipelineLayoutKey
+        {
+            std::vector<VkDescriptorSetLayout> set_layouts;
+            std::vector<VkPushConstantRange> push_constants;
+            bool operator==(const PipelineLayoutKey& other) const;
+        };
+        struct SamplerKey
+        {
+            VkSamplerCreateInfo info;
+            bool operator==(const SamplerKey& other) const;
+        };
+        struct KeyHash
+        {
+            size_t operator()(const PipelineLayoutKey& key) const;
+            size_t operator()(const SamplerKey& key) const;
+            size_t operator()(const RenderPassState& key) const;
+            size_t operator()(const PipelineState& key) const;
+        };
+        VkDevice _device;
+        VkPipelineCache _vk_pipeline_cache = VK_NULL_HANDLE; // lets the driver reuse compiled shader code between pipelines
+        std::shared_mutex _layouts_mutex;
+        std::unordered_map<PipelineLayoutKey, VkPipelineLayout, KeyHash> _pipeline_layouts;
+        std::shared_mutex _render_passes_mutex;
+        std::unordered_map<RenderPassState, VkRenderPass, KeyHash> _render_passes;
+        std::shared_mutex _samplers_mutex;
+        std::unordered_map<SamplerKey, VkSampler, KeyHash> _samplers;
+        std::shared_mutex _pipelines_mutex;
+        std::unordered_map<PipelineState, VkPipeline, KeyHash> _pipelines;
+        std::mutex _retired_mutex;
+        std::vector<Retired> _retired;
+        unsigned int _n_swap_chains = 0; // the frames of each swap chain age the retired objects
+    public:
+        ///< Age the retired objects by a frame, and destroy the ones that no frame in flight can use anymore.
+        ///< Called by each swap chain once it waited for the frame it begins.
+        void _begin_frame(unsigned int max_frames_in_flight);
+        ///< Find the object of a key, or create it with 'create' under an exclusive lock
+        template<typename Key, typename Object, typename Create>
+        static Object _find_or_create(std::shared_mutex& mutex, std::unordered_map<Key, Object, KeyHash>& objects, const Key& key, Create create)
+        {
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                typename std::unordered_map<Key, Object, KeyHash>::iterator it = objects.find(key);
+                if (it != objects.end())
+                {
+                    return it->second;
+                }
+            }
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            // Another thread might have created it in the meantime
+            typename std::unordered_map<Key, Object, KeyHash>::iterator it = objects.find(key);
+            if (it != objects.end())
+            {
+                return it->second;
+            }
+            Object object = create();
+            objects.emplace(key, object);
+            return object;
+        }
+        VkPipeline _create_graphics_pipeline(const PipelineState& state);
+        VkPipeline _create_compute_pipeline(const PipelineState& state);
+        // The returned info points to 'specialization', which is filled if the stage has specialization constants
+        static VkPipelineShaderStageCreateInfo _stage_info(const ShaderStage& stage, VkSpecializationInfo& specialization);
+    };
+}
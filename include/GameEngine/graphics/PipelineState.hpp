@@ -0,0 +1,57 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace GameEngine
+{
+    ///< A shader stage of a pipeline
+    struct ShaderStage
+    {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        VkShaderModule module = VK_NULL_HANDLE;
+        std::string entry_point = "main";
+        std::vector<VkSpecializationMapEntry> specialization_entries; ///< specialization constants of the stage (see ShaderVariant)
+        std::vector<unsigned char> specialization_data; ///< values of the specialization constants, at the offsets of the entries
+    public:
+        bool operator==(const ShaderStage& other) const;
+    };
+
+    ///< Description of a render pass with a single subpass
+    struct RenderPassState
+    {
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<uint32_t> color_attachments; ///< indices of the attachments written as color by the subpass
+        int32_t depth_attachment = -1; ///< index of the depth attachment, or -1 if there is none
+    public:
+        bool operator==(const RenderPassState& other) const;
+        uint64_t hash() const;
+    };
+
+    ///< Full description of a pipeline. If the only stage is a compute stage, it describes a compute pipeline and the other fields are ignored.
+    ///< Viewport and scissor are always dynamic states.
+    struct PipelineState
+    {
+        std::vector<ShaderStage> stages;
+        std::vector<VkVertexInputBindingDescription> vertex_bindings;
+        std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        bool depth_test = true;
+        bool depth_write = true;
+        VkCompareOp depth_compare = VK_COMPARE_OP_LESS_OR_EQUAL;
+        bool alpha_blending = false; ///< if true the color attachments are blended with the source alpha
+        uint32_t color_attachment_count = 1;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+    public:
+        bool is_compute() const;
+        bool operator==(const PipelineState& other) const;
+        uint64_t hash() const;
+    };
+}
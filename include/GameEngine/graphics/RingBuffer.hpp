@@ -0,0 +1,73 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <atomic>
+#include <cstring>
+
+namespace GameEngine
+{
+    class GPU;
+
+    // A host visible buffer, mapped once for its whole lifetime, and split in one region per frame in flight.
+    // The per frame data (uniforms, dynamic vertices...) is sub-allocated linearly in the region of the current frame,
+    // and bound with dynamic offsets instead of creating and updating buffers for each draw.
+    class RingBuffer
+    {
+    public:
+        ///< A sub-allocation of the current frame's region
+        struct Allocation
+        {
+            void* data = nullptr; ///< where to write the data on the CPU side
+            VkBuffer buffer = VK_NULL_HANDLE; ///< the buffer to bind
+            uint32_t offset = 0; ///< offset in the buffer, to use as dynamic offset (or as offset when binding vertex/index buffers)
+            VkDeviceSize size = 0;
+        };
+    public:
+        RingBuffer() = delete;
+        ///< Create a buffer with 'frame_size' bytes per frame in flight, usable for the given usages.
+        ///< 'max_allocation_size' is the largest single allocation, and the range the buffer is bound with in descriptor sets.
+        RingBuffer(const GPU& gpu, VkDeviceSize frame_size, unsigned int max_frames_in_flight, VkDeviceSize max_allocation_size = 16*1024,
+                   VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        RingBuffer(const RingBuffer& other) = delete;
+        ~RingBuffer();
+    public:
+        ///< Reserve 'size' bytes in the current frame's region. The offset is aligned for dynamic uniform and storage buffers. Thread safe.
+        ///< Throws an error if 'size' is larger than max_allocation_size() or if the region is full.
+        Allocation allocate(VkDeviceSize size);
+        ///< Allocate and copy a value
+        template<typename T>
+        Allocation push(const T& value)
+        {
+            Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation;
+        }
+        ///< The buffer, for the descriptor sets of dynamic buffers: bound with a range of max_allocation_size(),
+        ///< which stays in the buffer whatever the dynamic offset of an allocation is.
+        VkBuffer buffer() const;
+        ///< Size of the region of a frame
+        VkDeviceSize frame_size() const;
+        ///< Largest size of a single allocation
+        VkDeviceSize max_allocation_size() const;
+        ///< Number of bytes allocated in the current frame's region
+        VkDeviceSize used() const;
+    public:
+        const GPU& gpu;
+        VkBuffer _vk_buffer = VK_NULL_HANDLE;
+        VkDeviceMemory _vk_memory = VK_NULL_HANDLE;
+        char* _mapped = nullptr;
+        bool _coherent = false; // if false the writes must be flushed
+        VkDeviceSize _alignment;
+        VkDeviceSize _frame_size;
+        VkDeviceSize _max_allocation_size;
+        unsigned int _max_frames_in_flight;
+        unsigned int _frame_index = 0;
+        std::atomic<VkDeviceSize> _offset{0}; // in the current frame's region
+    public:
+        ///< Start allocating in the region of a frame. The GPU must be done with the previous use of the region.
+        void _begin_frame(unsigned int frame_index);
+        ///< Make the writes of the current frame visible to the GPU, before submitting the frame
+        void _flush();
+    };
+}
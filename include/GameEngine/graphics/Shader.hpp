@@ -1,9 +1,11 @@
 #pragma once
 #include "GPU.hpp"
+#include "ShaderReflection.hpp"
 #include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/utilities/MappedFile.hpp>
+#include <GameEngine/utilities/Archive.hpp>
 #include <vector>
 #include <string>
-#include <fstream>
 
 namespace GameEngine
 {
@@ -11,16 +13,21 @@ namespace GameEngine
     {
     public:
         Shader() = delete;
-        Shader(const Shader& other);
+        Shader(const Shader& other) = delete;
+        ///< Create the shader from a SPIR-V file, read in place from a memory mapping
         Shader(const GPU& gpu, const std::string& file_path);
         Shader(const GPU& gpu, const std::vector<unsigned char>& code);
+        ///< Create the shader from a SPIR-V file of an archive (read in place if it is stored uncompressed)
+        Shader(const GPU& gpu, const Archive& archive, const std::string& path);
         ~Shader();
     public:
         const GPU& gpu;
-        VkShaderModule _vk_shader;
+        ShaderReflection reflection; ///< interface of the shader, read from its code
+        VkShaderModule _vk_shader = VK_NULL_HANDLE; // retired to the object cache on destruction, with the pipelines built from it
     public:
+        ///< Returns the content of a binary file. Throws an error with the path if it can't be read.
         static std::vector<unsigned char> load_binary(const std::string& file_path);
     protected:
-        void _set_vk_shader(const std::vector<unsigned char>& code);
+        void _set_vk_shader(const unsigned char* code, size_t size);
     };
 }
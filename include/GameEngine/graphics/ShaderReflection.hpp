@@ -0,0 +1,92 @@
+#pragma once
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
+
+namespace GameEngine
+{
+    class GPU;
+    class DescriptorSets;
+    struct PipelineState;
+
+    // Interface of SPIR-V shader modules (entry points, descriptor bindings, push constants, vertex inputs and specialization constants),
+    // read from the SPIR-V code. The reflections of the stages of a pipeline can be merged to build its pipeline layout.
+    class ShaderReflection
+    {
+    public:
+        struct EntryPoint
+        {
+            std::string name;
+            VkShaderStageFlagBits stage;
+        };
+        struct Binding
+        {
+            uint32_t set;
+            uint32_t binding;
+            VkDescriptorType type;
+            uint32_t count; ///< number of descriptors (0 for an unbounded array)
+            VkShaderStageFlags stages;
+            std::string name;
+        };
+        struct VertexInput
+        {
+            uint32_t location;
+            VkFormat format;
+            std::string name;
+        };
+        struct SpecializationConstant
+        {
+            uint32_t id; ///< constant_id in GLSL
+            uint32_t size; ///< in bytes (4 for booleans)
+            uint64_t default_value;
+            std::string name;
+        };
+    public:
+        ShaderReflection();
+        ///< Reflect a SPIR-V module
+        ShaderReflection(const std::vector<unsigned char>& code);
+        ///< Reflect a SPIR-V module of 'size' bytes. The code is read in place if it is 4 bytes aligned.
+        ShaderReflection(const unsigned char* code, size_t size);
+        ~ShaderReflection();
+    public:
+        std::vector<EntryPoint> entry_points;
+        std::vector<Binding> bindings; ///< sorted by set, then binding
+        std::vector<VkPushConstantRange> push_constants; ///< one range per stage using push constants
+        std::vector<VertexInput> vertex_inputs; ///< sorted by location (only for vertex shaders)
+        std::vector<SpecializationConstant> specialization_constants; ///< sorted by id
+    public:
+        ///< Stages of all the entry points
+        VkShaderStageFlags stages() const;
+        ///< Add the interface of another stage. Bindings used by both must have the same type and count.
+        void merge(const ShaderReflection& other);
+        ///< Returns the (cached) pipeline layout matching the bindings and push constants.
+        ///< The sets with an index lower than fixed_set_layouts.size() use the given layouts instead (for example the bindless set).
+        ///< If dynamic_buffers is true, uniform and storage buffers are declared dynamic (to be used with the ring buffer).
+        VkPipelineLayout pipeline_layout(const GPU& gpu, DescriptorSets& descriptor_sets,
+                                         const std::vector<VkDescriptorSetLayout>& fixed_set_layouts = {}, bool dynamic_buffers = false) const;
+        ///< Fill the vertex bindings and attributes of a pipeline state for the vertex inputs, interleaved in location order in a single buffer bound at 'binding'.
+        ///< 'formats' overrides the reflected format of some locations, for attributes stored packed (normalized integers...) and read as floats.
+        void vertex_input(PipelineState& state, const std::map<uint32_t, VkFormat>& formats = {}, uint32_t binding = 0) const;
+    public:
+        // What is known of a SPIR-V id
+        struct Id
+        {
+            uint32_t opcode = 0; // instruction that defined the id
+            std::vector<uint32_t> operands; // operands of the defining instruction (without result type and result id)
+            uint32_t type = 0; // result type
+            std::string name;
+            std::map<uint32_t, uint32_t> decorations; // decoration -> first literal (or 1)
+            std::map<uint32_t, std::map<uint32_t, uint32_t>> member_decorations; // member -> decoration -> first literal
+        };
+        void _parse(const uint32_t* words, size_t n_words);
+        // size in bytes of a type, for push constant blocks and specialization constants
+        uint32_t _type_size(const std::vector<Id>& ids, uint32_t type) const;
+        VkFormat _vertex_format(const std::vector<Id>& ids, uint32_t type) const;
+        // size in bytes of a vertex attribute format, 0 if it is not supported
+        static uint32_t _format_size(VkFormat format);
+        bool _descriptor_type(const std::vector<Id>& ids, uint32_t type, uint32_t storage_class, VkDescriptorType& descriptor_type, uint32_t& count) const;
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <GameEngine/graphics/Shader.hpp>
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace GameEngine
+{
+    // A shader with values for its specialization constants (declared with 'layout(constant_id = N) const' in GLSL).
+    // The driver compiles each variant as if the values were literals, folding the branches and loops depending on them,
+    // so a single SPIR-V file serves all the variants. The stage returned by 'stage' keys the pipelines by variant in the ObjectCache.
+    // Constants not set keep the default value written in the shader.
+    class ShaderVariant
+    {
+    public:
+        ShaderVariant() = delete;
+        ShaderVariant(const Shader& shader);
+        ~ShaderVariant();
+    public:
+        const Shader& shader;
+    public:
+        ///< Set the value of the specialization constant of the given id. Throws if the shader has no such constant, or if its size differs.
+        template<typename T>
+        ShaderVariant& set(uint32_t id, const T& value)
+        {
+            _set(id, &value, sizeof(T));
+            return *this;
+        }
+        ///< Set a boolean specialization constant (stored as a VkBool32)
+        ShaderVariant& set(uint32_t id, bool value);
+        ///< Set the value of the specialization constant of the given name
+        template<typename T>
+        ShaderVariant& set(const std::string& name, const T& value)
+        {
+            return set(_id(name), value);
+        }
+        ///< Returns the pipeline stage of the given entry point of the shader, specialized with the values set
+        ShaderStage stage(size_t entry_point = 0) const;
+        ///< Returns a hash of the values set
+        uint64_t hash() const;
+        bool operator==(const ShaderVariant& other) const;
+    public:
+        std::map<uint32_t, std::vector<unsigned char>> _values; // constant id -> value bytes. Ordered, so that equal variants have equal stages.
+    public:
+        void _set(uint32_t id, const void* value, size_t size);
+        uint32_t _id(const std::string& name) const;
+    };
+}
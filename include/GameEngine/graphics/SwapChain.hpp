@@ -1,9 +1,16 @@
 #pragma once
 #include <GameEngine/utilities/External.hpp>
 #include <GameEngine/utilities/Macro.hpp>
+#include <GameEngine/graphics/DynamicResolution.hpp>
+#include <GameEngine/graphics/CommandPools.hpp>
+#include <GameEngine/graphics/FrameAllocators.hpp>
+#include <GameEngine/graphics/RingBuffer.hpp>
+#include <GameEngine/graphics/DescriptorSets.hpp>
+#include <GameEngine/graphics/BindlessResources.hpp>
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <optional>
 
 namespace GameEngine
 {
@@ -12,18 +19,79 @@ namespace GameEngine
 
     class SwapChain
     {
+    public:
+        ///< Synchronization objects and command buffer of a frame being rendered
+        struct Frame
+        {
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE; // primary command buffer, allocated from the command pools each frame
+            VkSemaphore image_available = VK_NULL_HANDLE; // signaled when the swap chain image can be written to
+            VkSemaphore render_finished = VK_NULL_HANDLE; // signaled when the image can be presented
+            VkFence in_flight = VK_NULL_HANDLE; // signaled when the GPU is done with the frame
+            VkCommandBuffer compute_command_buffer = VK_NULL_HANDLE; // recorded for the async compute queue this frame, if any
+            VkSemaphore compute_finished = VK_NULL_HANDLE; // signaled when the async compute work of the frame is done
+        };
     public:
         SwapChain() = delete;
         SwapChain(const GPU& gpu, const Window& window);
         ~SwapChain();
+    public:
+        ///< Number of frames that can be recorded by the CPU while the GPU is still rendering the previous ones (1 in low latency mode)
+        static const unsigned int max_frames_in_flight = 2;
     public:
         const GPU& gpu;
-        VkSwapchainKHR _swap_chain;
+        ///< Settings and state of the dynamic resolution of the rendered scene
+        DynamicResolution dynamic_resolution;
+        ///< Per frame and per thread command pools of the graphics queue, reset when a frame begins
+        CommandPools command_pools;
+        ///< Per frame and per thread linear allocators for temporary CPU data, reset when a frame begins
+        FrameAllocators frame_allocators;
+        ///< Persistently mapped buffer for the uniforms and dynamic vertices of the frame, with a region per frame in flight
+        RingBuffer dynamic_buffer;
+        ///< Cached descriptor set layouts and immutable sets, and per frame descriptor pools reset when a frame begins
+        DescriptorSets descriptor_sets;
+        ///< Global resource arrays indexed from the shaders, or nullptr if the GPU does not support bindless resources
+        std::unique_ptr<BindlessResources> bindless;
+        ///< Per frame and per thread command pools of the async compute queue, or nullptr if the GPU has no compute queue besides the graphics queue
+        std::unique_ptr<CommandPools> compute_command_pools;
+    public:
+        ///< Returns the command buffer of the current frame for the async compute queue, begun on the first call of the frame.
+        ///< It is submitted before the frame's rendering, which waits for it before its indirect draws. Must be called from a single thread.
+        ///< Returns VK_NULL_HANDLE if there is no async compute queue (the work is then recorded on the graphics queue) or no frame is begun.
+        VkCommandBuffer async_compute_commands();
+    public:
+        VkSwapchainKHR _swap_chain = VK_NULL_HANDLE;
         std::vector<VkImage> _vk_images;
         VkFormat _image_format;
+        VkExtent2D _extent;
+        VkPresentModeKHR _present_mode;
+        bool _can_upscale = false; // true if the swap chain images support the dynamic resolution upscaling
+        std::vector<Frame> _frames;
+        unsigned int _current_frame = 0;
+        std::optional<uint32_t> _image_index; // index of the acquired swap chain image, if a frame was begun
+        uint64_t _present_id = 0; // id of the last presented image (0 if none was presented with the current swap chain)
+        double _presented_input_time = -1.; // time of the first input event accounted for by the last presented image (-1 if none)
+        PFN_vkWaitForPresentKHR _vk_wait_for_present = nullptr;
+        bool _needs_recreation = false; // true if the swap chain couldn't be (re)created while the window was minimized
+    public:
+        ///< Recreate the swap chain (after a resize, or a change of the vsync or low latency settings)
+        void _recreate(const Window& window);
+        ///< Wait for the resources of the next frame to be available, and acquire a swap chain image
+        void _begin_frame(const Window& window);
+        ///< Render to the acquired image and present it
+        void _end_frame(const Window& window);
     protected:
-        VkSurfaceFormatKHR _choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
-        VkPresentModeKHR _choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes);
+        void _create_swap_chain(const Window& window, VkSwapchainKHR old_swap_chain);
+        void _create_frames(unsigned int n_frames);
+        void _destroy_frames();
+        void _record_commands(VkCommandBuffer command_buffer, unsigned int frame_index, VkImage image);
+        // record the rendering of the scene in an image (left in the TRANSFER_DST_OPTIMAL layout)
+        void _record_scene(VkCommandBuffer command_buffer, VkImage image, VkExtent2D extent);
+        VkSurfaceFormatKHR _choose_swap_surface_format(const ArenaVector<VkSurfaceFormatKHR>& available_formats);
+        VkPresentModeKHR _choose_swap_present_mode(const ArenaVector<VkPresentModeKHR>& available_present_modes, bool vsync);
         VkExtent2D _choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, const Window& window);
+        // returns false if the window surface has an empty extent (minimized window)
+        bool _surface_has_area(const Window& window);
+        // update the input to display latency statistic with a frame that was just displayed
+        void _record_latency(const Window& window, double input_time);
     };
-}
\ No newline at end of file
+}
@@ -1,2 +1,21 @@
 #include "GPU.hpp"
 #include "SwapChain.hpp"
+#include "CommandPools.hpp"
+#include "FrameAllocators.hpp"
+#include "RingBuffer.hpp"
+#include "DescriptorAllocator.hpp"
+#include "DescriptorSets.hpp"
+#include "BindlessResources.hpp"
+#include "PipelineState.hpp"
+#include "ObjectCache.hpp"
+#include "ShaderReflection.hpp"
+#include "ShaderVariant.hpp"
+#include "DrawLists.hpp"
+#include "HostAllocator.hpp"
+#include "HotReload.hpp"
+#include "AssetManager.hpp"
+#include "Buffer.hpp"
+#include "MeshData.hpp"
+#include "Mesh.hpp"
+#include "LodSelection.hpp"
+#include "ClusteredMesh.hpp"
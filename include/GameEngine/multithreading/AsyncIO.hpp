@@ -0,0 +1,132 @@
+#pragma once
+#include <GameEngine/multithreading/JobCounter.hpp>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace GameEngine
+{
+    // A file opened for asynchronous reads
+    class AsyncFile
+    {
+    public:
+        AsyncFile() = delete;
+        ///< Open a file. With 'direct', reads bypass the OS page cache (O_DIRECT, FILE_FLAG_NO_BUFFERING) if the file system supports it:
+        ///< offsets, sizes and destinations must then be multiples of direct_alignment.
+        AsyncFile(const std::string& file_path, bool direct = false);
+        AsyncFile(const AsyncFile& other) = delete;
+        ~AsyncFile();
+    public:
+        static constexpr size_t direct_alignment = 4096;
+        ///< Returns the size of the file in bytes
+        uint64_t size() const;
+        ///< Returns true if the reads bypass the page cache
+        bool direct() const;
+        const std::string& path() const;
+    public:
+        std::string _path;
+        uint64_t _size = 0;
+        bool _direct = false;
+        #ifdef _WIN32
+        void* _handle = nullptr;
+        #else
+        int _fd = -1;
+        #endif
+    };
+
+    // A read in flight, returned by AsyncIO::read
+    struct AsyncRead
+    {
+        JobCounter counter; ///< reaches zero once the read completed and its callback returned
+        int64_t result = 0; ///< number of bytes read, or a negative error code (-errno). Valid once the counter reached zero.
+        ///< Wait for the read (a job is suspended meanwhile, see JobSystem::wait), and return its result
+        int64_t wait();
+        ///< Returns true if the read completed and its callback returned
+        bool done() const;
+        const AsyncFile* _file = nullptr;
+        uint64_t _offset = 0;
+        size_t _size = 0;
+        void* _destination = nullptr;
+        std::function<void(AsyncRead&)> _callback;
+        JobCounter* _group = nullptr;
+        std::shared_ptr<AsyncRead> _self; // keeps the read alive while it is in flight
+        size_t _done = 0; // bytes read so far, the read is submitted again after a short read
+    };
+
+    // Asynchronous file reads: io_uring on Linux (with plain system calls, no liburing), or a pool of threads doing blocking positioned reads
+    // on other systems and where io_uring is unavailable. Reads are queued, and submitted together to the kernel by 'flush' (one system call for the batch).
+    // Completion runs the read's callback as a job of the JobSystem, then decrements the read's counter and the optional group counter,
+    // so that jobs can wait for reads without blocking their thread.
+    class AsyncIO
+    {
+    public:
+        ///< Start the I/O backend with room for 'queue_depth' reads in flight. Does nothing if already initialized.
+        static void initialize(unsigned int queue_depth = 256, unsigned int n_fallback_threads = 4);
+        ///< Wait for the reads in flight, then stop the backend
+        static void terminate();
+        ///< Queue a read of 'size' bytes at 'offset' of 'file' into 'destination', which must stay valid until the read completed.
+        ///< If 'group' is not null it is incremented, and decremented once the read completed (to wait for a batch of reads).
+        ///< Reads of any size are allowed: they are done in requests of at most _max_request_size bytes, and short reads are continued.
+        static std::shared_ptr<AsyncRead> read(const AsyncFile& file, uint64_t offset, size_t size, void* destination,
+                                               const std::function<void(AsyncRead&)>& callback = nullptr, JobCounter* group = nullptr);
+        ///< Submit the queued reads
+        static void flush();
+        ///< Returns true if the io_uring backend is used
+        static bool uses_io_uring();
+        ///< Round a size up to a multiple of AsyncFile::direct_alignment
+        static size_t aligned_size(size_t size);
+    public:
+        static constexpr size_t _max_request_size = 0x7FFFF000; // MAX_RW_COUNT of Linux, also the largest read that fits a DWORD on Windows
+        static std::mutex _initialization_mutex;
+        static std::atomic<bool> _initialized;
+        static std::atomic<bool> _stopping;
+        static std::mutex _queue_mutex;
+        static std::vector<AsyncRead*> _queued; // reads waiting for the next flush
+        static std::atomic<int> _in_flight;
+        // thread pool fallback
+        static std::vector<std::thread> _threads;
+        static std::deque<AsyncRead*> _pending;
+        static std::condition_variable _pending_cv;
+        #ifdef __linux__
+        // io_uring rings, mapped from the kernel
+        struct Uring
+        {
+            int fd = -1;
+            unsigned int entries = 0;
+            unsigned int* sq_head = nullptr;
+            unsigned int* sq_tail = nullptr;
+            unsigned int* sq_mask = nullptr;
+            unsigned int* sq_array = nullptr;
+            void* sqes = nullptr;
+            unsigned int* cq_head = nullptr;
+            unsigned int* cq_tail = nullptr;
+            unsigned int* cq_mask = nullptr;
+            void* cqes = nullptr;
+            void* sq_ring = nullptr;
+            size_t sq_ring_size = 0;
+            void* cq_ring = nullptr; // same as sq_ring if the kernel maps both rings at once
+            size_t cq_ring_size = 0;
+            size_t sqes_size = 0;
+        };
+        static Uring _uring;
+        static std::thread _completion_thread;
+        static bool _setup_uring(unsigned int queue_depth);
+        static void _destroy_uring();
+        // Write submission entries for the queued reads, and enter the kernel. Called with _queue_mutex locked.
+        static void _submit_uring();
+        static void _completion_loop();
+        #endif
+        static void _fallback_loop();
+        // Perform a read with a blocking system call, and return the number of bytes read or -errno
+        static int64_t _blocking_read(const AsyncRead& read);
+        static void _complete(AsyncRead* read, int64_t result);
+    };
+}
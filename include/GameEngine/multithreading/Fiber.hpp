@@ -0,0 +1,45 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <cstddef>
+#ifndef _WIN32
+#include <ucontext.h>
+#endif
+
+namespace GameEngine
+{
+    struct Job;
+
+    // A user mode execution context with its own stack (Windows fibers, or ucontext on POSIX systems).
+    // Switching between fibers is cooperative: a fiber only stops running when it switches to another one.
+    class Fiber
+    {
+    public:
+        ///< Wrap the calling thread's own context, so that fibers can switch back to it
+        Fiber();
+        ///< Create a fiber that runs 'entry' on its own stack once switched to. 'entry' must never return.
+        Fiber(const std::function<void()>& entry, size_t stack_size = 256*1024);
+        Fiber(const Fiber& other) = delete;
+        ~Fiber();
+    public:
+        ///< Save the calling context into 'from' (which must be the running fiber) and resume 'to'.
+        ///< Returns once another fiber switched back to 'from', possibly from another thread.
+        static void _switch(Fiber& from, Fiber& to);
+    public:
+        std::function<void()> _entry;
+        Job* _job = nullptr; // job running on the fiber, if it is used by the job system
+        #ifdef _WIN32
+        void* _handle = nullptr;
+        bool _thread_converted = false; // true if the thread was converted to a fiber by this object
+        #else
+        ucontext_t _context;
+        std::unique_ptr<char[]> _stack;
+        #endif
+    protected:
+        #ifdef _WIN32
+        static void __stdcall _start(void* fiber);
+        #else
+        static void _start(unsigned int high, unsigned int low);
+        #endif
+    };
+}
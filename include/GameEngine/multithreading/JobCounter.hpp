@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace GameEngine
+{
+    struct Job;
+
+    // Counts the unfinished jobs of a group. Jobs can be scheduled to start once a counter reaches zero.
+    class JobCounter
+    {
+    public:
+        JobCounter(int value = 0);
+        JobCounter(const JobCounter& other) = delete;
+        ~JobCounter();
+    public:
+        ///< Returns true if the counter reached zero, and no thread is still updating it (so it can be destroyed)
+        bool done() const;
+        ///< Current value of the counter
+        int value() const;
+    public:
+        std::atomic<int> _value;
+        std::atomic<int> _updating; // number of threads currently decrementing the counter
+        std::mutex _mutex;
+        std::vector<Job*> _waiting_jobs; // jobs to schedule when the counter reaches zero
+    public:
+        void _increment(int n = 1);
+        ///< Decrement the counter. If it reaches zero, the waiting jobs are moved to 'ready_jobs'.
+        void _decrement(std::vector<Job*>& ready_jobs);
+        ///< Add a job to start when the counter reaches zero. Returns false if the counter is already at zero (the job was not added).
+        bool _add_waiting_job(Job* job);
+    };
+}
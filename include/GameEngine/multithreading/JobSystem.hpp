@@ -0,0 +1,130 @@
+#pragma once
+#include <GameEngine/multithreading/WorkStealingDeque.hpp>
+#include <GameEngine/multithreading/JobCounter.hpp>
+#include <GameEngine/multithreading/Fiber.hpp>
+#include <GameEngine/utilities/External.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+namespace GameEngine
+{
+    struct Job;
+
+    // Resumes of the suspended jobs bound to a thread (see JobSystem::bind_to_thread), only run by that thread
+    struct BoundJobs
+    {
+        std::mutex mutex;
+        std::vector<Job*> resumes;
+        std::atomic<int> n_resumes{0};
+        std::atomic<int> n_suspended{0}; // bound jobs suspended and not resumed yet
+    };
+
+    ///< A function to run on any thread of the job system
+    struct Job
+    {
+        std::function<void()> function;
+        JobCounter* counter = nullptr; // decremented when the job is done
+        Fiber* fiber = nullptr; // if not null, the job resumes this suspended fiber instead of calling 'function'
+        BoundJobs* bound_thread = nullptr; // if not null, the job must run on the thread owning these jobs
+    };
+
+    // Runs jobs on a worker thread per core. Each worker (and the thread that initialized the job system) has its own work stealing deque,
+    // idle workers steal from the others. Threads waiting for a job counter run jobs in the meantime.
+    // Jobs run on fibers: a job waiting for a counter or a fence is suspended without blocking its thread, and resumed later by any thread
+    // (or by the same thread, for the jobs using per thread state, see bind_to_thread).
+    class JobSystem
+    {
+    public:
+        // What a fiber asks the thread that was running it to do, once it switched back to it
+        enum FiberAction {NONE, FINISHED, WAIT_COUNTER, WAIT_FENCE};
+        // State of a thread running jobs. It is only accessed through _thread_state(), as fibers can move between threads.
+        struct ThreadState
+        {
+            int slot = -1; // index of the thread's deque, or -1 if it has none
+            std::unique_ptr<Fiber> context; // the thread's own context, switched back to by the fibers
+            Fiber* current_fiber = nullptr; // fiber being run by the thread, or nullptr
+            FiberAction action = NONE;
+            JobCounter* wait_counter = nullptr;
+            VkDevice wait_device = VK_NULL_HANDLE;
+            VkFence wait_fence = VK_NULL_HANDLE;
+            BoundJobs bound_jobs;
+        };
+        // A suspended fiber to resume once its fence is signaled
+        struct FenceWait
+        {
+            VkDevice device;
+            VkFence fence;
+            Fiber* fiber;
+        };
+    public:
+        ///< Start the worker threads (one per core, minus the calling thread, if n_workers is 0). Does nothing if already initialized.
+        static void initialize(unsigned int n_workers = 0);
+        ///< Stop the worker threads. Jobs not started yet are discarded.
+        static void terminate();
+        ///< Number of threads running jobs (the workers and the thread that initialized the job system)
+        static unsigned int n_threads();
+        ///< Schedule a function. If counter is not null it is incremented, and decremented once the function returned.
+        ///< If dependency is not null, the function only starts once the dependency counter reached zero.
+        static void submit(const std::function<void()>& function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+        ///< Wait until the counter reaches zero. Inside a job the job is suspended, otherwise the calling thread runs jobs in the meantime.
+        static void wait(JobCounter& counter);
+        ///< Wait until the fence is signaled. Inside a job the job is suspended, otherwise the calling thread runs jobs in the meantime.
+        static void wait(VkDevice device, VkFence fence);
+        ///< Decrement a counter for work done outside of the job system (incremented with JobCounter::_increment), starting the jobs waiting for it
+        static void decrement(JobCounter& counter);
+        ///< Returns true if called from a job
+        static bool in_job();
+        ///< Keep the running job on the calling thread until it finishes: after a wait it is resumed by the same thread.
+        ///< Called by the users of per thread state (see Utilities::thread_index) that the job keeps using across waits.
+        ///< A thread outside of the workers doesn't return from a wait while jobs bound to it are still suspended. Does nothing outside a job.
+        static void bind_to_thread();
+        ///< Call function(chunk_begin, chunk_end) over chunks covering [begin, end) in parallel, and wait for them.
+        ///< The range is split in halves while other threads might be idle, down to chunks of 'min_chunk' elements (automatic if 0).
+        static void parallel_for(size_t begin, size_t end, const std::function<void(size_t, size_t)>& function, size_t min_chunk = 0);
+    public:
+        static std::mutex _initialization_mutex;
+        static std::atomic<bool> _initialized; // set once the workers started, so the fast path of initialize sees them
+        static std::atomic<bool> _stopping;
+        static std::vector<std::thread> _workers;
+        static std::vector<std::unique_ptr<WorkStealingDeque<Job>>> _deques; // index 0 is the deque of the thread that initialized the job system
+        static std::mutex _injection_mutex;
+        static std::deque<Job*> _injected_jobs; // jobs submitted by threads without a deque
+        static std::atomic<int> _queued_jobs; // approximate number of jobs waiting to be run
+        static std::atomic<int> _sleeping_workers;
+        static std::mutex _sleep_mutex;
+        static std::condition_variable _wake_up;
+        static std::mutex _fiber_mutex;
+        static std::vector<std::unique_ptr<Fiber>> _fibers;
+        static std::vector<Fiber*> _free_fibers; // fibers not running or suspended in a job
+        static std::mutex _fence_mutex;
+        static std::vector<FenceWait> _fence_waits;
+        static std::atomic<int> _n_fence_waits;
+    public:
+        ///< State of the calling thread. Not inlined, so that the compiler can't reuse the address of another thread's state after a fiber moved.
+        NO_INLINE static ThreadState& _thread_state();
+        ///< Make a job available to the workers
+        static void _schedule(Job* job);
+        ///< Take a job from the calling thread's deque, or steal one. Returns nullptr if no job was found.
+        static Job* _find_job();
+        ///< Run a job on a fiber (or resume its suspended fiber), then handle what the fiber asked for when it switched back
+        static void _run(Job* job);
+        ///< Entry point of the fibers: runs the job assigned to the fiber, then switches back to the thread, forever
+        static void _fiber_loop();
+        ///< Suspend the running fiber, and let the thread handle 'action' once switched back to it
+        static void _suspend(ThreadState& state, FiberAction action);
+        static Fiber* _acquire_fiber();
+        ///< Schedule the fibers whose fence is signaled. Returns true if any was.
+        static bool _poll_fences();
+        static void _worker_loop(unsigned int slot);
+        ///< Delete the resumes of the jobs bound to the calling thread, once the job system is stopping
+        static void _discard_bound_jobs();
+        static void _parallel_for_range(size_t begin, size_t end, const std::function<void(size_t, size_t)>& function, size_t min_chunk, JobCounter& counter);
+    };
+}
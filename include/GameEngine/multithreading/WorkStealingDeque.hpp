@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace GameEngine
+{
+    // Chase-Lev work stealing deque of pointers (with the memory orderings of Lê et al. 2013).
+    // Only the owner thread can push and pop at the bottom, any thread can steal from the top.
+    template<typename T>
+    class WorkStealingDeque
+    {
+    protected:
+        // circular array whose capacity is a power of 2
+        struct Array
+        {
+            Array(int64_t _capacity) : capacity(_capacity), mask(_capacity-1), items(new std::atomic<T*>[_capacity]) {}
+            T* get(int64_t i) const {return items[i & mask].load(std::memory_order_acquire);}
+            void put(int64_t i, T* item) {items[i & mask].store(item, std::memory_order_release);}
+            int64_t capacity;
+            int64_t mask;
+            std::unique_ptr<std::atomic<T*>[]> items;
+        };
+    public:
+        WorkStealingDeque(int64_t capacity = 256)
+        {
+            _arrays.emplace_back(new Array(capacity));
+            _array.store(_arrays.back().get(), std::memory_order_relaxed);
+        }
+        WorkStealingDeque(const WorkStealingDeque& other) = delete;
+        ~WorkStealingDeque() {}
+    public:
+        ///< Push an item at the bottom (owner thread only)
+        void push(T* item)
+        {
+            int64_t b = _bottom.load(std::memory_order_relaxed);
+            int64_t t = _top.load(std::memory_order_acquire);
+            Array* array = _array.load(std::memory_order_relaxed);
+            if (b - t > array->capacity - 1)
+            {
+                array = _grow(array, t, b);
+            }
+            array->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        ///< Pop the most recently pushed item (owner thread only). Returns nullptr if the deque is empty.
+        T* pop()
+        {
+            int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+            Array* array = _array.load(std::memory_order_relaxed);
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = _top.load(std::memory_order_relaxed);
+            T* item = nullptr;
+            if (t <= b)
+            {
+                item = array->get(b);
+                if (t == b)
+                {
+                    // last item: race against the thieves
+                    if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        item = nullptr;
+                    }
+                    _bottom.store(b + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                _bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+        ///< Steal the oldest item (any thread). Returns nullptr if the deque is empty or if another thread won the race.
+        T* steal()
+        {
+            int64_t t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = _bottom.load(std::memory_order_acquire);
+            if (t < b)
+            {
+                Array* array = _array.load(std::memory_order_acquire);
+                T* item = array->get(t);
+                if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return nullptr;
+                }
+                return item;
+            }
+            return nullptr;
+        }
+        ///< Approximate number of items
+        int64_t size() const
+        {
+            int64_t b = _bottom.load(std::memory_order_relaxed);
+            int64_t t = _top.load(std::memory_order_relaxed);
+            return (b > t) ? b - t : 0;
+        }
+    protected:
+        // double the capacity. The previous arrays are kept alive as thieves might still be reading them.
+        Array* _grow(Array* array, int64_t t, int64_t b)
+        {
+            Array* bigger = new Array(array->capacity * 2);
+            for (int64_t i=t; i<b; i++)
+            {
+                bigger->put(i, array->get(i));
+            }
+            _arrays.emplace_back(bigger);
+            _array.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+    protected:
+        std::atomic<int64_t> _top{0};
+        std::atomic<int64_t> _bottom{0};
+        std::atomic<Array*> _array;
+        std::vector<std::unique_ptr<Array>> _arrays;
+    };
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "JobCounter.hpp"
+#include "Fiber.hpp"
+#include "JobSystem.hpp"
+#include "AsyncIO.hpp"
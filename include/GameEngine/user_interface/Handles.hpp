@@ -5,6 +5,7 @@
 #include <GameEngine/utilities/External.hpp>
 #include "Button.hpp"
 #include "WindowSettings.hpp"
+#include "Timer.hpp"
 
 namespace GameEngine
 {
@@ -22,6 +23,13 @@ namespace GameEngine
         std::string _window_title;
         bool _window_full_screen = false;
         bool _window_vsync = false;
+        bool _window_resized = false;
+        double _window_max_fps = 0.;
+        bool _window_low_latency = false;
+        Timer _frame_timer;
+        double _next_frame_time = 0.;
+        double _input_time = -1.; // time of the first input event since the last poll (-1 if there was none)
+        double _input_latency = -1.; // average delay between an input event and its display (-1 if not measured yet)
         double _mouse_x = 0;
         double _mouse_y = 0;
         double _mouse_dx = 0;
@@ -35,6 +43,7 @@ namespace GameEngine
         VkSurfaceKHR _vk_surface;
     public:
         void _set_unchanged();
+        void _record_input_time();
     public:
         static void _window_resize_callback(GLFWwindow* window, int width, int height);
         static void _mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
@@ -18,9 +18,16 @@ namespace GameEngine
         void reset_dt();
         //!< Reset the t and dt timers.
         void restart();
+        //!< Wait until t() reaches the given time in seconds. The OS scheduler is used while it is safe to, and the end of the wait is spent spinning for precision.
+        void sleep_until(double time);
     private:
         std::chrono::time_point<std::chrono::steady_clock> _start;
         std::chrono::time_point<std::chrono::steady_clock> _last;
+        // running average and variance of the measured duration of a 1ms OS sleep
+        double _sleep_mean = 0.002;
+        double _sleep_variance = 0.;
     protected:
+        // update the sleep duration statistics with a new measurement
+        void _record_sleep_duration(double duration);
     };
 }
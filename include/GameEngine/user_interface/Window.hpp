@@ -67,9 +67,23 @@ namespace GameEngine
         bool vsync() const;
         ///< Enables or disable vertical syncing
         void vsync(bool enabled);
+        ///< Returns the maximum number of frames displayed per second (0 if there is no limit)
+        double max_fps() const;
+        ///< Set the maximum number of frames displayed per second (0 to remove the limit)
+        void max_fps(double fps);
+        ///< Returns true if the low latency mode is enabled
+        bool low_latency() const;
+        ///< Enable or disable the low latency mode: a single frame is queued for display at a time, and the next frame starts when the previous one is displayed
+        void low_latency(bool enabled);
+        ///< Returns the average delay in seconds between an input event and the presentation of the first frame that accounts for it (-1 if not measured yet).
+        ///< It is measured up to the display of the image in low latency mode if the GPU supports VK_KHR_present_wait, and up to the present call otherwise.
+        double input_latency() const;
     public:
         const std::shared_ptr<Handles>& _get_state() const;
         const VkSurfaceKHR& _get_vk_surface() const;
+    protected:
+        ///< Wait until it's time to display the next frame, if the frame rate is limited
+        void _limit_frame_rate();
     protected:
         std::shared_ptr<Handles> _state; // This must be above keyboard and mouse in the class definition
     public:
@@ -26,6 +26,10 @@ namespace GameEngine
         bool transparent = false;
         ///< If true, the vsync of the window is enabled
         bool vsync = true;
+        ///< Maximum number of frames displayed per second (0 for no limit)
+        double max_fps = 0.;
+        ///< If true, a single frame is queued for display at a time, to minimize the input latency
+        bool low_latency = false;
         ///< Number of samples for the Multi Sample Anti Aliasing
         unsigned int anti_aliasing = 1;
     };
@@ -0,0 +1,123 @@
+#pragma once
+#include <GameEngine/utilities/MappedFile.hpp>
+#include <GameEngine/utilities/DerivedDataCache.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace GameEngine
+{
+    ///< Compression of a blob in an archive
+    enum ArchiveCompression : uint32_t
+    {
+        ARCHIVE_UNCOMPRESSED = 0,
+        ARCHIVE_LZ4 = 1 ///< compressed with Compression::compress
+    };
+
+    ///< First bytes of an archive file. All the offsets are from the start of the file, and all the values are little endian.
+    struct ArchiveHeader
+    {
+        char magic[8]; ///< "GEARCHIV"
+        uint32_t version;
+        uint32_t alignment; ///< alignment of the blobs, in bytes
+        uint32_t n_entries;
+        uint32_t n_buckets; ///< power of 2
+        uint64_t entries_offset; ///< table of contents: n_entries ArchiveEntry, sorted by path hash
+        uint64_t buckets_offset; ///< n_buckets+1 uint32_t: the entries of bucket b are [buckets[b], buckets[b+1])
+        uint64_t paths_offset; ///< normalized paths of the entries, one after another (not null terminated)
+        uint64_t data_offset; ///< start of the blobs
+    };
+
+    ///< An entry of the table of contents of an archive
+    struct ArchiveEntry
+    {
+        uint64_t hash; ///< hash of the normalized path
+        uint64_t offset; ///< offset of the blob
+        uint64_t size; ///< size of the blob as stored
+        uint64_t uncompressed_size;
+        uint32_t compression; ///< an ArchiveCompression
+        uint32_t path_offset; ///< offset of the path from the header's paths_offset
+        uint32_t path_size;
+        uint32_t padding;
+    };
+
+    // A read only archive of files, mapped in memory. Files are found by the hash of their normalized path:
+    // the top bits of the hash select a bucket of the sorted table of contents, which holds about one entry.
+    // Uncompressed files are read in place from the mapping.
+    class Archive
+    {
+    public:
+        Archive() = delete;
+        ///< Map an archive file. Throws an error if it is not a valid archive.
+        Archive(const std::string& file_path);
+        Archive(const Archive& other) = delete;
+        ~Archive();
+    public:
+        ///< Returns the entry of a file, or nullptr if the archive doesn't contain it
+        const ArchiveEntry* find(const std::string& path) const;
+        ///< Returns true if the archive contains the file
+        bool contains(const std::string& path) const;
+        ///< Returns the blob of an entry, as stored in the archive (compressed or not). Valid as long as the archive exists.
+        const unsigned char* data(const ArchiveEntry& entry) const;
+        ///< Returns the (uncompressed) content of a file. Throws an error if the archive doesn't contain it.
+        std::vector<unsigned char> read(const std::string& path) const;
+        ///< Returns the content of an entry, uncompressed
+        std::vector<unsigned char> read(const ArchiveEntry& entry) const;
+        ///< Returns the normalized path of an entry
+        std::string path(const ArchiveEntry& entry) const;
+        ///< Returns the entries of the archive, sorted by path hash
+        const ArchiveEntry* entries() const;
+        ///< Returns the number of files in the archive
+        uint32_t size() const;
+    public:
+        ///< Returns the path as stored in archives: '\' replaced by '/', and simplified with Utilities::simplify_path
+        static std::string normalize_path(const std::string& path);
+        ///< Returns the hash of a normalized path
+        static uint64_t path_hash(const std::string& normalized_path);
+    public:
+        static constexpr char _magic[8] = {'G', 'E', 'A', 'R', 'C', 'H', 'I', 'V'};
+        static constexpr uint32_t _version = 1;
+        MappedFile _file;
+        const ArchiveHeader* _header;
+        const ArchiveEntry* _entries;
+        const uint32_t* _buckets;
+        const char* _paths;
+        unsigned int _bucket_shift; // the bucket of a hash is hash >> _bucket_shift
+    public:
+        static unsigned int _bucket_bits(uint32_t n_buckets);
+    };
+
+    // Builds an archive file from files in memory or on disk
+    class ArchiveWriter
+    {
+    public:
+        ///< 'alignment' is the alignment of the blobs in the archive (a power of 2). 16 bytes are enough for SPIR-V code and vertex data.
+        ///< If 'cache' is not null, the compressed blobs are taken from it when the same content was already compressed.
+        ArchiveWriter(uint32_t alignment = 16, DerivedDataCache* cache = nullptr);
+        ArchiveWriter(const ArchiveWriter& other) = delete;
+        ~ArchiveWriter();
+    public:
+        ///< Add a file with the given content. Throws an error if a file with the same normalized path was already added.
+        ///< If 'compress' is true the file is stored compressed, unless compression doesn't make it smaller.
+        void add(const std::string& path, const std::vector<unsigned char>& content, bool compress = false);
+        ///< Add a file read from the disk under the given path in the archive
+        void add_file(const std::string& path, const std::string& file_path, bool compress = false);
+        ///< Write the archive
+        void write(const std::string& file_path) const;
+    public:
+        struct File
+        {
+            std::string path; // normalized
+            uint64_t hash;
+            std::vector<unsigned char> blob;
+            uint64_t uncompressed_size;
+            ArchiveCompression compression;
+        };
+        uint32_t _alignment;
+        DerivedDataCache* _cache;
+        std::vector<File> _files;
+        std::unordered_map<uint64_t, size_t> _indices; // path hash -> index in _files
+    };
+}
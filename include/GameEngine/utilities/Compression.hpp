@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace GameEngine
+{
+    // LZ4 compression (block format compatible with LZ4), implemented in tree.
+    // Large data is split in independent blocks, compressed and decompressed in parallel with the JobSystem.
+    class Compression
+    {
+    public:
+        ///< Returns the maximum compressed size of a block of 'size' bytes
+        static size_t block_bound(size_t size);
+        ///< Compress a block into 'destination'. Returns the compressed size, or 0 if it doesn't fit in 'capacity'.
+        static size_t compress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+        ///< Decompress a block into 'destination'. Returns the decompressed size. Throws an error if the block is corrupted or doesn't fit.
+        static size_t decompress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+    public:
+        ///< Compress data as independent blocks of 'block_size' bytes. Blocks that don't shrink are stored uncompressed.
+        static std::vector<unsigned char> compress(const unsigned char* data, size_t size, uint32_t block_size = 256*1024);
+        ///< Returns the decompressed size of data compressed with 'compress'
+        static uint64_t decompressed_size(const unsigned char* data, size_t size);
+        ///< Decompress data compressed with 'compress' (the blocks in parallel). 'capacity' must be at least the decompressed size.
+        static void decompress(const unsigned char* data, size_t size, unsigned char* destination, size_t capacity);
+    public:
+        ///< Header of data compressed with 'compress', followed by the compressed size of each block, then the blocks
+        struct Header
+        {
+            char magic[4]; ///< "GELZ"
+            uint32_t block_size;
+            uint64_t size; ///< decompressed size
+        };
+        static constexpr uint32_t _stored_bit = 0x80000000u; // set in the compressed size of the blocks stored uncompressed
+        static Header _header(const unsigned char* data, size_t size);
+        // Decompress a block, returns SIZE_MAX if it is corrupted (so that it can be used in jobs, which can't throw)
+        static size_t _decompress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <functional>
+#include <type_traits>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace GameEngine
+{
+    // Cache of the outputs of the asset cook steps (shader compilation, compression, mip generation...), addressed by content.
+    // The key of an output is a hash of the name and version of the cook step, of the source content and of the processing parameters,
+    // so an output is cooked again only when one of them changes. Outputs are stored as files named after their key in a local directory,
+    // and in a shared directory (a network share for example) if there is one: outputs cooked on another machine are found there,
+    // and copied to the local directory. Files are written atomically and checked when read, so concurrent builds can share the directories.
+    class DerivedDataCache
+    {
+    public:
+        ///< A 128 bits key, built by hashing everything the output depends on
+        class Key
+        {
+        public:
+            Key() = delete;
+            ///< Start the key of an output of the given cook step. The version must be increased when the output of the step changes.
+            Key(const std::string& step, uint32_t version);
+        public:
+            ///< Add bytes to the key. Each addition is delimited, so ("ab", "c") and ("a", "bc") give different keys.
+            Key& add(const void* data, size_t size);
+            Key& add(const std::string& value);
+            Key& add(const char* value);
+            ///< Add a number or an enum value (a processing parameter)
+            template<typename T>
+            Key& add(const T& value)
+            {
+                static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "only numbers can be added by value to a key");
+                return add(&value, sizeof(T));
+            }
+            ///< Add the content of a file. Throws an error with the path if it can't be read.
+            Key& add_file(const std::string& file_path);
+            ///< Returns the key as 32 hexadecimal digits
+            std::string string() const;
+            bool operator==(const Key& other) const;
+        public:
+            uint64_t _hash[2]; // two FNV-1a hashes with different seeds
+        };
+        ///< First bytes of a cached output file
+        struct FileHeader
+        {
+            char magic[4]; ///< "GDDC"
+            uint32_t version;
+            uint64_t key[2];
+            uint64_t size; ///< size of the output, stored after the header
+            uint64_t checksum; ///< hash of the output, to detect truncated or corrupted files
+        };
+    public:
+        DerivedDataCache() = delete;
+        ///< Store the outputs in 'local_directory' (created if needed), and share them through 'shared_directory' if it is not empty
+        DerivedDataCache(const std::string& local_directory, const std::string& shared_directory = "");
+        DerivedDataCache(const DerivedDataCache& other) = delete;
+        ~DerivedDataCache();
+    public:
+        ///< Returns true and sets 'output' if the output of the key is cached. Can be called from any thread.
+        bool get(const Key& key, std::vector<unsigned char>& output);
+        ///< Store the output of a key. A failure to write is not an error, the output is just not cached. Can be called from any thread.
+        void put(const Key& key, const std::vector<unsigned char>& output);
+        ///< Returns the cached output of the key, or cooks it with 'cook' and stores it
+        std::vector<unsigned char> get_or_cook(const Key& key, const std::function<std::vector<unsigned char>()>& cook);
+        ///< Number of outputs found in the cache
+        uint64_t hits() const;
+        ///< Number of outputs not found in the cache
+        uint64_t misses() const;
+    public:
+        static constexpr char _magic[4] = {'G', 'D', 'D', 'C'};
+        static constexpr uint32_t _version = 1;
+        std::string _local_directory;
+        std::string _shared_directory;
+        std::atomic<uint64_t> _hits{0};
+        std::atomic<uint64_t> _misses{0};
+    public:
+        // Path of the file of a key in a cache directory (the outputs are spread in 256 subdirectories)
+        static std::string _path(const std::string& directory, const Key& key);
+        // Read the output of a key from its file. Returns false if the file doesn't exist or is not valid.
+        static bool _read(const std::string& file_path, const Key& key, std::vector<unsigned char>& output);
+        // Write the output of a key to a temporary file renamed once complete. Returns false on failure.
+        static bool _write(const std::string& file_path, const Key& key, const std::vector<unsigned char>& output);
+    };
+}
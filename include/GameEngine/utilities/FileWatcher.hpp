@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <chrono>
+
+namespace GameEngine
+{
+    // Watches directories for created or modified files. Changes are notified by inotify on Linux,
+    // on the other systems the modification times of the files are polled.
+    class FileWatcher
+    {
+    public:
+        FileWatcher() = delete;
+        ///< Watch the files of the directories (and of their subdirectories if 'recursive'). Throws an error with the path if a directory does not exist.
+        ///< When polling, the directories are scanned at most once every 'poll_interval' seconds.
+        FileWatcher(const std::vector<std::string>& directories, bool recursive = true, double poll_interval = 0.5);
+        FileWatcher(const FileWatcher& other) = delete;
+        ~FileWatcher();
+    public:
+        ///< Returns the paths of the files created or modified since the previous call, without duplicates. Never blocks.
+        std::vector<std::string> changes();
+        ///< Returns true if the changes are notified by the system, false if they are polled
+        bool uses_notifications() const;
+        ///< Returns the path in the form used by changes(): absolute, normalized, with '/' separators
+        static std::string normalize_path(const std::string& path);
+    public:
+        std::vector<std::string> _directories;
+        bool _recursive;
+        std::chrono::steady_clock::duration _poll_interval;
+        std::chrono::steady_clock::time_point _last_poll;
+        std::unordered_map<std::string, std::filesystem::file_time_type> _write_times; // last modification time of each file, when polling
+        #ifdef __linux__
+        int _inotify = -1;
+        std::unordered_map<int, std::string> _watches; // watched directory of each inotify watch descriptor
+        #endif
+    protected:
+        // Scan the watched files, and add to 'changed' the ones whose modification time changed since the previous scan
+        void _scan(std::vector<std::string>& changed);
+        #ifdef __linux__
+        // Watch a directory (and its subdirectories if recursive). The files already in a new directory are added to 'changed', if not nullptr.
+        void _watch(const std::string& directory, std::vector<std::string>* changed);
+        void _read_events(std::vector<std::string>& changed);
+        #endif
+    };
+}
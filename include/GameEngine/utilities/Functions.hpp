@@ -5,6 +5,8 @@
 #include <vector>
 #include <list>
 #include <math.h>
+#include <cstdint>
+#include <cstddef>
 
 #include "Macro.hpp"
 
@@ -24,5 +26,11 @@ namespace GameEngine
         static std::string simplify_path(const std::string& path);
         ///< Replace all matching substrings 'searched' by 'replacement' in place. Returns the number of replacements.
         static unsigned int replace_substrings(std::string& str, const std::string& searched, const std::string& replacement);
+        ///< Returns a small index unique among the running threads. The index of a thread is reused by the threads created after it exits.
+        static unsigned int thread_index();
+        ///< 64 bits FNV-1a hash of a sequence of bytes. Hashing several sequences is done by passing the previous hash as seed.
+        static uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+        ///< Mix a hash value into a seed (as boost::hash_combine, with 64 bits constants)
+        static void hash_combine(uint64_t& seed, uint64_t value);
     };
 }
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace GameEngine
+{
+    // Bump allocator: allocations are carved out of large blocks and are all freed at once by reset().
+    // Not thread safe, each thread is meant to have its own.
+    class alignas(64) LinearAllocator
+    {
+    public:
+        ///< The first block is only allocated by the first allocation
+        LinearAllocator(size_t block_size = 64*1024);
+        LinearAllocator(const LinearAllocator& other) = delete;
+        LinearAllocator(LinearAllocator&& other) = default;
+        ~LinearAllocator();
+    public:
+        ///< Returns 'size' bytes aligned to 'alignment' (a power of 2), valid until the next reset
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+        ///< Free all the allocations at once. If several blocks were needed, they are replaced by a single one big enough for all of them,
+        ///< so that once the peak usage is reached no more memory is allocated.
+        void reset();
+        ///< Number of bytes handed out since the last reset (including alignment padding)
+        size_t used() const;
+        ///< Total size of the blocks
+        size_t capacity() const;
+    public:
+        size_t _block_size;
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        std::vector<size_t> _block_sizes;
+        size_t _offset = 0; // in the last block
+        size_t _used = 0;
+    };
+
+    // STL allocator allocating from a LinearAllocator. Deallocation does nothing, the memory is reclaimed when the LinearAllocator is reset.
+    template<typename T>
+    class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+        ArenaAllocator(LinearAllocator& arena) : _arena(&arena) {}
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other._arena) {}
+    public:
+        T* allocate(size_t n) {return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));}
+        void deallocate(T*, size_t) {}
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const {return _arena == other._arena;}
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const {return _arena != other._arena;}
+    public:
+        LinearAllocator* _arena;
+    };
+
+    ///< A vector allocated from a LinearAllocator
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
@@ -11,6 +11,13 @@
 	#define SEP_CHAR '/'
 #endif
 
+//Prevent a function from being inlined
+#ifdef _MSC_VER
+	#define NO_INLINE __declspec(noinline)
+#else
+	#define NO_INLINE __attribute__((noinline))
+#endif
+
 //Define the name of the current file
 #include <cstring>
 #define SHORT_FILE (strrchr(__FILE__, SEP_CHAR) ? strrchr(__FILE__, SEP_CHAR) + 1 : __FILE__)
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace GameEngine
+{
+    // A read only file mapped in memory (mmap on POSIX systems, file mapping on Windows).
+    // The content is paged in by the OS on first access and read in place, without copying it into a buffer.
+    class MappedFile
+    {
+    public:
+        MappedFile() = delete;
+        ///< Map the whole file. Throws an error with the path if the file can't be opened or mapped.
+        MappedFile(const std::string& file_path);
+        MappedFile(const MappedFile& other) = delete;
+        ~MappedFile();
+    public:
+        ///< Returns the content of the file (nullptr if the file is empty). The pointer is page aligned.
+        const unsigned char* data() const;
+        ///< Returns the size of the file in bytes
+        size_t size() const;
+        ///< Returns the path of the mapped file
+        const std::string& path() const;
+    public:
+        std::string _path;
+        const unsigned char* _data = nullptr;
+        size_t _size = 0;
+        #ifdef _WIN32
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+        #else
+        int _file = -1;
+        #endif
+    protected:
+        void _close();
+    };
+}
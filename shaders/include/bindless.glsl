@@ -0,0 +1,26 @@
+// Global resource arrays of BindlessResources (descriptor set 0), indexed with the indices passed in push constants.
+// Include after '#version 450', and define BINDLESS_SET before including to use another set index.
+#extension GL_EXT_nonuniform_qualifier : require
+
+#ifndef BINDLESS_SET
+#define BINDLESS_SET 0
+#endif
+
+layout(set = BINDLESS_SET, binding = 0) uniform texture2D bindless_textures[];
+layout(set = BINDLESS_SET, binding = 1) uniform sampler bindless_samplers[];
+layout(set = BINDLESS_SET, binding = 2) readonly buffer BindlessBuffer
+{
+    uint words[];
+} bindless_buffers[];
+
+// Sample a texture. Use nonuniformEXT on the indices if they can differ within a draw.
+vec4 bindless_sample(uint texture_index, uint sampler_index, vec2 uv)
+{
+    return texture(sampler2D(bindless_textures[nonuniformEXT(texture_index)], bindless_samplers[nonuniformEXT(sampler_index)]), uv);
+}
+
+// Read a 32 bits word of a storage buffer
+uint bindless_load(uint buffer_index, uint word_index)
+{
+    return bindless_buffers[nonuniformEXT(buffer_index)].words[word_index];
+}
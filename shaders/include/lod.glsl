@@ -0,0 +1,15 @@
+// Cross-fade between two LODs of a mesh (see LodState): both are drawn with their fade value, and each pixel is kept by only one of them
+// with a 4x4 ordered dither, so that the fade needs neither blending nor sorting. Call from the fragment shader:
+//   if (lod_fade_discard(fade, fading_out)) discard;
+// with 'fade' the progress of the cross-fade, and 'fading_out' true when drawing the previous LOD.
+
+bool lod_fade_discard(float fade, bool fading_out)
+{
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0,
+                                      12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0,
+                                      15.0, 7.0, 13.0, 5.0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+    return fading_out ? (threshold < fade) : (threshold >= fade);
+}
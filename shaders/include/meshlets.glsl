@@ -0,0 +1,34 @@
+// Meshlets of a ClusteredMesh (see MeshData::build_meshlets), and their culling.
+// The buffers are in descriptor set 0, at the bindings of ClusteredMesh:
+//   0 meshlets, 1 meshlet vertices, 2 meshlet triangles, 3 visible meshlets, 4 draw commands, 5 culled indices, 6 vertices
+
+struct Meshlet
+{
+    vec4 sphere; // center and radius
+    vec4 cone; // axis and cutoff
+    uint vertex_offset;
+    uint triangle_offset;
+    uint vertex_count;
+    uint triangle_count;
+};
+
+// Local vertex indices of a triangle of a meshlet, packed in 8 bits each
+uvec3 meshlet_triangle(uint packed)
+{
+    return uvec3(packed & 0xffu, (packed >> 8) & 0xffu, (packed >> 16) & 0xffu);
+}
+
+// Returns false if the meshlet is outside the view frustum (planes in object space, normals pointing inside),
+// or if all its triangles face away from the camera (position in object space)
+bool meshlet_visible(Meshlet meshlet, vec4 frustum[6], vec3 camera)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (dot(frustum[i].xyz, meshlet.sphere.xyz) + frustum[i].w < -meshlet.sphere.w)
+        {
+            return false;
+        }
+    }
+    vec3 view = meshlet.sphere.xyz - camera;
+    return dot(view, meshlet.cone.xyz) < meshlet.cone.w * length(view) + meshlet.sphere.w;
+}
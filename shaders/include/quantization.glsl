@@ -0,0 +1,35 @@
+// Decoding of the vertices quantized by MeshData::quantize (Mesh with the QUANTIZED format). The vertex inputs are:
+//   layout(location = 0) in vec4 quantized_position; // RGBA16 unorm: xyz in the bounding box, w the bitangent sign (0 or 1)
+//   layout(location = 1) in vec4 quantized_frame;    // RGBA8 snorm: xy octahedral normal, zw octahedral tangent
+//   layout(location = 2) in vec2 quantized_uv;       // RG16 unorm in the uv bounds
+// The offsets and scales are the QuantizationBounds of the mesh. The position decoding can also be folded in the model matrix.
+
+vec3 decode_position(vec4 quantized_position, vec3 offset, vec3 scale)
+{
+    return offset + quantized_position.xyz * scale;
+}
+
+vec2 decode_uv(vec2 quantized_uv, vec2 offset, vec2 scale)
+{
+    return offset + quantized_uv * scale;
+}
+
+// Unit vector from its octahedral encoding: the lower half of the octahedron is unfolded from the corners of the square
+vec3 decode_octahedral(vec2 encoded)
+{
+    vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+vec3 decode_normal(vec4 quantized_frame)
+{
+    return decode_octahedral(quantized_frame.xy);
+}
+
+// Tangent, with the sign of the bitangent in w: bitangent = cross(normal, tangent.xyz) * tangent.w
+vec4 decode_tangent(vec4 quantized_frame, vec4 quantized_position)
+{
+    return vec4(decode_octahedral(quantized_frame.zw), quantized_position.w * 2.0 - 1.0);
+}
@@ -0,0 +1,3 @@
+glslc.exe -I ../include cull.comp -o cull.spv
+glslc.exe -I ../include meshlet.mesh -o meshlet.spv
+pause
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include <GameEngine/Engine.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+    #include <timeapi.h>
+#endif
 
 using namespace GameEngine;
 
@@ -25,7 +31,7 @@ void Engine::initialize(const std::vector<std::string>& validation_layers)
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_2;
     // setup validation layers
     std::vector<std::string> available_validation_layers = get_available_validation_layers();
     std::vector<const char*> validation_layer_names;
@@ -61,16 +67,20 @@ void Engine::initialize(const std::vector<std::string>& validation_layers)
     }
     createInfo.enabledExtensionCount = extensions.size();
     createInfo.ppEnabledExtensionNames = extensions.data();
-    VkResult result = vkCreateInstance(&createInfo, nullptr, &_vk_instance);
+    VkResult result = vkCreateInstance(&createInfo, HostAllocator::callbacks(), &_vk_instance);
     if (result != VK_SUCCESS)
     {
         THROW_ERROR("Failed to create the Vulkan instance")
     }
     // setup validation layers callback function
-    if (_create_debug_utils_messenger_EXT(_vk_instance, &debug_create_info, nullptr, &_debug_messenger) != VK_SUCCESS)
+    if (_create_debug_utils_messenger_EXT(_vk_instance, &debug_create_info, HostAllocator::callbacks(), &_debug_messenger) != VK_SUCCESS)
     {
         THROW_ERROR("Failed to set up debug messenger")
     }
+    #ifdef _WIN32
+    // Increase the resolution of the OS scheduler, so that sleeping for the frame rate limit is precise
+    timeBeginPeriod(1);
+    #endif
     // setup the terminate function
     std::atexit(Engine::terminate);
 }
@@ -78,10 +88,14 @@ void Engine::initialize(const std::vector<std::string>& validation_layers)
 void Engine::terminate()
 {
     //Terminate Vulkan
-    _destroy_debug_utils_messenger_EXT(_vk_instance, _debug_messenger, nullptr);
-    vkDestroyInstance(_vk_instance, nullptr);
+    _destroy_debug_utils_messenger_EXT(_vk_instance, _debug_messenger, HostAllocator::callbacks());
+    vkDestroyInstance(_vk_instance, HostAllocator::callbacks());
+    HostAllocator::trim();
     //Terminate GLFW
     glfwTerminate();
+    #ifdef _WIN32
+    timeEndPeriod(1);
+    #endif
     //set the flag back
     _initialized = false;
 }
@@ -0,0 +1,128 @@
+#include <GameEngine/graphics/AssetManager.hpp>
+#include <GameEngine/graphics/Shader.hpp>
+#include <GameEngine/graphics/Image.hpp>
+#include <filesystem>
+#include <iterator>
+using namespace GameEngine;
+
+AssetManager::AssetManager(const GPU& _gpu) : gpu(_gpu)
+{
+    AsyncIO::initialize();
+    const GPU* device = &gpu;
+    set_loader<Shader>([device](const std::string&, const std::vector<unsigned char>& content)
+    {
+        return std::make_shared<Shader>(*device, content);
+    });
+    // Image(gpu, path) doesn't decode files yet: failing is better than an empty image marked as ready
+    set_loader<Image>([](const std::string& path, const std::vector<unsigned char>&) -> std::shared_ptr<Image>
+    {
+        THROW_ERROR("image loading is not implemented, can't load '" + path + "'")
+    }, false);
+}
+
+AssetManager::~AssetManager()
+{
+    for (std::pair<const Key, std::shared_ptr<AssetEntry>>& asset : _assets)
+    {
+        JobSystem::wait(asset.second->counter);
+    }
+}
+
+void AssetManager::collect(unsigned int delay)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::unordered_map<Key, std::shared_ptr<AssetEntry>, KeyHash>::iterator it = _assets.begin(); it != _assets.end();)
+    {
+        AssetEntry& entry = *it->second;
+        // Handles are only created from existing handles, or by 'load' under the lock, so an asset referenced by the manager alone stays unreferenced.
+        // The loading job holds a reference too, so assets being loaded are never unloaded.
+        if (it->second.use_count() > 1)
+        {
+            entry.unused_collects = 0;
+            it++;
+        }
+        else if (++entry.unused_collects >= delay)
+        {
+            it = _assets.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    // The paths only referenced by the manager belong to no asset anymore
+    for (std::unordered_map<std::string, std::shared_ptr<const std::string>>::iterator it = _paths.begin(); it != _paths.end();)
+    {
+        it = (it->second.use_count() == 1) ? _paths.erase(it) : std::next(it);
+    }
+}
+
+size_t AssetManager::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _assets.size();
+}
+
+std::string AssetManager::normalize_path(const std::string& path)
+{
+    std::error_code error;
+    return std::filesystem::absolute(path, error).lexically_normal().generic_string();
+}
+
+std::shared_ptr<AssetEntry> AssetManager::_find(std::type_index type, const std::string& path)
+{
+    std::unordered_map<std::string, std::shared_ptr<const std::string>>::const_iterator interned = _paths.find(normalize_path(path));
+    if (interned == _paths.end())
+    {
+        return nullptr;
+    }
+    std::unordered_map<Key, std::shared_ptr<AssetEntry>, KeyHash>::const_iterator it = _assets.find({type, interned->second.get()});
+    return (it != _assets.end()) ? it->second : nullptr;
+}
+
+std::shared_ptr<AssetEntry> AssetManager::_create(std::type_index type, const std::string& path)
+{
+    std::string normalized = normalize_path(path);
+    std::shared_ptr<const std::string>& interned = _paths[normalized];
+    if (interned == nullptr)
+    {
+        interned = std::make_shared<const std::string>(normalized);
+    }
+    std::shared_ptr<AssetEntry> entry = std::make_shared<AssetEntry>(interned, type);
+    _assets.emplace(Key{type, interned.get()}, entry);
+    return entry;
+}
+
+void AssetManager::_start(const std::shared_ptr<AssetEntry>& entry,
+                          const std::function<std::shared_ptr<void>(const std::string&, const std::vector<unsigned char>&)>& loader, bool read_file)
+{
+    JobSystem::submit([entry, loader, read_file]()
+    {
+        // The errors are stored in the entry, to be reported by the handles
+        try
+        {
+            std::vector<unsigned char> content;
+            if (read_file)
+            {
+                AsyncFile file(*entry->path);
+                content.resize(file.size());
+                if (!content.empty())
+                {
+                    std::shared_ptr<AsyncRead> read = AsyncIO::read(file, 0, content.size(), content.data());
+                    AsyncIO::flush();
+                    if (read->wait() != static_cast<int64_t>(content.size()))
+                    {
+                        THROW_ERROR("failed to read the file '" + *entry->path + "'")
+                    }
+                }
+            }
+            entry->asset = loader(*entry->path, content);
+            entry->state.store(ASSET_READY, std::memory_order_release);
+        }
+        catch (const std::exception& error)
+        {
+            entry->error = error.what();
+            entry->state.store(ASSET_FAILED, std::memory_order_release);
+        }
+    }, &entry->counter);
+}
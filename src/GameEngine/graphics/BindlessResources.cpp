@@ -0,0 +1,185 @@
+#include <GameEngine/graphics/BindlessResources.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <algorithm>
+using namespace GameEngine;
+
+BindlessResources::BindlessResources(const GPU& _gpu, unsigned int max_frames_in_flight,
+                                     uint32_t max_sampled_images, uint32_t max_samplers, uint32_t max_storage_buffers) : gpu(_gpu)
+{
+    if (!gpu._bindless_enabled)
+    {
+        THROW_ERROR("The GPU does not support the descriptor indexing features needed for bindless resources")
+    }
+    // Clamp the array sizes to the limits of update after bind descriptors
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties{};
+    indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(gpu._physical_device, &properties);
+    _slots[SAMPLED_IMAGES].capacity = std::min({max_sampled_images, indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                                                indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    _slots[SAMPLERS].capacity = std::min({max_samplers, indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+                                          indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+    _slots[STORAGE_BUFFERS].capacity = std::min({max_storage_buffers, indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                                 indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    for (Slots& slots : _slots)
+    {
+        slots.pending.resize(max_frames_in_flight);
+    }
+    // Layout: the arrays can be partially filled, and updated while the set is bound in command buffers not using the updated indices
+    const VkDescriptorType types[3] = {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    VkDescriptorSetLayoutBinding bindings[3];
+    VkDescriptorBindingFlags binding_flags[3];
+    VkDescriptorPoolSize pool_sizes[3];
+    for (uint32_t i=0; i<3; i++)
+    {
+        bindings[i] = {};
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = _slots[i].capacity;
+        bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+        // (the sampled image update after bind feature covers samplers too)
+        binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        pool_sizes[i] = {types[i], _slots[i].capacity};
+    }
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info{};
+    flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flags_info.bindingCount = 3;
+    flags_info.pBindingFlags = binding_flags;
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = &flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = 3;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(gpu._logical_device, &layout_info, HostAllocator::callbacks(), &_layout) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the bindless descriptor set layout")
+    }
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 3;
+    pool_info.pPoolSizes = pool_sizes;
+    if (vkCreateDescriptorPool(gpu._logical_device, &pool_info, HostAllocator::callbacks(), &_pool) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the bindless descriptor pool")
+    }
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = _pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &_layout;
+    if (vkAllocateDescriptorSets(gpu._logical_device, &allocate_info, &_set) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to allocate the bindless descriptor set")
+    }
+}
+
+BindlessResources::~BindlessResources()
+{
+    vkDestroyDescriptorPool(gpu._logical_device, _pool, HostAllocator::callbacks());
+    vkDestroyDescriptorSetLayout(gpu._logical_device, _layout, HostAllocator::callbacks());
+}
+
+uint32_t BindlessResources::add_image(VkImageView image_view, VkImageLayout layout)
+{
+    VkDescriptorImageInfo image_info{};
+    image_info.imageView = image_view;
+    image_info.imageLayout = layout;
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t index = _allocate_slot(SAMPLED_IMAGES);
+    _write(SAMPLED_IMAGES, index, &image_info, nullptr);
+    return index;
+}
+
+uint32_t BindlessResources::add_sampler(VkSampler sampler)
+{
+    VkDescriptorImageInfo image_info{};
+    image_info.sampler = sampler;
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t index = _allocate_slot(SAMPLERS);
+    _write(SAMPLERS, index, &image_info, nullptr);
+    return index;
+}
+
+uint32_t BindlessResources::add_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    VkDescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t index = _allocate_slot(STORAGE_BUFFERS);
+    _write(STORAGE_BUFFERS, index, nullptr, &buffer_info);
+    return index;
+}
+
+void BindlessResources::remove(Binding binding, uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _slots[binding].pending[_frame_index].push_back(index);
+}
+
+VkDescriptorSetLayout BindlessResources::layout() const
+{
+    return _layout;
+}
+
+VkPushConstantRange BindlessResources::push_constant_range() const
+{
+    return {VK_SHADER_STAGE_ALL, 0, push_constants_size};
+}
+
+void BindlessResources::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set_index) const
+{
+    vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, set_index, 1, &_set, 0, nullptr);
+}
+
+void BindlessResources::_begin_frame(unsigned int frame_index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frame_index = frame_index;
+    // The indices released while this frame's resources were last recorded can't be read by the GPU anymore
+    for (Slots& slots : _slots)
+    {
+        std::vector<uint32_t>& pending = slots.pending[frame_index];
+        slots.free.insert(slots.free.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+}
+
+uint32_t BindlessResources::_allocate_slot(Binding binding)
+{
+    Slots& slots = _slots[binding];
+    if (!slots.free.empty())
+    {
+        uint32_t index = slots.free.back();
+        slots.free.pop_back();
+        return index;
+    }
+    if (slots.next >= slots.capacity)
+    {
+        THROW_ERROR("The bindless array " + std::to_string(binding) + " is full (" + std::to_string(slots.capacity) + " descriptors)")
+    }
+    return slots.next++;
+}
+
+void BindlessResources::_write(Binding binding, uint32_t index, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer)
+{
+    const VkDescriptorType types[3] = {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = binding;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = types[binding];
+    write.pImageInfo = image;
+    write.pBufferInfo = buffer;
+    vkUpdateDescriptorSets(gpu._logical_device, 1, &write, 0, nullptr);
+}
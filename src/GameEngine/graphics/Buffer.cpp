@@ -0,0 +1,173 @@
+#include <GameEngine/graphics/Buffer.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+using namespace GameEngine;
+
+Buffer::Buffer(const GPU& _gpu, const void* data, VkDeviceSize size, VkBufferUsageFlags usage) : gpu(_gpu), _size(size)
+{
+    _create(gpu, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vk_buffer, _vk_memory);
+    if (data != nullptr)
+    {
+        // The destructor isn't called if the constructor throws
+        try
+        {
+            _upload(data, size);
+        }
+        catch (const std::runtime_error&)
+        {
+            vkDestroyBuffer(gpu._logical_device, _vk_buffer, HostAllocator::callbacks());
+            vkFreeMemory(gpu._logical_device, _vk_memory, HostAllocator::callbacks());
+            throw;
+        }
+    }
+}
+
+Buffer::~Buffer()
+{
+    vkDestroyBuffer(gpu._logical_device, _vk_buffer, HostAllocator::callbacks());
+    vkFreeMemory(gpu._logical_device, _vk_memory, HostAllocator::callbacks());
+}
+
+VkDeviceSize Buffer::size() const
+{
+    return _size;
+}
+
+void Buffer::_create(const GPU& gpu, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                     VkBuffer& buffer, VkDeviceMemory& memory)
+{
+    uint32_t families[3];
+    uint32_t n_families = 0;
+    for (const std::optional<uint32_t>& family : {gpu._graphics_family, gpu._transfer_family, gpu._compute_family})
+    {
+        if (family.has_value() && std::find(families, families + n_families, family.value()) == families + n_families)
+        {
+            families[n_families++] = family.value();
+        }
+    }
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    // Concurrent sharing avoids the queue family ownership transfers after the upload, and between the async compute and graphics queues
+    buffer_info.sharingMode = (n_families > 1) ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    buffer_info.queueFamilyIndexCount = (n_families > 1) ? n_families : 0;
+    buffer_info.pQueueFamilyIndices = families;
+    if (vkCreateBuffer(gpu._logical_device, &buffer_info, HostAllocator::callbacks(), &buffer) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the buffer")
+    }
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(gpu._logical_device, buffer, &requirements);
+    VkMemoryAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = gpu._find_memory_type(requirements.memoryTypeBits, properties);
+    if (vkAllocateMemory(gpu._logical_device, &allocate_info, HostAllocator::callbacks(), &memory) != VK_SUCCESS)
+    {
+        vkDestroyBuffer(gpu._logical_device, buffer, HostAllocator::callbacks());
+        THROW_ERROR("failed to allocate the buffer memory")
+    }
+    vkBindBufferMemory(gpu._logical_device, buffer, memory, 0);
+}
+
+void Buffer::_upload(const void* data, VkDeviceSize size)
+{
+    VkDevice device = gpu._logical_device;
+    VkBuffer staging;
+    VkDeviceMemory staging_memory;
+    _create(gpu, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, staging_memory);
+    // On failure the steps left are skipped, and everything created so far is destroyed before throwing
+    std::string error;
+    void* mapped;
+    if (vkMapMemory(device, staging_memory, 0, size, 0, &mapped) != VK_SUCCESS)
+    {
+        error = "failed to map the staging buffer memory";
+    }
+    else
+    {
+        std::memcpy(mapped, data, size);
+        vkUnmapMemory(device, staging_memory);
+    }
+    // Record the copy in a transient pool, as uploads can be done from any thread
+    bool transfer = gpu._transfer_queue.has_value();
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = transfer ? gpu._transfer_family.value() : gpu._graphics_family.value();
+    VkCommandPool pool = VK_NULL_HANDLE;
+    if (error.empty() && vkCreateCommandPool(device, &pool_info, HostAllocator::callbacks(), &pool) != VK_SUCCESS)
+    {
+        pool = VK_NULL_HANDLE;
+        error = "failed to create the upload command pool";
+    }
+    VkCommandBufferAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.commandPool = pool;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandBufferCount = 1;
+    VkCommandBuffer command_buffer;
+    if (error.empty() && vkAllocateCommandBuffers(device, &allocate_info, &command_buffer) != VK_SUCCESS)
+    {
+        error = "failed to allocate the upload command buffer";
+    }
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (error.empty() && vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+    {
+        error = "failed to begin the upload command buffer";
+    }
+    if (error.empty())
+    {
+        VkBufferCopy region{};
+        region.size = size;
+        vkCmdCopyBuffer(command_buffer, staging, _vk_buffer, 1, &region);
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        {
+            error = "failed to record the upload command buffer";
+        }
+    }
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence = VK_NULL_HANDLE;
+    if (error.empty() && vkCreateFence(device, &fence_info, HostAllocator::callbacks(), &fence) != VK_SUCCESS)
+    {
+        fence = VK_NULL_HANDLE;
+        error = "failed to create the upload fence";
+    }
+    if (error.empty())
+    {
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffer;
+        VkResult result;
+        {
+            std::lock_guard<std::mutex> queue_lock(*gpu._queue_mutex);
+            result = vkQueueSubmit(transfer ? gpu._transfer_queue.value() : gpu._graphics_queue.value(), 1, &submit_info, fence);
+        }
+        if (result == VK_SUCCESS)
+        {
+            JobSystem::wait(device, fence);
+        }
+        else
+        {
+            error = "failed to submit the buffer upload";
+        }
+    }
+    // Destroying a null handle does nothing
+    vkDestroyFence(device, fence, HostAllocator::callbacks());
+    vkDestroyCommandPool(device, pool, HostAllocator::callbacks());
+    vkDestroyBuffer(device, staging, HostAllocator::callbacks());
+    vkFreeMemory(device, staging_memory, HostAllocator::callbacks());
+    if (!error.empty())
+    {
+        THROW_ERROR(error)
+    }
+}
@@ -0,0 +1,210 @@
+#include <GameEngine/graphics/ClusteredMesh.hpp>
+#include <GameEngine/graphics/DescriptorSets.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <GameEngine/graphics/Shader.hpp>
+#include <algorithm>
+#include <iterator>
+#include <string>
+using namespace GameEngine;
+
+// Push constants of cull.comp
+struct CullingConstants
+{
+    float frustum[6][4];
+    float camera[3];
+    uint32_t meshlet_count;
+    uint32_t write_indices;
+};
+
+// Outputs declared by meshlet.mesh
+static const unsigned int mesh_shader_max_vertices = 64;
+static const unsigned int mesh_shader_max_triangles = 124;
+
+ClusteredMesh::ClusteredMesh(const GPU& _gpu, const MeshData& data, unsigned int max_frames_in_flight, unsigned int max_vertices, unsigned int max_triangles) :
+    mesh(_gpu, data, Mesh::INTERLEAVED, Mesh::QUANTIZED), gpu(_gpu)
+{
+    if (mesh_shaders() && (max_vertices > mesh_shader_max_vertices || max_triangles > mesh_shader_max_triangles))
+    {
+        THROW_ERROR("the mesh shader outputs at most " + std::to_string(mesh_shader_max_vertices) + " vertices and "
+                    + std::to_string(mesh_shader_max_triangles) + " triangles per meshlet")
+    }
+    MeshletData meshlets = data.build_meshlets(max_vertices, max_triangles);
+    _meshlet_count = meshlets.meshlets.size();
+    // A workgroup per meshlet, for the culling and for the mesh shader
+    if (_meshlet_count > gpu._device_properties.limits.maxComputeWorkGroupCount[0])
+    {
+        THROW_ERROR("too many meshlets to cull: " + std::to_string(_meshlet_count))
+    }
+    if (mesh_shaders() && _meshlet_count > gpu._max_draw_mesh_tasks_count)
+    {
+        THROW_ERROR("too many meshlets to draw with mesh shaders: " + std::to_string(_meshlet_count))
+    }
+    const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    _meshlets.reset(new Buffer(gpu, meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Meshlet), storage));
+    _meshlet_vertices.reset(new Buffer(gpu, meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t), storage));
+    _meshlet_triangles.reset(new Buffer(gpu, meshlets.triangles.data(), meshlets.triangles.size() * sizeof(uint32_t), storage));
+    _frames.resize(max_frames_in_flight);
+    for (FrameOutput& frame : _frames)
+    {
+        frame.visible.reset(new Buffer(gpu, nullptr, _meshlet_count * sizeof(uint32_t), storage));
+        frame.commands.reset(new Buffer(gpu, nullptr, sizeof(VkDrawMeshTasksIndirectCommandNV) + sizeof(VkDrawIndexedIndirectCommand),
+                                        storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT));
+        if (!mesh_shaders())
+        {
+            frame.indices.reset(new Buffer(gpu, nullptr, 3 * meshlets.triangles.size() * sizeof(uint32_t), storage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT));
+        }
+    }
+}
+
+ClusteredMesh::~ClusteredMesh()
+{
+    // The immutable sets are cached by buffer handles, that new buffers can reuse
+    std::vector<VkBuffer> buffers = {_meshlets->_vk_buffer, _meshlet_vertices->_vk_buffer, _meshlet_triangles->_vk_buffer, mesh._vertices->_vk_buffer};
+    for (const FrameOutput& frame : _frames)
+    {
+        buffers.push_back(frame.visible->_vk_buffer);
+        buffers.push_back(frame.commands->_vk_buffer);
+        if (frame.indices != nullptr)
+        {
+            buffers.push_back(frame.indices->_vk_buffer);
+        }
+    }
+    for (DescriptorSets* descriptor_sets : _descriptor_sets)
+    {
+        for (VkBuffer buffer : buffers)
+        {
+            descriptor_sets->evict_buffer(buffer);
+        }
+    }
+}
+
+bool ClusteredMesh::mesh_shaders() const
+{
+    return gpu._mesh_shader_enabled;
+}
+
+uint32_t ClusteredMesh::meshlet_count() const
+{
+    return _meshlet_count;
+}
+
+void ClusteredMesh::cull(VkCommandBuffer command_buffer, unsigned int frame_index, DescriptorSets& descriptor_sets, const Shader& culling_shader,
+                         const View& view, bool async) const
+{
+    const FrameOutput& frame = _frames[frame_index];
+    // Reset the counts of the indirect commands
+    uint32_t commands[7] = {0, 0, 0, 1, 0, 0, 0};
+    vkCmdUpdateBuffer(command_buffer, frame.commands->_vk_buffer, 0, sizeof(commands), commands);
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    // Dispatch a workgroup per meshlet
+    PipelineState state;
+    ShaderStage stage;
+    stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage.module = culling_shader._vk_shader;
+    state.stages.push_back(stage);
+    state.layout = culling_shader.reflection.pipeline_layout(gpu, descriptor_sets);
+    const std::vector<VkPushConstantRange>& ranges = culling_shader.reflection.push_constants;
+    if (ranges.size() != 1 || ranges[0].offset + ranges[0].size != sizeof(CullingConstants))
+    {
+        THROW_ERROR("the push constants of the culling shader don't match the culling constants")
+    }
+    VkDescriptorSet set = _set(descriptor_sets, frame_index, culling_shader);
+    CullingConstants constants;
+    std::copy(&view.frustum[0][0], &view.frustum[0][0] + 24, &constants.frustum[0][0]);
+    std::copy(view.camera, view.camera + 3, constants.camera);
+    constants.meshlet_count = _meshlet_count;
+    constants.write_indices = mesh_shaders() ? 0 : 1;
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpu._object_cache->pipeline(state));
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, state.layout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(command_buffer, state.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullingConstants), &constants);
+    vkCmdDispatch(command_buffer, _meshlet_count, 1, 1);
+    // On the async compute queue, the semaphore waited by the frame's rendering makes the results visible
+    if (!async)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        VkPipelineStageFlags stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        stages |= mesh_shaders() ? VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV : 0;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+}
+
+VkPipelineLayout ClusteredMesh::mesh_shader_layout(DescriptorSets& descriptor_sets, const Shader& mesh_shader) const
+{
+    return mesh_shader.reflection.pipeline_layout(gpu, descriptor_sets);
+}
+
+void ClusteredMesh::draw(VkCommandBuffer command_buffer, unsigned int frame_index, DescriptorSets& descriptor_sets, const Shader* mesh_shader) const
+{
+    const FrameOutput& frame = _frames[frame_index];
+    if (mesh_shaders())
+    {
+        if (mesh_shader == nullptr)
+        {
+            THROW_ERROR("the meshlets are drawn by mesh shaders, but no mesh shader was given")
+        }
+        VkDescriptorSet set = _set(descriptor_sets, frame_index, *mesh_shader);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh_shader_layout(descriptor_sets, *mesh_shader), 0, 1, &set, 0, nullptr);
+        gpu._vk_draw_mesh_tasks_indirect(command_buffer, frame.commands->_vk_buffer, 0, 1, sizeof(VkDrawMeshTasksIndirectCommandNV));
+        return;
+    }
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh._vertices->_vk_buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, frame.indices->_vk_buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexedIndirect(command_buffer, frame.commands->_vk_buffer, sizeof(VkDrawMeshTasksIndirectCommandNV), 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+VkDescriptorSetLayout ClusteredMesh::_set_layout(DescriptorSets& descriptor_sets, const Shader& shader) const
+{
+    // The same layout as set 0 of the pipeline layout built from the reflection
+    std::vector<VkDescriptorSetLayoutBinding> layout_bindings;
+    for (const ShaderReflection::Binding& binding : shader.reflection.bindings)
+    {
+        if (binding.set == 0)
+        {
+            layout_bindings.push_back({binding.binding, binding.type, binding.count, binding.stages, nullptr});
+        }
+    }
+    return descriptor_sets.layout(layout_bindings);
+}
+
+VkDescriptorSet ClusteredMesh::_set(DescriptorSets& descriptor_sets, unsigned int frame_index, const Shader& shader) const
+{
+    {
+        std::lock_guard<std::mutex> lock(_descriptor_sets_mutex);
+        if (std::find(_descriptor_sets.begin(), _descriptor_sets.end(), &descriptor_sets) == _descriptor_sets.end())
+        {
+            _descriptor_sets.push_back(&descriptor_sets);
+        }
+    }
+    const FrameOutput& frame = _frames[frame_index];
+    // The bindings of shaders/include/meshlets.glsl: the culling writes 3 to 5, the mesh shader reads 3 and the vertices.
+    // With mesh shaders the culling doesn't write indices, any buffer fills binding 5.
+    VkBuffer buffers[] = {_meshlets->_vk_buffer, _meshlet_vertices->_vk_buffer, _meshlet_triangles->_vk_buffer, frame.visible->_vk_buffer,
+                          frame.commands->_vk_buffer, (frame.indices != nullptr) ? frame.indices->_vk_buffer : frame.visible->_vk_buffer,
+                          mesh._vertices->_vk_buffer};
+    std::vector<DescriptorWrite> writes;
+    for (const ShaderReflection::Binding& binding : shader.reflection.bindings)
+    {
+        if (binding.set != 0)
+        {
+            continue;
+        }
+        if (binding.binding >= std::size(buffers) || binding.type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+        {
+            THROW_ERROR("the binding '" + binding.name + "' of the shader is not a meshlet buffer")
+        }
+        DescriptorWrite write;
+        write.binding = binding.binding;
+        write.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.buffer = {buffers[binding.binding], 0, VK_WHOLE_SIZE};
+        writes.push_back(write);
+    }
+    return descriptor_sets.immutable_set(_set_layout(descriptor_sets, shader), writes);
+}
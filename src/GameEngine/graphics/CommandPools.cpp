@@ -0,0 +1,81 @@
+#include <GameEngine/graphics/CommandPools.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+using namespace GameEngine;
+
+CommandPools::CommandPools(const GPU& _gpu, uint32_t queue_family, unsigned int max_frames_in_flight, unsigned int max_threads) : gpu(_gpu)
+{
+    _queue_family = queue_family;
+    _max_threads = max_threads;
+    _pools.resize(max_frames_in_flight, std::vector<ThreadPool>(max_threads));
+}
+
+CommandPools::~CommandPools()
+{
+    for (std::vector<ThreadPool>& frame_pools : _pools)
+    {
+        for (ThreadPool& thread_pool : frame_pools)
+        {
+            // destroying a pool frees its command buffers
+            vkDestroyCommandPool(gpu._logical_device, thread_pool.pool, HostAllocator::callbacks());
+        }
+    }
+}
+
+VkCommandBuffer CommandPools::_allocate(unsigned int frame_index, VkCommandBufferLevel level)
+{
+    unsigned int thread_index = Utilities::thread_index();
+    if (thread_index >= _max_threads)
+    {
+        THROW_ERROR("Too many threads recording command buffers, the maximum is " + std::to_string(_max_threads))
+    }
+    // A job using the thread's pools must not be resumed by another thread after a wait
+    JobSystem::bind_to_thread();
+    ThreadPool& thread_pool = _pools[frame_index][thread_index];
+    // The pool is created by the first thread using it, so that pools are only created for recording threads
+    if (thread_pool.pool == VK_NULL_HANDLE)
+    {
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        pool_info.queueFamilyIndex = _queue_family;
+        if (vkCreateCommandPool(gpu._logical_device, &pool_info, HostAllocator::callbacks(), &thread_pool.pool) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the command pool")
+        }
+    }
+    // Reuse the command buffers allocated in previous uses of the frame, as resetting the pool reset them
+    bool primary = (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    std::vector<VkCommandBuffer>& buffers = primary ? thread_pool.primaries : thread_pool.secondaries;
+    size_t& used = primary ? thread_pool.used_primaries : thread_pool.used_secondaries;
+    if (used == buffers.size())
+    {
+        VkCommandBuffer command_buffer;
+        VkCommandBufferAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.commandPool = thread_pool.pool;
+        allocate_info.level = level;
+        allocate_info.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(gpu._logical_device, &allocate_info, &command_buffer) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to allocate the command buffer")
+        }
+        buffers.push_back(command_buffer);
+    }
+    return buffers[used++];
+}
+
+void CommandPools::_reset(unsigned int frame_index)
+{
+    for (ThreadPool& thread_pool : _pools[frame_index])
+    {
+        if (thread_pool.pool != VK_NULL_HANDLE && (thread_pool.used_primaries > 0 || thread_pool.used_secondaries > 0))
+        {
+            vkResetCommandPool(gpu._logical_device, thread_pool.pool, 0);
+            thread_pool.used_primaries = 0;
+            thread_pool.used_secondaries = 0;
+        }
+    }
+}
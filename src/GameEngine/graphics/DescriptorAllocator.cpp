@@ -0,0 +1,125 @@
+#include <GameEngine/graphics/DescriptorAllocator.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <algorithm>
+using namespace GameEngine;
+
+const std::vector<DescriptorAllocator::PoolRatio> DescriptorAllocator::_pool_ratios = {
+    {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f}
+};
+
+DescriptorAllocator::DescriptorAllocator(const GPU& _gpu, VkDescriptorPoolCreateFlags flags, uint32_t initial_sets_per_pool) : gpu(_gpu)
+{
+    _flags = flags;
+    _sets_per_pool = initial_sets_per_pool;
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    for (VkDescriptorPool pool : _used_pools)
+    {
+        vkDestroyDescriptorPool(gpu._logical_device, pool, HostAllocator::callbacks());
+    }
+    for (VkDescriptorPool pool : _free_pools)
+    {
+        vkDestroyDescriptorPool(gpu._logical_device, pool, HostAllocator::callbacks());
+    }
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, uint32_t variable_count, VkDescriptorPool* pool)
+{
+    if (_current_pool == VK_NULL_HANDLE)
+    {
+        _current_pool = _grab_pool();
+    }
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variable_info{};
+    variable_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variable_info.descriptorSetCount = 1;
+    variable_info.pDescriptorCounts = &variable_count;
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.pNext = (variable_count > 0) ? &variable_info : nullptr;
+    allocate_info.descriptorPool = _current_pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &layout;
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(gpu._logical_device, &allocate_info, &set);
+    // The pool is full: continue with a new one
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        _current_pool = _grab_pool();
+        allocate_info.descriptorPool = _current_pool;
+        result = vkAllocateDescriptorSets(gpu._logical_device, &allocate_info, &set);
+    }
+    if (result != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to allocate the descriptor set")
+    }
+    if (pool != nullptr)
+    {
+        *pool = _current_pool;
+    }
+    return set;
+}
+
+void DescriptorAllocator::free(VkDescriptorSet set, VkDescriptorPool pool)
+{
+    if (!(_flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT))
+    {
+        THROW_ERROR("the sets of this descriptor allocator can't be freed individually")
+    }
+    vkFreeDescriptorSets(gpu._logical_device, pool, 1, &set);
+}
+
+void DescriptorAllocator::reset()
+{
+    for (VkDescriptorPool pool : _used_pools)
+    {
+        vkResetDescriptorPool(gpu._logical_device, pool, 0);
+        _free_pools.push_back(pool);
+    }
+    _used_pools.clear();
+    _current_pool = VK_NULL_HANDLE;
+}
+
+VkDescriptorPool DescriptorAllocator::_grab_pool()
+{
+    VkDescriptorPool pool;
+    if (!_free_pools.empty())
+    {
+        pool = _free_pools.back();
+        _free_pools.pop_back();
+    }
+    else
+    {
+        std::vector<VkDescriptorPoolSize> pool_sizes;
+        for (const PoolRatio& pool_ratio : _pool_ratios)
+        {
+            pool_sizes.push_back({pool_ratio.type, std::max(static_cast<uint32_t>(pool_ratio.ratio * _sets_per_pool), uint32_t(1))});
+        }
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.flags = _flags;
+        pool_info.maxSets = _sets_per_pool;
+        pool_info.poolSizeCount = pool_sizes.size();
+        pool_info.pPoolSizes = pool_sizes.data();
+        if (vkCreateDescriptorPool(gpu._logical_device, &pool_info, HostAllocator::callbacks(), &pool) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the descriptor pool")
+        }
+        // Each new pool is bigger, so that the number of pools stays small
+        _sets_per_pool = std::min(_sets_per_pool * 2, _max_sets_per_pool);
+    }
+    _used_pools.push_back(pool);
+    return pool;
+}
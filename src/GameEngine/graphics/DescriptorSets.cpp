@@ -0,0 +1,266 @@
+#include <GameEngine/graphics/DescriptorSets.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <algorithm>
+using namespace GameEngine;
+
+DescriptorSets::DescriptorSets(const GPU& _gpu, unsigned int max_frames_in_flight, unsigned int max_threads) : gpu(_gpu), _immutable_allocator(_gpu, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+{
+    _max_threads = max_threads;
+    _frame_allocators.resize(max_frames_in_flight);
+    for (std::vector<std::unique_ptr<DescriptorAllocator>>& allocators : _frame_allocators)
+    {
+        allocators.resize(max_threads);
+    }
+}
+
+DescriptorSets::~DescriptorSets()
+{
+    for (std::pair<const LayoutKey, VkDescriptorSetLayout>& layout : _layouts)
+    {
+        vkDestroyDescriptorSetLayout(gpu._logical_device, layout.second, HostAllocator::callbacks());
+    }
+}
+
+VkDescriptorSetLayout DescriptorSets::layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags)
+{
+    LayoutKey key;
+    key.bindings = bindings;
+    key.flags = flags;
+    // The order of the bindings doesn't matter to Vulkan, so it doesn't matter to the cache either
+    std::sort(key.bindings.begin(), key.bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {return a.binding < b.binding;});
+    for (VkDescriptorSetLayoutBinding& binding : key.bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            key.immutable_samplers.insert(key.immutable_samplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+        }
+    }
+    std::lock_guard<std::mutex> lock(_layout_mutex);
+    std::unordered_map<LayoutKey, VkDescriptorSetLayout, KeyHash>::iterator it = _layouts.find(key);
+    if (it != _layouts.end())
+    {
+        return it->second;
+    }
+    std::vector<VkDescriptorSetLayoutBinding> sorted_bindings = key.bindings;
+    size_t sampler_index = 0;
+    for (VkDescriptorSetLayoutBinding& binding : sorted_bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            binding.pImmutableSamplers = key.immutable_samplers.data() + sampler_index;
+            sampler_index += binding.descriptorCount;
+        }
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.flags = flags;
+    layout_info.bindingCount = sorted_bindings.size();
+    layout_info.pBindings = sorted_bindings.data();
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(gpu._logical_device, &layout_info, HostAllocator::callbacks(), &layout) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the descriptor set layout")
+    }
+    _layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+VkDescriptorSet DescriptorSets::frame_set(unsigned int frame_index, VkDescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes)
+{
+    unsigned int thread_index = Utilities::thread_index();
+    if (thread_index >= _max_threads)
+    {
+        THROW_ERROR("Too many threads allocating descriptor sets, the maximum is " + std::to_string(_max_threads))
+    }
+    // A job using the thread's pools must not be resumed by another thread after a wait
+    JobSystem::bind_to_thread();
+    // Each thread allocates from its own pools, so no locking is needed
+    std::unique_ptr<DescriptorAllocator>& allocator = _frame_allocators[frame_index][thread_index];
+    if (allocator == nullptr)
+    {
+        allocator.reset(new DescriptorAllocator(gpu));
+    }
+    VkDescriptorSet set = allocator->allocate(layout);
+    _write(set, writes);
+    return set;
+}
+
+VkDescriptorSet DescriptorSets::immutable_set(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes)
+{
+    SetKey key;
+    key.layout = layout;
+    key.writes = writes;
+    std::sort(key.writes.begin(), key.writes.end(), [](const DescriptorWrite& a, const DescriptorWrite& b) {return a.binding < b.binding;});
+    std::lock_guard<std::mutex> lock(_immutable_mutex);
+    std::unordered_map<SetKey, std::pair<VkDescriptorSet, VkDescriptorPool>, KeyHash>::iterator it = _immutable_sets.find(key);
+    if (it != _immutable_sets.end())
+    {
+        return it->second.first;
+    }
+    VkDescriptorPool pool;
+    VkDescriptorSet set = _immutable_allocator.allocate(layout, 0, &pool);
+    _write(set, key.writes);
+    _immutable_sets.emplace(std::move(key), std::make_pair(set, pool));
+    return set;
+}
+
+template<typename Uses>
+void DescriptorSets::_evict(Uses uses)
+{
+    std::lock_guard<std::mutex> lock(_immutable_mutex);
+    for (std::unordered_map<SetKey, std::pair<VkDescriptorSet, VkDescriptorPool>, KeyHash>::iterator it = _immutable_sets.begin(); it != _immutable_sets.end();)
+    {
+        if (std::any_of(it->first.writes.begin(), it->first.writes.end(), uses))
+        {
+            _immutable_allocator.free(it->second.first, it->second.second);
+            it = _immutable_sets.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void DescriptorSets::evict_buffer(VkBuffer buffer)
+{
+    _evict([buffer](const DescriptorWrite& write) {return write.buffer.buffer == buffer;});
+}
+
+void DescriptorSets::evict_image_view(VkImageView image_view)
+{
+    _evict([image_view](const DescriptorWrite& write) {return write.image.imageView == image_view;});
+}
+
+void DescriptorSets::evict_texel_buffer(VkBufferView texel_buffer)
+{
+    _evict([texel_buffer](const DescriptorWrite& write) {return write.texel_buffer == texel_buffer;});
+}
+
+bool DescriptorSets::LayoutKey::operator==(const LayoutKey& other) const
+{
+    if (flags != other.flags || bindings.size() != other.bindings.size() || immutable_samplers != other.immutable_samplers)
+    {
+        return false;
+    }
+    for (size_t i=0; i<bindings.size(); i++)
+    {
+        const VkDescriptorSetLayoutBinding& a = bindings[i];
+        const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+        if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+            a.stageFlags != b.stageFlags || (a.pImmutableSamplers == nullptr) != (b.pImmutableSamplers == nullptr))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DescriptorSets::SetKey::operator==(const SetKey& other) const
+{
+    if (layout != other.layout || writes.size() != other.writes.size())
+    {
+        return false;
+    }
+    for (size_t i=0; i<writes.size(); i++)
+    {
+        const DescriptorWrite& a = writes[i];
+        const DescriptorWrite& b = other.writes[i];
+        if (a.binding != b.binding || a.type != b.type ||
+            a.buffer.buffer != b.buffer.buffer || a.buffer.offset != b.buffer.offset || a.buffer.range != b.buffer.range ||
+            a.image.sampler != b.image.sampler || a.image.imageView != b.image.imageView || a.image.imageLayout != b.image.imageLayout ||
+            a.texel_buffer != b.texel_buffer)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t DescriptorSets::KeyHash::operator()(const LayoutKey& key) const
+{
+    // Fields are hashed one by one, as the padding bytes of the structures are undefined
+    uint64_t hash = Utilities::hash(&key.flags, sizeof(key.flags));
+    for (const VkDescriptorSetLayoutBinding& binding : key.bindings)
+    {
+        hash = Utilities::hash(&binding.binding, sizeof(binding.binding), hash);
+        hash = Utilities::hash(&binding.descriptorType, sizeof(binding.descriptorType), hash);
+        hash = Utilities::hash(&binding.descriptorCount, sizeof(binding.descriptorCount), hash);
+        hash = Utilities::hash(&binding.stageFlags, sizeof(binding.stageFlags), hash);
+    }
+    if (!key.immutable_samplers.empty())
+    {
+        hash = Utilities::hash(key.immutable_samplers.data(), key.immutable_samplers.size() * sizeof(VkSampler), hash);
+    }
+    return static_cast<size_t>(hash);
+}
+
+size_t DescriptorSets::KeyHash::operator()(const SetKey& key) const
+{
+    uint64_t hash = Utilities::hash(&key.layout, sizeof(key.layout));
+    for (const DescriptorWrite& write : key.writes)
+    {
+        hash = Utilities::hash(&write.binding, sizeof(write.binding), hash);
+        hash = Utilities::hash(&write.type, sizeof(write.type), hash);
+        hash = Utilities::hash(&write.buffer.buffer, sizeof(write.buffer.buffer), hash);
+        hash = Utilities::hash(&write.buffer.offset, sizeof(write.buffer.offset), hash);
+        hash = Utilities::hash(&write.buffer.range, sizeof(write.buffer.range), hash);
+        hash = Utilities::hash(&write.image.sampler, sizeof(write.image.sampler), hash);
+        hash = Utilities::hash(&write.image.imageView, sizeof(write.image.imageView), hash);
+        hash = Utilities::hash(&write.image.imageLayout, sizeof(write.image.imageLayout), hash);
+        hash = Utilities::hash(&write.texel_buffer, sizeof(write.texel_buffer), hash);
+    }
+    return static_cast<size_t>(hash);
+}
+
+void DescriptorSets::_reset(unsigned int frame_index)
+{
+    for (std::unique_ptr<DescriptorAllocator>& allocator : _frame_allocators[frame_index])
+    {
+        if (allocator != nullptr)
+        {
+            allocator->reset();
+        }
+    }
+}
+
+void DescriptorSets::_write(VkDescriptorSet set, const std::vector<DescriptorWrite>& writes)
+{
+    // Reused by each thread, so that writing sets does no allocation once it is big enough
+    thread_local std::vector<VkWriteDescriptorSet> vk_writes;
+    vk_writes.resize(writes.size());
+    for (size_t i=0; i<writes.size(); i++)
+    {
+        const DescriptorWrite& write = writes[i];
+        VkWriteDescriptorSet& vk_write = vk_writes[i];
+        vk_write = {};
+        vk_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        vk_write.dstSet = set;
+        vk_write.dstBinding = write.binding;
+        vk_write.descriptorCount = 1;
+        vk_write.descriptorType = write.type;
+        bool is_image = (write.type == VK_DESCRIPTOR_TYPE_SAMPLER || write.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+                         write.type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || write.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+                         write.type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+        bool is_texel_buffer = (write.type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || write.type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER);
+        if (is_image)
+        {
+            vk_write.pImageInfo = &write.image;
+        }
+        else if (is_texel_buffer)
+        {
+            vk_write.pTexelBufferView = &write.texel_buffer;
+        }
+        else
+        {
+            vk_write.pBufferInfo = &write.buffer;
+        }
+    }
+    if (!vk_writes.empty())
+    {
+        vkUpdateDescriptorSets(gpu._logical_device, vk_writes.size(), vk_writes.data(), 0, nullptr);
+    }
+}
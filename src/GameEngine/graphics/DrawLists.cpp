@@ -0,0 +1,66 @@
+#include <GameEngine/graphics/DrawLists.hpp>
+#include <GameEngine/graphics/CommandPools.hpp>
+#include <GameEngine/graphics/FrameAllocators.hpp>
+using namespace GameEngine;
+
+DrawLists::DrawLists(CommandPools& pools, FrameAllocators& allocators, unsigned int frame_index, unsigned int count,
+                     VkRenderPass render_pass, uint32_t subpass, VkFramebuffer framebuffer) :
+    _pools(pools), _allocators(allocators), _command_buffers(allocators.get(frame_index))
+{
+    _frame_index = frame_index;
+    _inheritance = {};
+    _inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    _inheritance.renderPass = render_pass;
+    _inheritance.subpass = subpass;
+    _inheritance.framebuffer = framebuffer;
+    _command_buffers.resize(count, VK_NULL_HANDLE);
+}
+
+DrawLists::~DrawLists()
+{
+}
+
+unsigned int DrawLists::size() const
+{
+    return _command_buffers.size();
+}
+
+void DrawLists::record(unsigned int index, const std::function<void(VkCommandBuffer)>& recording)
+{
+    VkCommandBuffer command_buffer = _pools._allocate(_frame_index, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (_inheritance.renderPass != VK_NULL_HANDLE)
+    {
+        begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    }
+    begin_info.pInheritanceInfo = &_inheritance;
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to begin recording the draw list")
+    }
+    recording(command_buffer);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to record the draw list")
+    }
+    _command_buffers[index] = command_buffer;
+}
+
+void DrawLists::execute(VkCommandBuffer primary) const
+{
+    ArenaVector<VkCommandBuffer> recorded(_allocators.get(_frame_index));
+    recorded.reserve(_command_buffers.size());
+    for (VkCommandBuffer command_buffer : _command_buffers)
+    {
+        if (command_buffer != VK_NULL_HANDLE)
+        {
+            recorded.push_back(command_buffer);
+        }
+    }
+    if (recorded.size() > 0)
+    {
+        vkCmdExecuteCommands(primary, recorded.size(), recorded.data());
+    }
+}
@@ -0,0 +1,144 @@
+#include <GameEngine/graphics/DynamicResolution.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <algorithm>
+#include <cmath>
+using namespace GameEngine;
+
+DynamicResolution::DynamicResolution(const GPU& _gpu, unsigned int max_frames_in_flight) : gpu(_gpu)
+{
+    // Check that the graphics queue can write timestamps
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu._physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu._physical_device, &queue_family_count, queue_families.data());
+    uint32_t valid_bits = 0;
+    if (gpu._graphics_family.has_value())
+    {
+        valid_bits = queue_families[gpu._graphics_family.value()].timestampValidBits;
+    }
+    _timestamps_supported = (valid_bits > 0);
+    _timestamp_mask = (valid_bits >= 64) ? ~uint64_t(0) : ((uint64_t(1) << valid_bits) - 1);
+    // Create two timestamp queries per frame in flight
+    _queries_written.resize(max_frames_in_flight, false);
+    if (_timestamps_supported)
+    {
+        VkQueryPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        pool_info.queryCount = 2 * max_frames_in_flight;
+        if (vkCreateQueryPool(gpu._logical_device, &pool_info, HostAllocator::callbacks(), &_vk_query_pool) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the timestamp query pool")
+        }
+    }
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    vkDestroyQueryPool(gpu._logical_device, _vk_query_pool, HostAllocator::callbacks());
+}
+
+double DynamicResolution::scale() const
+{
+    return _scale;
+}
+
+double DynamicResolution::gpu_frame_time() const
+{
+    return _gpu_frame_time;
+}
+
+bool DynamicResolution::_supported(VkFormat output_format) const
+{
+    if (!_timestamps_supported)
+    {
+        return false;
+    }
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(gpu._physical_device, output_format, &properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+void DynamicResolution::_begin(VkCommandBuffer command_buffer, unsigned int frame_index, VkExtent2D output_extent, VkFormat output_format)
+{
+    // The frame's fence was waited for, so the timestamps of its previous use are available
+    if (_queries_written[frame_index])
+    {
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(gpu._logical_device, _vk_query_pool, 2*frame_index, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+        {
+            uint64_t ticks = (timestamps[1] - timestamps[0]) & _timestamp_mask;
+            _update_scale(ticks * gpu._device_properties.limits.timestampPeriod * 1.0E-9);
+        }
+        _queries_written[frame_index] = false;
+    }
+    // (Re)allocate the render target at the full output resolution
+    if (!_render_target || _render_target->width != output_extent.width || _render_target->height != output_extent.height
+        || _render_target->_vk_image_format != output_format)
+    {
+        {
+            std::lock_guard<std::mutex> queue_lock(*gpu._queue_mutex);
+            vkDeviceWaitIdle(gpu._logical_device);
+        }
+        _render_target.reset();
+        _render_target = std::make_unique<Image>(gpu, output_extent.width, output_extent.height, output_format,
+                                                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    }
+    double scale = std::min(_scale, 1.);
+    _render_extent.width = std::max(static_cast<uint32_t>(output_extent.width * scale), uint32_t(1));
+    _render_extent.height = std::max(static_cast<uint32_t>(output_extent.height * scale), uint32_t(1));
+    vkCmdResetQueryPool(command_buffer, _vk_query_pool, 2*frame_index, 2);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _vk_query_pool, 2*frame_index);
+}
+
+void DynamicResolution::_end(VkCommandBuffer command_buffer, unsigned int frame_index)
+{
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _vk_query_pool, 2*frame_index+1);
+    _queries_written[frame_index] = true;
+}
+
+void DynamicResolution::_upscale(VkCommandBuffer command_buffer, VkImage output_image, VkExtent2D output_extent)
+{
+    Image::_layout_transition(command_buffer, _render_target->_vk_image,
+                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    VkImageBlit blit{};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1] = {static_cast<int32_t>(_render_extent.width), static_cast<int32_t>(_render_extent.height), 1};
+    blit.dstSubresource = blit.srcSubresource;
+    blit.dstOffsets[1] = {static_cast<int32_t>(output_extent.width), static_cast<int32_t>(output_extent.height), 1};
+    vkCmdBlitImage(command_buffer, _render_target->_vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   output_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+}
+
+void DynamicResolution::_update_scale(double frame_time)
+{
+    _accumulated_time += frame_time;
+    _accumulated_frames += 1;
+    if (_accumulated_frames < std::max(adjustment_period, 1u))
+    {
+        return;
+    }
+    _gpu_frame_time = _accumulated_time / _accumulated_frames;
+    _accumulated_time = 0.;
+    _accumulated_frames = 0;
+    // Between the increase threshold and the budget, the scale is left unchanged
+    bool over_budget = (_gpu_frame_time > target_frame_time);
+    bool under_budget = (_gpu_frame_time < increase_threshold * target_frame_time);
+    if (!over_budget && !under_budget)
+    {
+        return;
+    }
+    // The GPU time is roughly proportional to the number of pixels, so to the square of the scale.
+    // The scale is set to reach the middle of the hysteresis band, with a limited step so that a single spike doesn't collapse the resolution.
+    double goal = 0.5 * (1. + increase_threshold) * target_frame_time;
+    double new_scale = (_gpu_frame_time > 0.) ? _scale * std::sqrt(goal / _gpu_frame_time) : max_scale;
+    new_scale = std::clamp(new_scale, 0.8 * _scale, 1.1 * _scale);
+    _scale = std::clamp(new_scale, min_scale, max_scale);
+}
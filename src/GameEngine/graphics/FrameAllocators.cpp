@@ -0,0 +1,42 @@
+#include <GameEngine/graphics/FrameAllocators.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+using namespace GameEngine;
+
+FrameAllocators::FrameAllocators(unsigned int max_frames_in_flight, unsigned int max_threads, size_t block_size)
+{
+    _max_threads = max_threads;
+    _allocators.resize(max_frames_in_flight);
+    for (std::vector<LinearAllocator>& frame_allocators : _allocators)
+    {
+        frame_allocators.reserve(max_threads);
+        for (unsigned int i=0; i<max_threads; i++)
+        {
+            frame_allocators.emplace_back(block_size);
+        }
+    }
+}
+
+FrameAllocators::~FrameAllocators()
+{
+}
+
+LinearAllocator& FrameAllocators::get(unsigned int frame_index)
+{
+    unsigned int thread_index = Utilities::thread_index();
+    if (thread_index >= _max_threads)
+    {
+        THROW_ERROR("Too many threads using frame allocators, the maximum is " + std::to_string(_max_threads))
+    }
+    // A job using the thread's allocator must not be resumed by another thread after a wait
+    JobSystem::bind_to_thread();
+    return _allocators[frame_index][thread_index];
+}
+
+void FrameAllocators::_reset(unsigned int frame_index)
+{
+    for (LinearAllocator& allocator : _allocators[frame_index])
+    {
+        allocator.reset();
+    }
+}
@@ -1,4 +1,6 @@
 #include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
 #include <GameEngine/utilities/Macro.hpp>
 #include <set>
 #include <GameEngine/user_interface/Handles.hpp>
@@ -40,6 +42,87 @@ GPU::GPU(VkPhysicalDevice device, const Handles& events, const std::vector<std::
     }
     // Check if swap chain extension is supported
     bool swap_chain_supported = (_enabled_extensions.find(VK_KHR_SWAPCHAIN_EXTENSION_NAME) != _enabled_extensions.end());
+    // Check if waiting for an image to be displayed, and indexing descriptor arrays from shaders (core in Vulkan 1.2) are supported
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {};
+    present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {};
+    present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {};
+    indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceMeshShaderFeaturesNV mesh_shader_features = {};
+    mesh_shader_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_NV;
+    bool mesh_shader_available = _enabled_extensions.find(VK_NV_MESH_SHADER_EXTENSION_NAME) != _enabled_extensions.end();
+    bool present_wait_available = _enabled_extensions.find(VK_KHR_PRESENT_ID_EXTENSION_NAME) != _enabled_extensions.end() &&
+                                  _enabled_extensions.find(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) != _enabled_extensions.end();
+    bool indexing_available = _device_properties.apiVersion >= VK_API_VERSION_1_2 ||
+                              _enabled_extensions.find(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) != _enabled_extensions.end();
+    if (_device_properties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        if (present_wait_available)
+        {
+            present_wait_features.pNext = &present_id_features;
+            features.pNext = &present_wait_features;
+        }
+        if (indexing_available)
+        {
+            indexing_features.pNext = features.pNext;
+            features.pNext = &indexing_features;
+        }
+        if (mesh_shader_available)
+        {
+            mesh_shader_features.pNext = features.pNext;
+            features.pNext = &mesh_shader_features;
+        }
+        vkGetPhysicalDeviceFeatures2(device, &features);
+        if (mesh_shader_available)
+        {
+            VkPhysicalDeviceMeshShaderPropertiesNV mesh_shader_properties = {};
+            mesh_shader_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_PROPERTIES_NV;
+            VkPhysicalDeviceProperties2 properties = {};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties.pNext = &mesh_shader_properties;
+            vkGetPhysicalDeviceProperties2(device, &properties);
+            _max_draw_mesh_tasks_count = mesh_shader_properties.maxDrawMeshTasksCount;
+        }
+    }
+    _present_wait_enabled = present_id_features.presentId && present_wait_features.presentWait;
+    _mesh_shader_enabled = mesh_shader_features.meshShader;
+    _bindless_enabled = indexing_features.runtimeDescriptorArray && indexing_features.descriptorBindingPartiallyBound &&
+                        indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+                        indexing_features.shaderSampledImageArrayNonUniformIndexing && indexing_features.shaderStorageBufferArrayNonUniformIndexing &&
+                        indexing_features.descriptorBindingSampledImageUpdateAfterBind && indexing_features.descriptorBindingStorageBufferUpdateAfterBind;
+    // Only the used features are enabled
+    VkPhysicalDeviceDescriptorIndexingFeatures enabled_indexing_features = {};
+    enabled_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    enabled_indexing_features.runtimeDescriptorArray = _bindless_enabled;
+    enabled_indexing_features.descriptorBindingPartiallyBound = _bindless_enabled;
+    enabled_indexing_features.descriptorBindingUpdateUnusedWhilePending = _bindless_enabled;
+    enabled_indexing_features.shaderSampledImageArrayNonUniformIndexing = _bindless_enabled;
+    enabled_indexing_features.shaderStorageBufferArrayNonUniformIndexing = _bindless_enabled;
+    enabled_indexing_features.descriptorBindingSampledImageUpdateAfterBind = _bindless_enabled;
+    enabled_indexing_features.descriptorBindingStorageBufferUpdateAfterBind = _bindless_enabled;
+    void* enabled_features = nullptr;
+    if (_present_wait_enabled)
+    {
+        present_id_features.pNext = nullptr;
+        present_wait_features.pNext = &present_id_features;
+        enabled_features = &present_wait_features;
+    }
+    if (_bindless_enabled)
+    {
+        enabled_indexing_features.pNext = enabled_features;
+        enabled_features = &enabled_indexing_features;
+    }
+    VkPhysicalDeviceMeshShaderFeaturesNV enabled_mesh_shader_features = {};
+    enabled_mesh_shader_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_NV;
+    enabled_mesh_shader_features.meshShader = _mesh_shader_enabled;
+    if (_mesh_shader_enabled)
+    {
+        enabled_mesh_shader_features.pNext = enabled_features;
+        enabled_features = &enabled_mesh_shader_features;
+    }
     // Select the best matching queue families for each application
     std::map<uint32_t, uint32_t> selected_families_count;
     _graphics_family = _select_queue_family(queue_families, VK_QUEUE_GRAPHICS_BIT, selected_families_count);
@@ -70,11 +153,25 @@ GPU::GPU(VkPhysicalDevice device, const Handles& events, const std::vector<std::
     device_info.pEnabledFeatures = &_device_features;
     device_info.ppEnabledExtensionNames = enabled_extensions.data();
     device_info.enabledExtensionCount = enabled_extensions.size();
-    VkResult result = vkCreateDevice(_physical_device, &device_info, nullptr, &_logical_device);
+    device_info.pNext = enabled_features;
+    VkResult result = vkCreateDevice(_physical_device, &device_info, HostAllocator::callbacks(), &_logical_device);
     if (result != VK_SUCCESS)
     {
         THROW_ERROR("failed to create logical device")
     }
+    _object_cache = std::make_shared<ObjectCache>(_logical_device);
+    // The copies of the GPU share the device: the last one releasing it destroys the cached objects, then the device
+    std::shared_ptr<ObjectCache> object_cache = _object_cache;
+    _device.reset(_logical_device, [object_cache](VkDevice device) mutable
+    {
+        object_cache.reset();
+        vkDestroyDevice(device, HostAllocator::callbacks());
+    });
+    if (_mesh_shader_enabled)
+    {
+        _vk_draw_mesh_tasks_indirect = (PFN_vkCmdDrawMeshTasksIndirectNV) vkGetDeviceProcAddr(_logical_device, "vkCmdDrawMeshTasksIndirectNV");
+    }
+    _queue_mutex = std::make_shared<std::mutex>();
     // retrieve the queue handles
     _query_queue_handle(_graphics_queue, _graphics_family, selected_families_count);
     _query_queue_handle(_transfer_queue, _transfer_family, selected_families_count);
@@ -96,7 +193,6 @@ GPU::GPU(const GPU& other)
 
 GPU::~GPU()
 {
-    vkDestroyDevice(_logical_device, nullptr);
 }
 
 std::string GPU::device_name() const
@@ -235,12 +331,37 @@ void GPU::operator=(const GPU& other)
     _device_properties = other._device_properties;
     _device_features = other._device_features;
     _device_memory = other._device_memory;
+    _graphics_family = other._graphics_family;
+    _transfer_family = other._transfer_family;
+    _compute_family = other._compute_family;
+    _present_family = other._present_family;
     _graphics_queue = other._graphics_queue;
     _compute_queue = other._compute_queue;
     _transfer_queue = other._transfer_queue;
     _present_queue = other._present_queue;
     _enabled_extensions = other._enabled_extensions;
+    _present_wait_enabled = other._present_wait_enabled;
+    _bindless_enabled = other._bindless_enabled;
+    _mesh_shader_enabled = other._mesh_shader_enabled;
+    _vk_draw_mesh_tasks_indirect = other._vk_draw_mesh_tasks_indirect;
+    _max_draw_mesh_tasks_count = other._max_draw_mesh_tasks_count;
     _logical_device = other._logical_device;
+    // The previous cache must be released before the previous device, whose deleter destroys it
+    _object_cache = other._object_cache;
+    _device = other._device;
+    _queue_mutex = other._queue_mutex;
+}
+
+uint32_t GPU::_find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i=0; i<_device_memory.memoryTypeCount; i++)
+    {
+        if ((type_bits & (1 << i)) && (_device_memory.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    THROW_ERROR("failed to find a suitable memory type")
 }
 
 std::optional<uint32_t> GPU::_select_queue_family(std::vector<VkQueueFamilyProperties>& queue_families,
@@ -0,0 +1,225 @@
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+using namespace GameEngine;
+
+std::atomic<bool> HostAllocator::pooling(true);
+VkAllocationCallbacks HostAllocator::_callbacks = {nullptr, &HostAllocator::_allocate, &HostAllocator::_reallocate, &HostAllocator::_free,
+                                                   &HostAllocator::_internal_allocation, &HostAllocator::_internal_free};
+HostAllocator::Counters HostAllocator::_counters[HostAllocator::n_scopes];
+HostAllocator::Counters HostAllocator::_total_counters;
+std::mutex HostAllocator::_pool_mutexes[HostAllocator::n_size_classes];
+std::vector<void*> HostAllocator::_free_blocks[HostAllocator::n_size_classes];
+
+const VkAllocationCallbacks* HostAllocator::callbacks()
+{
+    return &_callbacks;
+}
+
+HostAllocator::Statistics HostAllocator::statistics(VkSystemAllocationScope scope)
+{
+    Statistics statistics;
+    if (static_cast<unsigned int>(scope) >= n_scopes)
+    {
+        return statistics;
+    }
+    const Counters& counters = _counters[scope];
+    statistics.bytes = counters.bytes.load();
+    statistics.count = counters.count.load();
+    statistics.peak_bytes = counters.peak_bytes.load();
+    statistics.total_allocations = counters.total_allocations.load();
+    statistics.internal_bytes = counters.internal_bytes.load();
+    return statistics;
+}
+
+HostAllocator::Statistics HostAllocator::total()
+{
+    Statistics sum;
+    for (unsigned int i=0; i<n_scopes; i++)
+    {
+        Statistics scope_statistics = statistics(static_cast<VkSystemAllocationScope>(i));
+        sum.bytes += scope_statistics.bytes;
+        sum.count += scope_statistics.count;
+        sum.total_allocations += scope_statistics.total_allocations;
+        sum.internal_bytes += scope_statistics.internal_bytes;
+    }
+    // The scopes don't peak at the same time, so the peak of the sum is tracked on its own
+    sum.peak_bytes = _total_counters.peak_bytes.load();
+    return sum;
+}
+
+std::string HostAllocator::scope_name(VkSystemAllocationScope scope)
+{
+    switch (scope)
+    {
+        case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "command";
+        case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "object";
+        case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "cache";
+        case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "device";
+        case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "instance";
+        default: return "unknown";
+    }
+}
+
+void HostAllocator::report(std::ostream& out)
+{
+    out << "Vulkan host memory:" << std::endl;
+    for (unsigned int i=0; i<n_scopes; i++)
+    {
+        VkSystemAllocationScope scope = static_cast<VkSystemAllocationScope>(i);
+        Statistics scope_statistics = statistics(scope);
+        out << "    " << scope_name(scope) << ": " << scope_statistics.bytes << " bytes in " << scope_statistics.count << " allocations"
+            << " (peak " << scope_statistics.peak_bytes << " bytes, " << scope_statistics.total_allocations << " allocations made, "
+            << scope_statistics.internal_bytes << " internal bytes)" << std::endl;
+    }
+}
+
+void HostAllocator::trim()
+{
+    for (unsigned int i=0; i<n_size_classes; i++)
+    {
+        std::lock_guard<std::mutex> lock(_pool_mutexes[i]);
+        for (void* block : _free_blocks[i])
+        {
+            std::free(block);
+        }
+        _free_blocks[i].clear();
+    }
+}
+
+void* HostAllocator::_allocate(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    (void)user_data;
+    if (size == 0)
+    {
+        return nullptr;
+    }
+    alignment = std::max(alignment, alignof(Header));
+    void* block = nullptr;
+    char* memory = nullptr;
+    int32_t size_class = -1;
+    // Pooled blocks are aligned as the header. malloc only guarantees the alignment of max_align_t, the difference is padded.
+    const size_t pool_padding = (alignof(Header) > alignof(std::max_align_t)) ? alignof(Header) - alignof(std::max_align_t) : 0;
+    if (pooling.load() && alignment <= alignof(Header) && size + sizeof(Header) + pool_padding <= (size_t(64) << (n_size_classes - 1)))
+    {
+        size_class = 0;
+        while ((size_t(64) << size_class) < size + sizeof(Header) + pool_padding)
+        {
+            size_class++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_pool_mutexes[size_class]);
+            if (!_free_blocks[size_class].empty())
+            {
+                block = _free_blocks[size_class].back();
+                _free_blocks[size_class].pop_back();
+            }
+        }
+        if (block == nullptr)
+        {
+            block = std::malloc(size_t(64) << size_class);
+        }
+    }
+    else
+    {
+        block = std::malloc(size + sizeof(Header) + alignment);
+    }
+    if (block == nullptr)
+    {
+        return nullptr;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(block) + sizeof(Header);
+    memory = reinterpret_cast<char*>((start + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    Header* header = reinterpret_cast<Header*>(memory) - 1;
+    header->block = block;
+    header->size = size;
+    header->scope = static_cast<uint32_t>(scope);
+    header->size_class = size_class;
+    if (static_cast<unsigned int>(scope) < n_scopes)
+    {
+        Counters& counters = _counters[scope];
+        size_t bytes = counters.bytes.fetch_add(size) + size;
+        counters.count.fetch_add(1);
+        counters.total_allocations.fetch_add(1);
+        size_t peak = counters.peak_bytes.load();
+        while (bytes > peak && !counters.peak_bytes.compare_exchange_weak(peak, bytes))
+        {
+        }
+        bytes = _total_counters.bytes.fetch_add(size) + size;
+        peak = _total_counters.peak_bytes.load();
+        while (bytes > peak && !_total_counters.peak_bytes.compare_exchange_weak(peak, bytes))
+        {
+        }
+    }
+    return memory;
+}
+
+void* HostAllocator::_reallocate(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    if (original == nullptr)
+    {
+        return _allocate(user_data, size, alignment, scope);
+    }
+    if (size == 0)
+    {
+        _free(user_data, original);
+        return nullptr;
+    }
+    // On failure the original allocation must be left untouched
+    void* memory = _allocate(user_data, size, alignment, scope);
+    if (memory == nullptr)
+    {
+        return nullptr;
+    }
+    const Header* header = static_cast<const Header*>(original) - 1;
+    std::memcpy(memory, original, std::min(size, header->size));
+    _free(user_data, original);
+    return memory;
+}
+
+void HostAllocator::_free(void* user_data, void* memory)
+{
+    (void)user_data;
+    if (memory == nullptr)
+    {
+        return;
+    }
+    const Header* header = static_cast<const Header*>(memory) - 1;
+    if (header->scope < n_scopes)
+    {
+        _counters[header->scope].bytes.fetch_sub(header->size);
+        _counters[header->scope].count.fetch_sub(1);
+        _total_counters.bytes.fetch_sub(header->size);
+    }
+    void* block = header->block;
+    if (header->size_class >= 0)
+    {
+        std::lock_guard<std::mutex> lock(_pool_mutexes[header->size_class]);
+        _free_blocks[header->size_class].push_back(block);
+    }
+    else
+    {
+        std::free(block);
+    }
+}
+
+void HostAllocator::_internal_allocation(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+    (void)user_data;
+    (void)type;
+    if (static_cast<unsigned int>(scope) < n_scopes)
+    {
+        _counters[scope].internal_bytes.fetch_add(size);
+    }
+}
+
+void HostAllocator::_internal_free(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+    (void)user_data;
+    (void)type;
+    if (static_cast<unsigned int>(scope) < n_scopes)
+    {
+        _counters[scope].internal_bytes.fetch_sub(size);
+    }
+}
@@ -0,0 +1,265 @@
+#include <GameEngine/graphics/HotReload.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+using namespace GameEngine;
+
+HotReload::HotReload(const GPU& _gpu, const std::vector<std::string>& directories, const std::string& compiler, DerivedDataCache* cache) :
+    gpu(_gpu), _compiler(compiler), _cache(cache), _watcher(directories)
+{
+    JobSystem::initialize();
+}
+
+HotReload::~HotReload()
+{
+    for (std::unique_ptr<Rebuild>& rebuild : _rebuilds)
+    {
+        JobSystem::wait(rebuild->counter);
+        _discard(*rebuild);
+    }
+}
+
+void HotReload::watch(Shader& shader, const std::string& spirv_path, const std::string& source_path)
+{
+    WatchedShader watched = {&shader, spirv_path, source_path};
+    _shaders[FileWatcher::normalize_path(source_path.empty() ? spirv_path : source_path)].push_back(watched);
+}
+
+void HotReload::watch(const std::string& path, const std::function<void(const std::string&)>& reload)
+{
+    _reloads[FileWatcher::normalize_path(path)].push_back(reload);
+}
+
+void HotReload::forget(const Shader& shader)
+{
+    for (std::unordered_map<std::string, std::vector<WatchedShader>>::iterator it = _shaders.begin(); it != _shaders.end();)
+    {
+        std::vector<WatchedShader>& watched = it->second;
+        watched.erase(std::remove_if(watched.begin(), watched.end(), [&shader](const WatchedShader& w) {return w.shader == &shader;}), watched.end());
+        it = watched.empty() ? _shaders.erase(it) : std::next(it);
+    }
+    _postponed.erase(std::remove_if(_postponed.begin(), _postponed.end(), [&shader](const WatchedShader& w) {return w.shader == &shader;}), _postponed.end());
+    for (size_t i=0; i<_rebuilds.size(); i++)
+    {
+        if (_rebuilds[i]->shader == &shader)
+        {
+            JobSystem::wait(_rebuilds[i]->counter);
+            _discard(*_rebuilds[i]);
+            _rebuilds.erase(_rebuilds.begin() + i);
+            break;
+        }
+    }
+}
+
+void HotReload::update()
+{
+    // Swap in the finished rebuilds
+    for (size_t i=0; i<_rebuilds.size();)
+    {
+        if (_rebuilds[i]->counter.done())
+        {
+            _swap(*_rebuilds[i]);
+            _rebuilds.erase(_rebuilds.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+    std::vector<WatchedShader> postponed;
+    postponed.swap(_postponed);
+    for (const WatchedShader& watched : postponed)
+    {
+        _start(watched);
+    }
+    // Start the rebuilds of the modified files
+    for (const std::string& path : _watcher.changes())
+    {
+        std::unordered_map<std::string, std::vector<WatchedShader>>::iterator shaders = _shaders.find(path);
+        if (shaders != _shaders.end())
+        {
+            for (const WatchedShader& watched : shaders->second)
+            {
+                _start(watched);
+            }
+        }
+        else if (Utilities::extension(path) == "glsl")
+        {
+            // The includes are not tracked: every GLSL shader is rebuilt
+            for (const std::pair<const std::string, std::vector<WatchedShader>>& file : _shaders)
+            {
+                for (const WatchedShader& watched : file.second)
+                {
+                    if (!watched.source_path.empty())
+                    {
+                        _start(watched);
+                    }
+                }
+            }
+        }
+        std::unordered_map<std::string, std::vector<std::function<void(const std::string&)>>>::iterator reloads = _reloads.find(path);
+        if (reloads != _reloads.end())
+        {
+            for (const std::function<void(const std::string&)>& reload : reloads->second)
+            {
+                reload(path);
+            }
+        }
+    }
+}
+
+void HotReload::_start(const WatchedShader& watched)
+{
+    // A shader is rebuilt once at a time, as its module is swapped by the rebuild in progress
+    for (const std::unique_ptr<Rebuild>& rebuild : _rebuilds)
+    {
+        if (rebuild->shader == watched.shader)
+        {
+            bool postponed = std::any_of(_postponed.begin(), _postponed.end(), [&watched](const WatchedShader& w) {return w.shader == watched.shader;});
+            if (!postponed)
+            {
+                _postponed.push_back(watched);
+            }
+            return;
+        }
+    }
+    _rebuilds.emplace_back(new Rebuild());
+    Rebuild& rebuild = *_rebuilds.back();
+    rebuild.shader = watched.shader;
+    rebuild.module = watched.shader->_vk_shader;
+    std::string compiler = _compiler;
+    DerivedDataCache* cache = _cache;
+    std::vector<std::string> directories = _watcher._directories;
+    bool recursive = _watcher._recursive;
+    JobSystem::submit([watched, &rebuild, compiler, cache, directories, recursive]()
+    {
+        _rebuild(watched, rebuild, compiler, cache, directories, recursive);
+    }, &rebuild.counter);
+}
+
+void HotReload::_rebuild(const WatchedShader& watched, Rebuild& rebuild, const std::string& compiler, DerivedDataCache* spirv_cache,
+                         const std::vector<std::string>& directories, bool recursive)
+{
+    ObjectCache& cache = *watched.shader->gpu._object_cache;
+    // The errors are reported by THROW_ERROR, and the previous shader is kept
+    try
+    {
+        if (!watched.source_path.empty())
+        {
+            _compile(watched, compiler, spirv_cache, directories, recursive);
+        }
+        rebuild.replacement.reset(new Shader(watched.shader->gpu, watched.spirv_path));
+        for (PipelineState state : cache.pipelines_using(rebuild.module))
+        {
+            for (ShaderStage& stage : state.stages)
+            {
+                if (stage.module == rebuild.module)
+                {
+                    stage.module = rebuild.replacement->_vk_shader;
+                }
+            }
+            cache.pipeline(state);
+        }
+    }
+    catch (const std::runtime_error&)
+    {
+        if (rebuild.replacement != nullptr)
+        {
+            cache.evict_pipelines(rebuild.replacement->_vk_shader);
+            rebuild.replacement.reset();
+        }
+    }
+}
+
+void HotReload::_compile(const WatchedShader& watched, const std::string& compiler, DerivedDataCache* cache,
+                         const std::vector<std::string>& directories, bool recursive)
+{
+    std::string command = compiler + " \"" + watched.source_path + "\" -o \"" + watched.spirv_path + "\"";
+    bool compiled = false;
+    auto compile = [&]()
+    {
+        compiled = true;
+        if (std::system(command.c_str()) != 0)
+        {
+            THROW_ERROR("failed to compile the shader '" + watched.source_path + "'")
+        }
+        return Shader::load_binary(watched.spirv_path);
+    };
+    if (cache == nullptr)
+    {
+        compile();
+        return;
+    }
+    // The includes are not tracked, so the key has all the '.glsl' files that could be included. The source path is in the key
+    // as relative includes are resolved from it, but the output path doesn't change the SPIR-V.
+    DerivedDataCache::Key key("glslc", 1);
+    key.add(compiler);
+    key.add(FileWatcher::normalize_path(watched.source_path));
+    key.add_file(watched.source_path);
+    std::vector<std::string> includes;
+    for (const std::string& directory : directories)
+    {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, error);
+        for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!recursive)
+            {
+                it.disable_recursion_pending();
+            }
+            std::error_code file_error;
+            if (it->is_regular_file(file_error) && it->path().extension() == ".glsl")
+            {
+                includes.push_back(FileWatcher::normalize_path(it->path().string()));
+            }
+        }
+    }
+    std::sort(includes.begin(), includes.end());
+    for (const std::string& include : includes)
+    {
+        key.add(include);
+        key.add_file(include);
+    }
+    std::vector<unsigned char> spirv = cache->get_or_cook(key, compile);
+    if (!compiled)
+    {
+        // Found in the cache: the SPIR-V file is written as the compiler would have
+        std::ofstream file(watched.spirv_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size());
+        if (!file)
+        {
+            THROW_ERROR("failed to write the shader '" + watched.spirv_path + "'")
+        }
+    }
+}
+
+void HotReload::_swap(Rebuild& rebuild)
+{
+    if (rebuild.replacement == nullptr)
+    {
+        return;
+    }
+    Shader& shader = *rebuild.shader;
+    ObjectCache& cache = *gpu._object_cache;
+    // The frames in flight might still use the previous pipelines
+    cache.evict_pipelines(rebuild.module);
+    cache.retire(rebuild.module);
+    shader._vk_shader = rebuild.replacement->_vk_shader;
+    shader.reflection = std::move(rebuild.replacement->reflection);
+    rebuild.replacement->_vk_shader = VK_NULL_HANDLE;
+    rebuild.replacement.reset();
+}
+
+void HotReload::_discard(Rebuild& rebuild)
+{
+    if (rebuild.replacement != nullptr)
+    {
+        // The destructor evicts the pipelines built from the replacement and retires its module
+        rebuild.replacement.reset();
+    }
+}
@@ -1,4 +1,5 @@
 #include <GameEngine/graphics/Image.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
 #include <GameEngine/graphics/ImageView.hpp>
 using namespace GameEngine;
 
@@ -7,8 +8,65 @@ Image::Image(const GPU& _gpu, const std::string& image_path) : gpu(_gpu)
 
 }
 
-Image::~Image()
+Image::Image(const GPU& _gpu, unsigned int _width, unsigned int _height, VkFormat format, VkImageUsageFlags usage) : gpu(_gpu), width(_width), height(_height)
 {
+    _format = RGBA;
+    _vk_image_format = format;
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = width;
+    image_info.extent.height = height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = usage;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(gpu._logical_device, &image_info, HostAllocator::callbacks(), &_vk_image) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the image")
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(gpu._logical_device, _vk_image, &requirements);
+    VkMemoryAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = gpu._find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(gpu._logical_device, &allocate_info, HostAllocator::callbacks(), &_vk_memory) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to allocate the image memory")
+    }
+    vkBindImageMemory(gpu._logical_device, _vk_image, _vk_memory, 0);
+}
 
+Image::~Image()
+{
+    vkDestroyImage(gpu._logical_device, _vk_image, HostAllocator::callbacks());
+    vkFreeMemory(gpu._logical_device, _vk_memory, HostAllocator::callbacks());
 }
 
+void Image::_layout_transition(VkCommandBuffer command_buffer, VkImage image,
+                               VkImageLayout old_layout, VkImageLayout new_layout,
+                               VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                               VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
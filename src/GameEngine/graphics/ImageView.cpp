@@ -1,5 +1,7 @@
 #include <GameEngine/graphics/ImageView.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
 #include <GameEngine/graphics/Image.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
 using namespace GameEngine;
 
 ImageView::ImageView(const Image& _image, unsigned int x, unsigned int y, unsigned int width, unsigned int height) : image(_image)
@@ -10,8 +12,7 @@ ImageView::ImageView(const Image& _image, unsigned int x, unsigned int y, unsign
 
 ImageView::~ImageView()
 {
-    vkDestroyImageView(image.gpu._logical_device, _vk_image_view, nullptr);
-    vkDestroyPipelineLayout(image.gpu._logical_device, _vk_graphic_pipeline, nullptr);
+    vkDestroyImageView(image.gpu._logical_device, _vk_image_view, HostAllocator::callbacks());
 }
 
 void ImageView::_set_vk_image_view()
@@ -30,7 +31,7 @@ void ImageView::_set_vk_image_view()
     createInfo.subresourceRange.levelCount = 1;
     createInfo.subresourceRange.baseArrayLayer = 0;
     createInfo.subresourceRange.layerCount = 1;
-    if (vkCreateImageView(image.gpu._logical_device, &createInfo, nullptr, &_vk_image_view) != VK_SUCCESS)
+    if (vkCreateImageView(image.gpu._logical_device, &createInfo, HostAllocator::callbacks(), &_vk_image_view) != VK_SUCCESS)
     {
         THROW_ERROR("failed to create image view")
     }
@@ -38,14 +39,6 @@ void ImageView::_set_vk_image_view()
 
 void ImageView::_set_graphic_pipeline()
 {
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-    if (vkCreatePipelineLayout(image.gpu._logical_device, &pipelineLayoutInfo, nullptr, &_vk_graphic_pipeline) != VK_SUCCESS)
-    {
-        THROW_ERROR("failed to create pipeline layout!")
-    }
+    // Identical layouts are shared between all the views
+    _vk_graphic_pipeline = image.gpu._object_cache->pipeline_layout({});
 }
\ No newline at end of file
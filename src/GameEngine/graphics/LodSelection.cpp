@@ -0,0 +1,69 @@
+#include <GameEngine/graphics/LodSelection.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+using namespace GameEngine;
+
+bool LodState::fading() const
+{
+    return fade < 1.f;
+}
+
+void LodSelection::set_projection(float vertical_fov, float viewport_height)
+{
+    _pixels_per_unit = viewport_height / (2.f * std::tan(0.5f * vertical_fov));
+}
+
+float LodSelection::projected_error(float error, float distance, float scale) const
+{
+    if (distance <= 0.f)
+    {
+        return (error > 0.f) ? INFINITY : 0.f;
+    }
+    return error * scale * _pixels_per_unit / distance;
+}
+
+unsigned int LodSelection::select(const std::vector<MeshLod>& lods, float distance, float scale, float max_pixel_error) const
+{
+    unsigned int lod = 0;
+    while (lod + 1 < lods.size() && projected_error(lods[lod + 1].error, distance, scale) <= max_pixel_error)
+    {
+        lod++;
+    }
+    return lod;
+}
+
+void LodSelection::update(LodState& state, const std::vector<MeshLod>& lods, float distance, float scale, float elapsed) const
+{
+    if (state.fading())
+    {
+        state.fade = (fade_duration > 0.f) ? std::min(state.fade + elapsed / fade_duration, 1.f) : 1.f;
+    }
+    // Finer LODs are selected as soon as the error is visible, coarser ones with a margin
+    unsigned int lod = select(lods, distance, scale, pixel_error);
+    if (lod > state.lod)
+    {
+        lod = std::max(select(lods, distance, scale, (1.f - hysteresis) * pixel_error), state.lod);
+    }
+    if (lod == state.lod)
+    {
+        return;
+    }
+    // During a cross-fade, a switch back reverses it, and another switch is postponed unless it is towards a finer LOD than both
+    if (state.fading())
+    {
+        if (lod == state.previous_lod)
+        {
+            std::swap(state.lod, state.previous_lod);
+            state.fade = 1.f - state.fade;
+            return;
+        }
+        if (lod > std::min(state.lod, state.previous_lod))
+        {
+            return;
+        }
+    }
+    state.previous_lod = state.fading() ? std::min(state.lod, state.previous_lod) : state.lod;
+    state.lod = lod;
+    state.fade = (fade_duration > 0.f) ? 0.f : 1.f;
+}
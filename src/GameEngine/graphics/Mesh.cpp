@@ -0,0 +1,182 @@
+#include <GameEngine/graphics/Mesh.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+using namespace GameEngine;
+
+// The attributes other than the position, in the second stream of the SEPARATE_POSITIONS layout
+struct VertexAttributes
+{
+    float normal[3];
+    float tangent[4];
+    float uv[2];
+};
+
+struct QuantizedVertexAttributes
+{
+    int8_t normal[2];
+    int8_t tangent[2];
+    uint16_t uv[2];
+};
+
+// Upload the vertices as a single stream, or split them in positions and other attributes
+template<typename V, typename Position, typename Attributes, typename Split>
+static void upload_vertices(const GPU& gpu, const std::vector<V>& vertices, Mesh::Layout layout, Split split,
+                            std::unique_ptr<Buffer>& vertex_buffer, std::unique_ptr<Buffer>& attribute_buffer)
+{
+    // The vertices can also be fetched from storage buffers, by mesh shaders (see ClusteredMesh)
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (layout == Mesh::INTERLEAVED)
+    {
+        vertex_buffer.reset(new Buffer(gpu, vertices.data(), vertices.size() * sizeof(V), usage));
+        return;
+    }
+    std::vector<Position> positions(vertices.size());
+    std::vector<Attributes> attributes(vertices.size());
+    for (size_t i=0; i<vertices.size(); i++)
+    {
+        split(vertices[i], positions[i], attributes[i]);
+    }
+    vertex_buffer.reset(new Buffer(gpu, positions.data(), positions.size() * sizeof(Position), usage));
+    attribute_buffer.reset(new Buffer(gpu, attributes.data(), attributes.size() * sizeof(Attributes), usage));
+}
+
+Mesh::Mesh(const GPU& _gpu, const MeshData& data, Layout layout, Format format) : gpu(_gpu), _layout(layout), _format(format)
+{
+    if (data.indices.empty() || data.vertices.empty())
+    {
+        THROW_ERROR("can't create a mesh without triangles")
+    }
+    _vertex_count = data.vertices.size();
+    _index_count = data.indices.size();
+    _lods = data.lods;
+    if (_lods.empty())
+    {
+        _lods.push_back({0, _index_count, 0.f});
+    }
+    if (_format == FULL_PRECISION)
+    {
+        _bounds = {{0.f, 0.f, 0.f}, {1.f, 1.f, 1.f}, {0.f, 0.f}, {1.f, 1.f}};
+        struct Position {float xyz[3];};
+        upload_vertices<Vertex, Position, VertexAttributes>(gpu, data.vertices, _layout, [](const Vertex& v, Position& p, VertexAttributes& a)
+        {
+            p = {{v.position[0], v.position[1], v.position[2]}};
+            a = {{v.normal[0], v.normal[1], v.normal[2]}, {v.tangent[0], v.tangent[1], v.tangent[2], v.tangent[3]}, {v.uv[0], v.uv[1]}};
+        }, _vertices, _attributes);
+    }
+    else
+    {
+        struct Position {uint16_t xyzw[4];};
+        upload_vertices<QuantizedVertex, Position, QuantizedVertexAttributes>(gpu, data.quantize(_bounds), _layout,
+            [](const QuantizedVertex& v, Position& p, QuantizedVertexAttributes& a)
+        {
+            p = {{v.position[0], v.position[1], v.position[2], v.position[3]}};
+            a = {{v.normal[0], v.normal[1]}, {v.tangent[0], v.tangent[1]}, {v.uv[0], v.uv[1]}};
+        }, _vertices, _attributes);
+    }
+    // 16 bits indices halve the index buffer and its fetches
+    if (_vertex_count <= 65536)
+    {
+        _index_type = VK_INDEX_TYPE_UINT16;
+        std::vector<uint16_t> indices(data.indices.begin(), data.indices.end());
+        _indices.reset(new Buffer(gpu, indices.data(), indices.size() * sizeof(uint16_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT));
+    }
+    else
+    {
+        _index_type = VK_INDEX_TYPE_UINT32;
+        _indices.reset(new Buffer(gpu, data.indices.data(), data.indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT));
+    }
+}
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::vertex_input(PipelineState& state, bool positions_only) const
+{
+    state.vertex_bindings.clear();
+    state.vertex_attributes.clear();
+    bool interleaved = (_layout == INTERLEAVED);
+    uint32_t attribute_binding = interleaved ? 0 : 1;
+    if (_format == FULL_PRECISION)
+    {
+        state.vertex_bindings.push_back({0, interleaved ? static_cast<uint32_t>(sizeof(Vertex)) : 3 * static_cast<uint32_t>(sizeof(float)), VK_VERTEX_INPUT_RATE_VERTEX});
+        state.vertex_attributes.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0});
+        if (!positions_only)
+        {
+            state.vertex_attributes.push_back({1, attribute_binding, VK_FORMAT_R32G32B32_SFLOAT,
+                                               static_cast<uint32_t>(interleaved ? offsetof(Vertex, normal) : offsetof(VertexAttributes, normal))});
+            state.vertex_attributes.push_back({2, attribute_binding, VK_FORMAT_R32G32_SFLOAT,
+                                               static_cast<uint32_t>(interleaved ? offsetof(Vertex, uv) : offsetof(VertexAttributes, uv))});
+            state.vertex_attributes.push_back({3, attribute_binding, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                               static_cast<uint32_t>(interleaved ? offsetof(Vertex, tangent) : offsetof(VertexAttributes, tangent))});
+            if (!interleaved)
+            {
+                state.vertex_bindings.push_back({1, sizeof(VertexAttributes), VK_VERTEX_INPUT_RATE_VERTEX});
+            }
+        }
+    }
+    else
+    {
+        state.vertex_bindings.push_back({0, interleaved ? static_cast<uint32_t>(sizeof(QuantizedVertex)) : 4 * static_cast<uint32_t>(sizeof(uint16_t)), VK_VERTEX_INPUT_RATE_VERTEX});
+        state.vertex_attributes.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, 0});
+        if (!positions_only)
+        {
+            state.vertex_attributes.push_back({1, attribute_binding, VK_FORMAT_R8G8B8A8_SNORM,
+                                               static_cast<uint32_t>(interleaved ? offsetof(QuantizedVertex, normal) : offsetof(QuantizedVertexAttributes, normal))});
+            state.vertex_attributes.push_back({2, attribute_binding, VK_FORMAT_R16G16_UNORM,
+                                               static_cast<uint32_t>(interleaved ? offsetof(QuantizedVertex, uv) : offsetof(QuantizedVertexAttributes, uv))});
+            if (!interleaved)
+            {
+                state.vertex_bindings.push_back({1, sizeof(QuantizedVertexAttributes), VK_VERTEX_INPUT_RATE_VERTEX});
+            }
+        }
+    }
+}
+
+void Mesh::draw(VkCommandBuffer command_buffer, bool positions_only, uint32_t instance_count, unsigned int lod) const
+{
+    const MeshLod& range = _lods[std::min<size_t>(lod, _lods.size() - 1)];
+    VkBuffer buffers[2] = {_vertices->_vk_buffer, (_attributes != nullptr) ? _attributes->_vk_buffer : VK_NULL_HANDLE};
+    VkDeviceSize offsets[2] = {0, 0};
+    uint32_t n_buffers = (_attributes != nullptr && !positions_only) ? 2 : 1;
+    vkCmdBindVertexBuffers(command_buffer, 0, n_buffers, buffers, offsets);
+    vkCmdBindIndexBuffer(command_buffer, _indices->_vk_buffer, 0, _index_type);
+    vkCmdDrawIndexed(command_buffer, range.index_count, instance_count, range.first_index, 0, 0);
+}
+
+Mesh::Layout Mesh::layout() const
+{
+    return _layout;
+}
+
+Mesh::Format Mesh::format() const
+{
+    return _format;
+}
+
+const QuantizationBounds& Mesh::bounds() const
+{
+    return _bounds;
+}
+
+const std::vector<MeshLod>& Mesh::lods() const
+{
+    return _lods;
+}
+
+uint32_t Mesh::vertex_count() const
+{
+    return _vertex_count;
+}
+
+uint32_t Mesh::index_count() const
+{
+    return _index_count;
+}
+
+VkIndexType Mesh::index_type() const
+{
+    return _index_type;
+}
@@ -0,0 +1,1181 @@
+#include <GameEngine/graphics/MeshData.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <queue>
+using namespace GameEngine;
+
+// Size of the cache modeled by the vertex cache optimization (larger than the hardware caches, which improves the order for them all)
+static const int forsyth_cache_size = 32;
+static const unsigned int forsyth_max_valence = 32;
+
+// Score of a vertex: high for the vertices just used (except the last triangle's, used again right away by strips) and
+// for the vertices with few triangles left, so that isolated triangles are not left behind
+static float forsyth_vertex_score(int cache_position, unsigned int remaining)
+{
+    if (remaining == 0)
+    {
+        return -1.f;
+    }
+    float score = 0.f;
+    if (cache_position >= 0)
+    {
+        score = (cache_position < 3) ? 0.75f : std::pow(1.f - static_cast<float>(cache_position - 3) / (forsyth_cache_size - 3), 1.5f);
+    }
+    return score + 2.f / std::sqrt(static_cast<float>(remaining));
+}
+
+void MeshData::optimize(float overdraw_threshold)
+{
+    optimize_vertex_cache();
+    optimize_overdraw(overdraw_threshold);
+    optimize_vertex_fetch();
+}
+
+void MeshData::optimize_vertex_cache()
+{
+    size_t n_vertices = vertices.size();
+    size_t n_triangles = indices.size() / 3;
+    if (n_triangles == 0)
+    {
+        return;
+    }
+    // Scores by cache position and number of triangles left, computed once
+    float score_table[forsyth_cache_size + 1][forsyth_max_valence + 1];
+    for (int position = -1; position < forsyth_cache_size; position++)
+    {
+        for (unsigned int remaining = 0; remaining <= forsyth_max_valence; remaining++)
+        {
+            score_table[position + 1][remaining] = forsyth_vertex_score(position, remaining);
+        }
+    }
+    auto vertex_score = [&score_table](int position, unsigned int remaining)
+    {
+        return score_table[position + 1][std::min(remaining, forsyth_max_valence)];
+    };
+    // Triangles of each vertex, the triangles not emitted yet being first
+    std::vector<uint32_t> remaining(n_vertices, 0);
+    for (uint32_t index : indices)
+    {
+        remaining[index]++;
+    }
+    std::vector<uint32_t> offsets(n_vertices + 1, 0);
+    for (size_t v=0; v<n_vertices; v++)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        for (unsigned int k=0; k<3; k++)
+        {
+            adjacency[filled[indices[3*t + k]]++] = t;
+        }
+    }
+    std::vector<float> scores(n_vertices);
+    for (size_t v=0; v<n_vertices; v++)
+    {
+        scores[v] = vertex_score(-1, remaining[v]);
+    }
+    std::vector<float> triangle_scores(n_triangles);
+    std::vector<bool> emitted(n_triangles, false);
+    int64_t best = -1;
+    float best_score = -1.f;
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        triangle_scores[t] = scores[indices[3*t]] + scores[indices[3*t + 1]] + scores[indices[3*t + 2]];
+        if (triangle_scores[t] > best_score)
+        {
+            best = t;
+            best_score = triangle_scores[t];
+        }
+    }
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> new_cache;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    size_t next_unemitted = 0; // triangles before it are all emitted
+    for (size_t n=0; n<n_triangles; n++)
+    {
+        if (best < 0)
+        {
+            // Dead end: no triangle uses a cached vertex, continue from the next triangle in input order
+            while (emitted[next_unemitted])
+            {
+                next_unemitted++;
+            }
+            best = next_unemitted;
+        }
+        const uint32_t* triangle = &indices[3*best];
+        emitted[best] = true;
+        result.insert(result.end(), triangle, triangle + 3);
+        // Remove the triangle from the triangles left of its vertices
+        for (unsigned int k=0; k<3; k++)
+        {
+            uint32_t v = triangle[k];
+            uint32_t* begin = &adjacency[offsets[v]];
+            uint32_t* end = begin + remaining[v];
+            *std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+            remaining[v]--;
+        }
+        // The triangle's vertices move to the front of the cache
+        new_cache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                new_cache.push_back(v);
+            }
+        }
+        cache.swap(new_cache);
+        // Update the scores of the vertices in (or evicted from) the cache, and of their triangles
+        best = -1;
+        best_score = -1.f;
+        for (size_t i=0; i<cache.size(); i++)
+        {
+            uint32_t v = cache[i];
+            int position = (i < static_cast<size_t>(forsyth_cache_size)) ? static_cast<int>(i) : -1;
+            float score = vertex_score(position, remaining[v]);
+            float delta = score - scores[v];
+            scores[v] = score;
+            for (uint32_t a=offsets[v]; a<offsets[v] + remaining[v]; a++)
+            {
+                uint32_t t = adjacency[a];
+                triangle_scores[t] += delta;
+                if (triangle_scores[t] > best_score)
+                {
+                    best = t;
+                    best_score = triangle_scores[t];
+                }
+            }
+        }
+        if (cache.size() > static_cast<size_t>(forsyth_cache_size))
+        {
+            cache.resize(forsyth_cache_size);
+        }
+    }
+    indices.swap(result);
+}
+
+void MeshData::optimize_overdraw(float threshold)
+{
+    size_t n_triangles = indices.size() / 3;
+    if (n_triangles == 0)
+    {
+        return;
+    }
+    const uint32_t cache_size = 16;
+    FifoCache cache(vertices.size(), cache_size);
+    // Hard boundaries: the triangles whose three vertices missed the cache start a new strip of triangles
+    std::vector<size_t> hard_boundaries;
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        if (cache.triangle(&indices[3*t]) == 3)
+        {
+            hard_boundaries.push_back(t);
+        }
+    }
+    hard_boundaries.push_back(n_triangles);
+    // Soft boundaries: a cluster is closed as soon as its miss ratio reached the ratio of the whole strip (degraded by the threshold)
+    std::vector<size_t> clusters;
+    for (size_t h=0; h+1<hard_boundaries.size(); h++)
+    {
+        size_t start = hard_boundaries[h];
+        size_t end = hard_boundaries[h + 1];
+        cache.reset();
+        unsigned int strip_misses = 0;
+        for (size_t t=start; t<end; t++)
+        {
+            strip_misses += cache.triangle(&indices[3*t]);
+        }
+        float strip_threshold = threshold * static_cast<float>(strip_misses) / static_cast<float>(end - start);
+        clusters.push_back(start);
+        cache.reset();
+        unsigned int misses = 0;
+        size_t faces = 0;
+        for (size_t t=start; t<end; t++)
+        {
+            misses += cache.triangle(&indices[3*t]);
+            faces++;
+            if (t + 1 < end && static_cast<float>(misses) / static_cast<float>(faces) <= strip_threshold)
+            {
+                clusters.push_back(t + 1);
+                cache.reset();
+                misses = 0;
+                faces = 0;
+            }
+        }
+    }
+    clusters.push_back(n_triangles);
+    // Sort key of a cluster: how far it faces outward from the center of the mesh
+    auto sub = [](const float* a, const float* b, float* r) {r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];};
+    float mesh_center[3] = {0.f, 0.f, 0.f};
+    float mesh_area = 0.f;
+    std::vector<float> centers(3 * (clusters.size() - 1), 0.f);
+    std::vector<float> normals(3 * (clusters.size() - 1), 0.f);
+    for (size_t c=0; c+1<clusters.size(); c++)
+    {
+        float area = 0.f;
+        for (size_t t=clusters[c]; t<clusters[c + 1]; t++)
+        {
+            const float* p0 = vertices[indices[3*t]].position;
+            const float* p1 = vertices[indices[3*t + 1]].position;
+            const float* p2 = vertices[indices[3*t + 2]].position;
+            float e1[3], e2[3];
+            sub(p1, p0, e1);
+            sub(p2, p0, e2);
+            float n[3] = {e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0]};
+            float triangle_area = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+            for (unsigned int k=0; k<3; k++)
+            {
+                centers[3*c + k] += (p0[k] + p1[k] + p2[k]) / 3.f * triangle_area;
+                normals[3*c + k] += n[k];
+            }
+            area += triangle_area;
+        }
+        for (unsigned int k=0; k<3; k++)
+        {
+            mesh_center[k] += centers[3*c + k];
+            centers[3*c + k] /= (area > 0.f) ? area : 1.f;
+        }
+        mesh_area += area;
+    }
+    for (unsigned int k=0; k<3; k++)
+    {
+        mesh_center[k] /= (mesh_area > 0.f) ? mesh_area : 1.f;
+    }
+    std::vector<float> keys(clusters.size() - 1);
+    std::vector<size_t> order(clusters.size() - 1);
+    for (size_t c=0; c+1<clusters.size(); c++)
+    {
+        float* n = &normals[3*c];
+        float length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        float d[3];
+        sub(&centers[3*c], mesh_center, d);
+        keys[c] = (length > 0.f) ? (d[0]*n[0] + d[1]*n[1] + d[2]*n[2]) / length : 0.f;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {return keys[a] > keys[b];});
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t c : order)
+    {
+        result.insert(result.end(), indices.begin() + 3*clusters[c], indices.begin() + 3*clusters[c + 1]);
+    }
+    indices.swap(result);
+}
+
+void MeshData::optimize_vertex_fetch()
+{
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = result.size();
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+float MeshData::acmr(unsigned int cache_size) const
+{
+    size_t n_triangles = indices.size() / 3;
+    if (n_triangles == 0)
+    {
+        return 0.f;
+    }
+    FifoCache cache(vertices.size(), cache_size);
+    size_t misses = 0;
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        misses += cache.triangle(&indices[3*t]);
+    }
+    return static_cast<float>(misses) / static_cast<float>(n_triangles);
+}
+
+// Sum of the squared distances to planes: Q(p) = p.A.p + 2 b.p + c, with the area of the triangles they come from
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double area;
+};
+
+// Add the plane of normal n (unit) and offset d, weighted
+static void quadric_add_plane(Quadric& q, const double* n, double d, double weight)
+{
+    q.a00 += weight * n[0] * n[0];
+    q.a01 += weight * n[0] * n[1];
+    q.a02 += weight * n[0] * n[2];
+    q.a11 += weight * n[1] * n[1];
+    q.a12 += weight * n[1] * n[2];
+    q.a22 += weight * n[2] * n[2];
+    q.b0 += weight * n[0] * d;
+    q.b1 += weight * n[1] * d;
+    q.b2 += weight * n[2] * d;
+    q.c += weight * d * d;
+}
+
+// Mean squared distance of a point to the planes of two quadrics
+static double quadric_error(const Quadric& q, const Quadric& r, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double a00 = q.a00 + r.a00, a01 = q.a01 + r.a01, a02 = q.a02 + r.a02;
+    double a11 = q.a11 + r.a11, a12 = q.a12 + r.a12, a22 = q.a22 + r.a22;
+    double error = a00*x*x + a11*y*y + a22*z*z + 2.*(a01*x*y + a02*x*z + a12*y*z)
+                 + 2.*((q.b0 + r.b0)*x + (q.b1 + r.b1)*y + (q.b2 + r.b2)*z) + q.c + r.c;
+    double area = q.area + r.area;
+    return std::max(error, 0.) / ((area > 0.) ? area : 1.);
+}
+
+static void triangle_normal(const float* p0, const float* p1, const float* p2, double* n)
+{
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+    n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+    n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+}
+
+// Squared distance from p to the triangle (a, b, c), by the region of the triangle its projection falls in (Ericson 2004, 5.1.5)
+static double squared_distance_to_triangle(const double* p, const float* a, const float* b, const float* c)
+{
+    double ab[3], ac[3], ap[3];
+    for (unsigned int k=0; k<3; k++)
+    {
+        ab[k] = b[k] - a[k];
+        ac[k] = c[k] - a[k];
+        ap[k] = p[k] - a[k];
+    }
+    auto dot = [](const double* u, const double* v) {return u[0]*v[0] + u[1]*v[1] + u[2]*v[2];};
+    double d1 = dot(ab, ap), d2 = dot(ac, ap);
+    double s = 0., t = 0.;
+    if (d1 <= 0. && d2 <= 0.)
+    {
+        // Closest to a
+    }
+    else
+    {
+        double bp[3] = {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+        double cp[3] = {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+        double d3 = dot(ab, bp), d4 = dot(ac, bp), d5 = dot(ab, cp), d6 = dot(ac, cp);
+        double vc = d1*d4 - d3*d2, vb = d5*d2 - d1*d6, va = d3*d6 - d5*d4;
+        if (d3 >= 0. && d4 <= d3)
+        {
+            s = 1.;
+        }
+        else if (d6 >= 0. && d5 <= d6)
+        {
+            t = 1.;
+        }
+        else if (vc <= 0. && d1 >= 0. && d3 <= 0.)
+        {
+            s = d1 / (d1 - d3);
+        }
+        else if (vb <= 0. && d2 >= 0. && d6 <= 0.)
+        {
+            t = d2 / (d2 - d6);
+        }
+        else if (va <= 0. && d4 - d3 >= 0. && d5 - d6 >= 0.)
+        {
+            s = 1. - (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            t = 1. - s;
+        }
+        else if (va + vb + vc != 0.)
+        {
+            s = vb / (va + vb + vc);
+            t = vc / (va + vb + vc);
+        }
+    }
+    double squared_distance = 0.;
+    for (unsigned int k=0; k<3; k++)
+    {
+        double d = ap[k] - s*ab[k] - t*ac[k];
+        squared_distance += d*d;
+    }
+    return squared_distance;
+}
+
+// Maximum distance from the points (x, y, z each) to the nearest of the triangles, given an upper bound of the squared distance of each point.
+// The triangles are bucketed in a uniform grid of cells about their size, and the cells are searched in growing shells around each point
+// until no closer triangle can be left. The points are taken by decreasing bound, and those that can't exceed the maximum so far are skipped.
+static double max_distance_to_triangles(const std::vector<double>& points, const std::vector<double>& bounds,
+                                        const std::vector<Vertex>& vertices, const std::vector<uint32_t>& triangles)
+{
+    size_t n_triangles = triangles.size() / 3;
+    if (points.empty() || n_triangles == 0)
+    {
+        return 0.;
+    }
+    auto position = [&](size_t t, unsigned int k) {return vertices[triangles[3*t + k]].position;};
+    double min[3] = {INFINITY, INFINITY, INFINITY};
+    double max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    double area = 0.;
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        for (unsigned int k=0; k<3; k++)
+        {
+            for (unsigned int i=0; i<3; i++)
+            {
+                min[i] = std::min(min[i], static_cast<double>(position(t, k)[i]));
+                max[i] = std::max(max[i], static_cast<double>(position(t, k)[i]));
+            }
+        }
+        double n[3];
+        triangle_normal(position(t, 0), position(t, 1), position(t, 2), n);
+        area += 0.5 * std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    }
+    double extent = std::max({max[0] - min[0], max[1] - min[1], max[2] - min[2], 1e-30});
+    double cell_size = std::max(std::sqrt(area / static_cast<double>(n_triangles)), 1e-3 * extent);
+    int dimensions[3];
+    auto fit = [&]()
+    {
+        for (unsigned int i=0; i<3; i++)
+        {
+            dimensions[i] = static_cast<int>(std::ceil((max[i] - min[i]) / cell_size)) + 1;
+        }
+        return static_cast<double>(dimensions[0]) * dimensions[1] * dimensions[2] <= 4. * static_cast<double>(n_triangles) + 64.;
+    };
+    while (!fit())
+    {
+        cell_size *= 1.25;
+    }
+    auto cell_of = [&](double x, unsigned int i)
+    {
+        return std::min(std::max(static_cast<int>((x - min[i]) / cell_size), 0), dimensions[i] - 1);
+    };
+    // Triangles of each cell their bounding box overlaps, by cell
+    std::vector<uint32_t> cell_start(static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2] + 1, 0);
+    std::vector<uint32_t> cell_triangles;
+    for (unsigned int pass=0; pass<2; pass++)
+    {
+        for (size_t t=0; t<n_triangles; t++)
+        {
+            int low[3], high[3];
+            for (unsigned int i=0; i<3; i++)
+            {
+                low[i] = cell_of(std::min({position(t, 0)[i], position(t, 1)[i], position(t, 2)[i]}), i);
+                high[i] = cell_of(std::max({position(t, 0)[i], position(t, 1)[i], position(t, 2)[i]}), i);
+            }
+            for (int z=low[2]; z<=high[2]; z++)
+            {
+                for (int y=low[1]; y<=high[1]; y++)
+                {
+                    for (int x=low[0]; x<=high[0]; x++)
+                    {
+                        size_t cell = (static_cast<size_t>(z) * dimensions[1] + y) * dimensions[0] + x;
+                        if (pass == 0)
+                        {
+                            cell_start[cell + 1]++;
+                        }
+                        else
+                        {
+                            cell_triangles[cell_start[cell]++] = static_cast<uint32_t>(t);
+                        }
+                    }
+                }
+            }
+        }
+        if (pass == 0)
+        {
+            for (size_t cell=1; cell<cell_start.size(); cell++)
+            {
+                cell_start[cell] += cell_start[cell - 1];
+            }
+            cell_triangles.resize(cell_start.back());
+        }
+        else
+        {
+            // The second pass moved each start to the end of its cell, which is the start of the next one
+            std::rotate(cell_start.rbegin(), cell_start.rbegin() + 1, cell_start.rend());
+            cell_start[0] = 0;
+        }
+    }
+    std::vector<uint32_t> order(bounds.size());
+    for (uint32_t i=0; i<order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&bounds](uint32_t a, uint32_t b) {return bounds[a] > bounds[b];});
+    double max_squared_distance = 0.;
+    int max_shell = std::max({dimensions[0], dimensions[1], dimensions[2]});
+    for (uint32_t i : order)
+    {
+        if (bounds[i] <= max_squared_distance)
+        {
+            break;
+        }
+        const double* p = &points[3*i];
+        int center[3] = {cell_of(p[0], 0), cell_of(p[1], 1), cell_of(p[2], 2)};
+        double nearest = bounds[i];
+        // The triangles not found by the shells up to s are in cells at least s cells away
+        for (int s=0; s<=max_shell; s++)
+        {
+            for (int z=center[2]-s; z<=center[2]+s; z++)
+            {
+                for (int y=center[1]-s; y<=center[1]+s; y++)
+                {
+                    bool inside = (std::abs(z - center[2]) != s && std::abs(y - center[1]) != s);
+                    for (int x=center[0]-s; x<=center[0]+s; x+=(inside && s > 0) ? 2*s : 1)
+                    {
+                        if (x < 0 || y < 0 || z < 0 || x >= dimensions[0] || y >= dimensions[1] || z >= dimensions[2])
+                        {
+                            continue;
+                        }
+                        size_t cell = (static_cast<size_t>(z) * dimensions[1] + y) * dimensions[0] + x;
+                        for (uint32_t j=cell_start[cell]; j<cell_start[cell + 1]; j++)
+                        {
+                            uint32_t t = cell_triangles[j];
+                            nearest = std::min(nearest, squared_distance_to_triangle(p, position(t, 0), position(t, 1), position(t, 2)));
+                        }
+                    }
+                }
+            }
+            double reach = static_cast<double>(s) * cell_size;
+            if (nearest <= std::max(reach * reach, max_squared_distance))
+            {
+                break;
+            }
+        }
+        max_squared_distance = std::max(max_squared_distance, nearest);
+    }
+    return std::sqrt(max_squared_distance);
+}
+
+std::vector<uint32_t> MeshData::simplify(size_t target_index_count, float max_error, float* result_error) const
+{
+    size_t n_vertices = vertices.size();
+    std::vector<uint32_t> triangles(indices.begin(), indices.begin() + (lods.empty() ? indices.size() : lods[0].index_count));
+    size_t n_triangles = triangles.size() / 3;
+    if (result_error != nullptr)
+    {
+        *result_error = 0.f;
+    }
+    // Weld the vertices by position: the collapses are between positions, the vertices differing by their attributes only are seams
+    std::vector<uint32_t> sorted(n_vertices);
+    for (uint32_t i=0; i<n_vertices; i++)
+    {
+        sorted[i] = i;
+    }
+    auto position_less = [this](uint32_t a, uint32_t b)
+    {
+        const float* pa = vertices[a].position;
+        const float* pb = vertices[b].position;
+        return std::lexicographical_compare(pa, pa + 3, pb, pb + 3);
+    };
+    std::sort(sorted.begin(), sorted.end(), position_less);
+    std::vector<uint32_t> position_of(n_vertices);
+    std::vector<uint32_t> representative; // a vertex of each position
+    std::vector<uint32_t> vertex_count; // number of vertices at each position
+    for (size_t i=0; i<n_vertices; i++)
+    {
+        if (i == 0 || position_less(sorted[i - 1], sorted[i]))
+        {
+            representative.push_back(sorted[i]);
+            vertex_count.push_back(0);
+        }
+        position_of[sorted[i]] = representative.size() - 1;
+        vertex_count.back()++;
+    }
+    size_t n_positions = representative.size();
+    auto position = [&](uint32_t p) {return vertices[representative[p]].position;};
+    auto corner = [&](size_t t, unsigned int k) {return position_of[triangles[3*t + k]];};
+    // The error is measured at the positions and the triangle centers of the full detail surface
+    std::vector<double> samples;
+    std::vector<uint32_t> sample_positions; // a position of the triangle of each sample
+    if (result_error != nullptr)
+    {
+        std::vector<bool> used(n_positions, false);
+        samples.reserve(3 * (n_positions + n_triangles));
+        for (size_t t=0; t<n_triangles; t++)
+        {
+            double center[3] = {0., 0., 0.};
+            for (unsigned int k=0; k<3; k++)
+            {
+                const float* p = position(corner(t, k));
+                for (unsigned int i=0; i<3; i++)
+                {
+                    center[i] += p[i] / 3.;
+                }
+                if (!used[corner(t, k)])
+                {
+                    used[corner(t, k)] = true;
+                    samples.insert(samples.end(), p, p + 3);
+                    sample_positions.push_back(corner(t, k));
+                }
+            }
+            samples.insert(samples.end(), center, center + 3);
+            sample_positions.push_back(corner(t, 0));
+        }
+    }
+    // Edges shared by a single triangle are borders, by more than two are non manifold
+    enum Kind : uint8_t {MANIFOLD, BORDER, LOCKED};
+    std::vector<uint8_t> kind(n_positions, MANIFOLD);
+    for (size_t p=0; p<n_positions; p++)
+    {
+        if (vertex_count[p] > 1)
+        {
+            kind[p] = LOCKED;
+        }
+    }
+    std::vector<uint64_t> edges;
+    edges.reserve(3 * n_triangles);
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        for (unsigned int k=0; k<3; k++)
+        {
+            uint64_t a = corner(t, k), b = corner(t, (k + 1) % 3);
+            edges.push_back((std::min(a, b) << 32) | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i=0; i<edges.size();)
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+        {
+            j++;
+        }
+        if (j - i != 2)
+        {
+            uint32_t ends[2] = {static_cast<uint32_t>(edges[i] >> 32), static_cast<uint32_t>(edges[i] & UINT32_MAX)};
+            for (uint32_t p : ends)
+            {
+                kind[p] = (j - i == 1 && kind[p] != LOCKED) ? BORDER : LOCKED;
+            }
+        }
+        i = j;
+    }
+    // Quadrics of the planes of the triangles around each position, and of planes orthogonal to the borders that keep them in place.
+    // The border planes are not counted in the area, so that moving a border costs much more than moving the surface.
+    const double border_weight = 10.;
+    std::vector<Quadric> quadrics(n_positions, Quadric{0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0.});
+    std::vector<std::vector<uint32_t>> triangles_of(n_positions);
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        double n[3];
+        triangle_normal(position(corner(t, 0)), position(corner(t, 1)), position(corner(t, 2)), n);
+        double length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        for (unsigned int k=0; k<3; k++)
+        {
+            triangles_of[corner(t, k)].push_back(t);
+        }
+        if (length == 0.)
+        {
+            continue;
+        }
+        n[0] /= length; n[1] /= length; n[2] /= length;
+        const float* p0 = position(corner(t, 0));
+        double d = -(n[0]*p0[0] + n[1]*p0[1] + n[2]*p0[2]);
+        double area = 0.5 * length;
+        for (unsigned int k=0; k<3; k++)
+        {
+            Quadric& q = quadrics[corner(t, k)];
+            quadric_add_plane(q, n, d, area);
+            q.area += area;
+        }
+        for (unsigned int k=0; k<3; k++)
+        {
+            uint32_t a = corner(t, k), b = corner(t, (k + 1) % 3);
+            if (kind[a] == MANIFOLD || kind[b] == MANIFOLD)
+            {
+                continue;
+            }
+            const float* pa = position(a);
+            const float* pb = position(b);
+            double e[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+            double m[3] = {e[1]*n[2] - e[2]*n[1], e[2]*n[0] - e[0]*n[2], e[0]*n[1] - e[1]*n[0]};
+            double m_length = std::sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+            if (m_length == 0.)
+            {
+                continue;
+            }
+            m[0] /= m_length; m[1] /= m_length; m[2] /= m_length;
+            double md = -(m[0]*pa[0] + m[1]*pa[1] + m[2]*pa[2]);
+            double weight = border_weight * (e[0]*e[0] + e[1]*e[1] + e[2]*e[2]);
+            quadric_add_plane(quadrics[a], m, md, weight);
+            quadric_add_plane(quadrics[b], m, md, weight);
+        }
+    }
+    // Collapses of a position onto a neighbour, by increasing error. The versions of the positions invalidate the outdated collapses.
+    struct Collapse
+    {
+        double error;
+        uint32_t from, to;
+        uint32_t from_version, to_version;
+        bool operator<(const Collapse& other) const {return error > other.error;}
+    };
+    std::vector<uint32_t> version(n_positions, 0);
+    std::vector<uint32_t> collapsed_to(n_positions, UINT32_MAX);
+    std::vector<bool> removed(n_triangles, false);
+    std::priority_queue<Collapse> queue;
+    auto push = [&](uint32_t from, uint32_t to)
+    {
+        if (kind[from] != LOCKED && from != to)
+        {
+            queue.push({quadric_error(quadrics[from], quadrics[to], position(to)), from, to, version[from], version[to]});
+        }
+    };
+    for (size_t t=0; t<n_triangles; t++)
+    {
+        for (unsigned int k=0; k<3; k++)
+        {
+            push(corner(t, k), corner(t, (k + 1) % 3));
+            push(corner(t, (k + 1) % 3), corner(t, k));
+        }
+    }
+    auto contains = [&](size_t t, uint32_t p) {return corner(t, 0) == p || corner(t, 1) == p || corner(t, 2) == p;};
+    auto neighbours = [&](uint32_t p, std::vector<uint32_t>& result)
+    {
+        result.clear();
+        for (uint32_t t : triangles_of[p])
+        {
+            for (unsigned int k=0; !removed[t] && k<3; k++)
+            {
+                if (corner(t, k) != p)
+                {
+                    result.push_back(corner(t, k));
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    };
+    size_t target_triangles = target_index_count / 3;
+    double max_squared_error = static_cast<double>(max_error) * static_cast<double>(max_error);
+    std::vector<uint32_t> from_neighbours, to_neighbours;
+    while (n_triangles > target_triangles && !queue.empty())
+    {
+        Collapse collapse = queue.top();
+        queue.pop();
+        uint32_t u = collapse.from, v = collapse.to;
+        if (collapse.from_version != version[u] || collapse.to_version != version[v])
+        {
+            continue;
+        }
+        if (collapse.error > max_squared_error)
+        {
+            break;
+        }
+        // Topology: the edge must be an interior edge of a manifold vertex or a border edge of a border vertex, and the vertices
+        // must have no common neighbour besides the triangles of the edge (otherwise the collapse would pinch the surface)
+        uint32_t shared = 0;
+        uint32_t to_vertex = UINT32_MAX; // vertex at v taking the place of u, on the same side of the seams as u
+        for (uint32_t t : triangles_of[u])
+        {
+            if (!removed[t] && contains(t, v))
+            {
+                shared++;
+                for (unsigned int k=0; k<3; k++)
+                {
+                    if (corner(t, k) == v)
+                    {
+                        to_vertex = triangles[3*t + k];
+                    }
+                }
+            }
+        }
+        if (shared != ((kind[u] == BORDER) ? 1u : 2u))
+        {
+            continue;
+        }
+        neighbours(u, from_neighbours);
+        neighbours(v, to_neighbours);
+        std::vector<uint32_t> common;
+        std::set_intersection(from_neighbours.begin(), from_neighbours.end(), to_neighbours.begin(), to_neighbours.end(), std::back_inserter(common));
+        if (common.size() != shared)
+        {
+            continue;
+        }
+        // Geometry: the triangles moving with u must not flip
+        bool flips = false;
+        for (uint32_t t : triangles_of[u])
+        {
+            if (removed[t] || contains(t, v))
+            {
+                continue;
+            }
+            const float* before[3] = {position(corner(t, 0)), position(corner(t, 1)), position(corner(t, 2))};
+            const float* after[3] = {before[0], before[1], before[2]};
+            for (unsigned int k=0; k<3; k++)
+            {
+                if (corner(t, k) == u)
+                {
+                    after[k] = position(v);
+                }
+            }
+            double n_before[3], n_after[3];
+            triangle_normal(before[0], before[1], before[2], n_before);
+            triangle_normal(after[0], after[1], after[2], n_after);
+            if (n_before[0]*n_after[0] + n_before[1]*n_after[1] + n_before[2]*n_after[2] <= 0.)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+        {
+            continue;
+        }
+        // Collapse
+        for (uint32_t t : triangles_of[u])
+        {
+            if (removed[t])
+            {
+                continue;
+            }
+            if (contains(t, v))
+            {
+                removed[t] = true;
+                n_triangles--;
+                continue;
+            }
+            for (unsigned int k=0; k<3; k++)
+            {
+                if (corner(t, k) == u)
+                {
+                    triangles[3*t + k] = to_vertex;
+                }
+            }
+            triangles_of[v].push_back(t);
+        }
+        triangles_of[u].clear();
+        collapsed_to[u] = v;
+        Quadric& q = quadrics[v];
+        const Quadric& r = quadrics[u];
+        q = Quadric{q.a00 + r.a00, q.a01 + r.a01, q.a02 + r.a02, q.a11 + r.a11, q.a12 + r.a12, q.a22 + r.a22,
+                    q.b0 + r.b0, q.b1 + r.b1, q.b2 + r.b2, q.c + r.c, q.area + r.area};
+        version[u]++;
+        version[v]++;
+        neighbours(v, to_neighbours);
+        for (uint32_t n : to_neighbours)
+        {
+            push(v, n);
+            push(n, v);
+        }
+    }
+    std::vector<uint32_t> result;
+    result.reserve(3 * n_triangles);
+    for (size_t t=0; t<removed.size(); t++)
+    {
+        if (!removed[t])
+        {
+            result.insert(result.end(), triangles.begin() + 3*t, triangles.begin() + 3*t + 3);
+        }
+    }
+    if (result_error != nullptr)
+    {
+        // The triangles around the position each sample was collapsed onto bound its distance
+        std::vector<double> bounds(sample_positions.size(), INFINITY);
+        for (size_t i=0; i<sample_positions.size(); i++)
+        {
+            uint32_t p = sample_positions[i];
+            while (collapsed_to[p] != UINT32_MAX)
+            {
+                p = collapsed_to[p];
+            }
+            for (uint32_t t : triangles_of[p])
+            {
+                if (!removed[t])
+                {
+                    bounds[i] = std::min(bounds[i], squared_distance_to_triangle(&samples[3*i], position(corner(t, 0)), position(corner(t, 1)), position(corner(t, 2))));
+                }
+            }
+        }
+        *result_error = static_cast<float>(max_distance_to_triangles(samples, bounds, vertices, result));
+    }
+    return result;
+}
+
+void MeshData::generate_lods(unsigned int max_lods, float reduction, float max_error)
+{
+    if (!lods.empty())
+    {
+        indices.resize(lods[0].index_count);
+    }
+    lods = {MeshLod{0, static_cast<uint32_t>(indices.size()), 0.f}};
+    MeshData lod;
+    while (lods.size() < max_lods)
+    {
+        size_t previous_count = lods.back().index_count;
+        float error;
+        lod.indices = simplify(static_cast<size_t>(static_cast<float>(previous_count) * reduction), max_error, &error);
+        // Stop when the locked vertices or the error bound leave too few collapses for a worthwhile LOD, or the measured error is too large
+        if (lod.indices.empty() || static_cast<float>(lod.indices.size()) > 0.5f * (1.f + reduction) * static_cast<float>(previous_count) || error > max_error)
+        {
+            break;
+        }
+        lod.vertices.swap(vertices);
+        lod.optimize_vertex_cache();
+        lod.optimize_overdraw();
+        lod.vertices.swap(vertices);
+        lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.indices.size()), std::max(error, lods.back().error)});
+        indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+    }
+    if (lods.size() == 1)
+    {
+        lods.clear();
+    }
+}
+
+// Bounding sphere and normal cone of a meshlet from its vertices and triangles
+static void meshlet_bounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, const MeshletData& data)
+{
+    const uint32_t* meshlet_vertices = &data.vertices[meshlet.vertex_offset];
+    const uint32_t* meshlet_triangles = &data.triangles[meshlet.triangle_offset];
+    float min[3] = {INFINITY, INFINITY, INFINITY};
+    float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i=0; i<meshlet.vertex_count; i++)
+    {
+        const float* p = vertices[meshlet_vertices[i]].position;
+        for (unsigned int k=0; k<3; k++)
+        {
+            min[k] = std::min(min[k], p[k]);
+            max[k] = std::max(max[k], p[k]);
+        }
+    }
+    float squared_radius = 0.f;
+    for (unsigned int k=0; k<3; k++)
+    {
+        meshlet.center[k] = 0.5f * (min[k] + max[k]);
+    }
+    for (uint32_t i=0; i<meshlet.vertex_count; i++)
+    {
+        const float* p = vertices[meshlet_vertices[i]].position;
+        float d[3] = {p[0] - meshlet.center[0], p[1] - meshlet.center[1], p[2] - meshlet.center[2]};
+        squared_radius = std::max(squared_radius, d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+    }
+    meshlet.radius = std::sqrt(squared_radius);
+    // The axis is the average of the triangle normals, and the cone contains them all
+    std::vector<float> normals(3 * meshlet.triangle_count, 0.f);
+    float axis[3] = {0.f, 0.f, 0.f};
+    for (uint32_t t=0; t<meshlet.triangle_count; t++)
+    {
+        uint32_t packed = meshlet_triangles[t];
+        const float* p0 = vertices[meshlet_vertices[packed & 0xff]].position;
+        const float* p1 = vertices[meshlet_vertices[(packed >> 8) & 0xff]].position;
+        const float* p2 = vertices[meshlet_vertices[(packed >> 16) & 0xff]].position;
+        double n[3];
+        triangle_normal(p0, p1, p2, n);
+        double length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        for (unsigned int k=0; k<3 && length > 0.; k++)
+        {
+            normals[3*t + k] = static_cast<float>(n[k] / length);
+            axis[k] += normals[3*t + k];
+        }
+    }
+    float axis_length = std::sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    float min_dot = 1.f;
+    for (uint32_t t=0; t<meshlet.triangle_count; t++)
+    {
+        const float* n = &normals[3*t];
+        float dot = (axis_length > 0.f) ? (n[0]*axis[0] + n[1]*axis[1] + n[2]*axis[2]) / axis_length : -1.f;
+        min_dot = std::min(min_dot, dot);
+    }
+    for (unsigned int k=0; k<3; k++)
+    {
+        meshlet.cone_axis[k] = (axis_length > 0.f) ? axis[k] / axis_length : 0.f;
+    }
+    // Beyond about 84 degrees, the cone would only cull from inside the bounding sphere
+    meshlet.cone_cutoff = (min_dot <= 0.1f) ? 1.f : std::sqrt(1.f - min_dot * min_dot);
+}
+
+MeshletData MeshData::build_meshlets(unsigned int max_vertices, unsigned int max_triangles) const
+{
+    if (max_vertices < 3 || max_vertices > 256 || max_triangles < 1)
+    {
+        THROW_ERROR("a meshlet must have between 3 and 256 vertices, and at least one triangle")
+    }
+    MeshletData data;
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> local(vertices.size(), unused); // index of the vertices in the current meshlet
+    Meshlet meshlet = {};
+    auto finish = [&]()
+    {
+        if (meshlet.triangle_count == 0)
+        {
+            return;
+        }
+        for (uint32_t i=0; i<meshlet.vertex_count; i++)
+        {
+            local[data.vertices[meshlet.vertex_offset + i]] = unused;
+        }
+        meshlet_bounds(meshlet, vertices, data);
+        data.meshlets.push_back(meshlet);
+        meshlet = {};
+        meshlet.vertex_offset = data.vertices.size();
+        meshlet.triangle_offset = data.triangles.size();
+    };
+    size_t end = lods.empty() ? indices.size() : lods[0].index_count;
+    for (size_t i=0; i+2<end; i+=3)
+    {
+        const uint32_t* triangle = &indices[i];
+        unsigned int new_vertices = (local[triangle[0]] == unused) + (local[triangle[1]] == unused && triangle[1] != triangle[0]) +
+                                    (local[triangle[2]] == unused && triangle[2] != triangle[0] && triangle[2] != triangle[1]);
+        if (meshlet.vertex_count + new_vertices > max_vertices || meshlet.triangle_count + 1 > max_triangles)
+        {
+            finish();
+        }
+        uint32_t packed = 0;
+        for (unsigned int k=0; k<3; k++)
+        {
+            if (local[triangle[k]] == unused)
+            {
+                local[triangle[k]] = meshlet.vertex_count++;
+                data.vertices.push_back(triangle[k]);
+            }
+            packed |= local[triangle[k]] << (8 * k);
+        }
+        data.triangles.push_back(packed);
+        meshlet.triangle_count++;
+    }
+    finish();
+    return data;
+}
+
+std::vector<QuantizedVertex> MeshData::quantize(QuantizationBounds& bounds) const
+{
+    float position_min[3] = {0.f, 0.f, 0.f};
+    float position_max[3] = {0.f, 0.f, 0.f};
+    float uv_min[2] = {0.f, 0.f};
+    float uv_max[2] = {0.f, 0.f};
+    for (size_t i=0; i<vertices.size(); i++)
+    {
+        const Vertex& vertex = vertices[i];
+        for (unsigned int k=0; k<3; k++)
+        {
+            position_min[k] = (i == 0) ? vertex.position[k] : std::min(position_min[k], vertex.position[k]);
+            position_max[k] = (i == 0) ? vertex.position[k] : std::max(position_max[k], vertex.position[k]);
+        }
+        for (unsigned int k=0; k<2; k++)
+        {
+            uv_min[k] = (i == 0) ? vertex.uv[k] : std::min(uv_min[k], vertex.uv[k]);
+            uv_max[k] = (i == 0) ? vertex.uv[k] : std::max(uv_max[k], vertex.uv[k]);
+        }
+    }
+    for (unsigned int k=0; k<3; k++)
+    {
+        bounds.position_offset[k] = position_min[k];
+        bounds.position_scale[k] = position_max[k] - position_min[k];
+    }
+    for (unsigned int k=0; k<2; k++)
+    {
+        bounds.uv_offset[k] = uv_min[k];
+        bounds.uv_scale[k] = uv_max[k] - uv_min[k];
+    }
+    std::vector<QuantizedVertex> quantized(vertices.size());
+    for (size_t i=0; i<vertices.size(); i++)
+    {
+        const Vertex& vertex = vertices[i];
+        QuantizedVertex& q = quantized[i];
+        for (unsigned int k=0; k<3; k++)
+        {
+            q.position[k] = _quantize_unorm16(vertex.position[k], bounds.position_offset[k], bounds.position_scale[k]);
+        }
+        q.position[3] = (vertex.tangent[3] < 0.f) ? 0 : 65535;
+        _encode_octahedral(vertex.normal, q.normal);
+        _encode_octahedral(vertex.tangent, q.tangent);
+        for (unsigned int k=0; k<2; k++)
+        {
+            q.uv[k] = _quantize_unorm16(vertex.uv[k], bounds.uv_offset[k], bounds.uv_scale[k]);
+        }
+    }
+    return quantized;
+}
+
+void MeshData::_encode_octahedral(const float* vector, int8_t* encoded)
+{
+    float length = std::abs(vector[0]) + std::abs(vector[1]) + std::abs(vector[2]);
+    if (length == 0.f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    float x = vector[0] / length;
+    float y = vector[1] / length;
+    if (vector[2] < 0.f)
+    {
+        float folded_x = (1.f - std::abs(y)) * ((x >= 0.f) ? 1.f : -1.f);
+        float folded_y = (1.f - std::abs(x)) * ((y >= 0.f) ? 1.f : -1.f);
+        x = folded_x;
+        y = folded_y;
+    }
+    // Rounding to nearest is not always the closest direction once decoded, so the four neighbours are tested
+    float norm = std::sqrt(vector[0]*vector[0] + vector[1]*vector[1] + vector[2]*vector[2]);
+    float best_dot = -2.f;
+    for (float ex : {std::floor(x * 127.f), std::ceil(x * 127.f)})
+    {
+        for (float ey : {std::floor(y * 127.f), std::ceil(y * 127.f)})
+        {
+            int8_t candidate[2] = {static_cast<int8_t>(std::max(-127.f, std::min(127.f, ex))), static_cast<int8_t>(std::max(-127.f, std::min(127.f, ey)))};
+            float decoded[3];
+            _decode_octahedral(candidate, decoded);
+            float dot = (decoded[0]*vector[0] + decoded[1]*vector[1] + decoded[2]*vector[2]) / norm;
+            if (dot > best_dot)
+            {
+                best_dot = dot;
+                encoded[0] = candidate[0];
+                encoded[1] = candidate[1];
+            }
+        }
+    }
+}
+
+void MeshData::_decode_octahedral(const int8_t* encoded, float* vector)
+{
+    // As the GPU converts snorm values, and as decoded by quantization.glsl
+    float x = std::max(encoded[0] / 127.f, -1.f);
+    float y = std::max(encoded[1] / 127.f, -1.f);
+    float z = 1.f - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.f);
+    x += (x >= 0.f) ? -t : t;
+    y += (y >= 0.f) ? -t : t;
+    float length = std::sqrt(x*x + y*y + z*z);
+    vector[0] = x / length;
+    vector[1] = y / length;
+    vector[2] = z / length;
+}
+
+uint16_t MeshData::_quantize_unorm16(float value, float offset, float scale)
+{
+    if (scale <= 0.f)
+    {
+        return 0;
+    }
+    float normalized = std::max(0.f, std::min(1.f, (value - offset) / scale));
+    return static_cast<uint16_t>(std::lround(normalized * 65535.f));
+}
+
+MeshData::FifoCache::FifoCache(size_t n_vertices, uint32_t cache_size) : timestamps(n_vertices, 0), size(cache_size), time(cache_size + 1)
+{
+}
+
+unsigned int MeshData::FifoCache::triangle(const uint32_t* triangle)
+{
+    unsigned int misses = 0;
+    for (unsigned int k=0; k<3; k++)
+    {
+        uint32_t v = triangle[k];
+        if (time - timestamps[v] > size)
+        {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+void MeshData::FifoCache::reset()
+{
+    time += size + 1;
+}
@@ -0,0 +1,413 @@
+#include <GameEngine/graphics/ObjectCache.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <algorithm>
+#include <stdexcept>
+using namespace GameEngine;
+
+ObjectCache::ObjectCache(VkDevice device)
+{
+    _device = device;
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (vkCreatePipelineCache(_device, &cache_info, HostAllocator::callbacks(), &_vk_pipeline_cache) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the pipeline cache")
+    }
+}
+
+ObjectCache::~ObjectCache()
+{
+    for (Retired& retired : _retired)
+    {
+        vkDestroyPipeline(_device, retired.pipeline, HostAllocator::callbacks());
+        vkDestroyShaderModule(_device, retired.module, HostAllocator::callbacks());
+    }
+    for (std::pair<const PipelineState, VkPipeline>& pipeline : _pipelines)
+    {
+        vkDestroyPipeline(_device, pipeline.second, HostAllocator::callbacks());
+    }
+    for (std::pair<const PipelineLayoutKey, VkPipelineLayout>& layout : _pipeline_layouts)
+    {
+        vkDestroyPipelineLayout(_device, layout.second, HostAllocator::callbacks());
+    }
+    for (std::pair<const RenderPassState, VkRenderPass>& render_pass : _render_passes)
+    {
+        vkDestroyRenderPass(_device, render_pass.second, HostAllocator::callbacks());
+    }
+    for (std::pair<const SamplerKey, VkSampler>& sampler : _samplers)
+    {
+        vkDestroySampler(_device, sampler.second, HostAllocator::callbacks());
+    }
+    vkDestroyPipelineCache(_device, _vk_pipeline_cache, HostAllocator::callbacks());
+}
+
+VkPipelineLayout ObjectCache::pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants)
+{
+    PipelineLayoutKey key = {set_layouts, push_constants};
+    return _find_or_create(_layouts_mutex, _pipeline_layouts, key, [this, &key]()
+    {
+        VkPipelineLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_info.setLayoutCount = key.set_layouts.size();
+        layout_info.pSetLayouts = key.set_layouts.data();
+        layout_info.pushConstantRangeCount = key.push_constants.size();
+        layout_info.pPushConstantRanges = key.push_constants.data();
+        VkPipelineLayout layout;
+        if (vkCreatePipelineLayout(_device, &layout_info, HostAllocator::callbacks(), &layout) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the pipeline layout")
+        }
+        return layout;
+    });
+}
+
+VkRenderPass ObjectCache::render_pass(const RenderPassState& state)
+{
+    return _find_or_create(_render_passes_mutex, _render_passes, state, [this, &state]()
+    {
+        std::vector<VkAttachmentReference> color_references;
+        for (uint32_t index : state.color_attachments)
+        {
+            color_references.push_back({index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        }
+        VkAttachmentReference depth_reference = {static_cast<uint32_t>(state.depth_attachment), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = color_references.size();
+        subpass.pColorAttachments = color_references.data();
+        subpass.pDepthStencilAttachment = (state.depth_attachment >= 0) ? &depth_reference : nullptr;
+        // Wait for the previous uses of the attachments before writing them
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        VkRenderPassCreateInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        render_pass_info.attachmentCount = state.attachments.size();
+        render_pass_info.pAttachments = state.attachments.data();
+        render_pass_info.subpassCount = 1;
+        render_pass_info.pSubpasses = &subpass;
+        render_pass_info.dependencyCount = 1;
+        render_pass_info.pDependencies = &dependency;
+        VkRenderPass render_pass;
+        if (vkCreateRenderPass(_device, &render_pass_info, HostAllocator::callbacks(), &render_pass) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the render pass")
+        }
+        return render_pass;
+    });
+}
+
+VkSampler ObjectCache::sampler(const VkSamplerCreateInfo& info)
+{
+    SamplerKey key = {info};
+    key.info.pNext = nullptr;
+    return _find_or_create(_samplers_mutex, _samplers, key, [this, &key]()
+    {
+        VkSampler sampler;
+        if (vkCreateSampler(_device, &key.info, HostAllocator::callbacks(), &sampler) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the sampler")
+        }
+        return sampler;
+    });
+}
+
+VkPipeline ObjectCache::pipeline(const PipelineState& state)
+{
+    VkPipeline pipeline = find_pipeline(state);
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        return pipeline;
+    }
+    // Compiling a pipeline takes milliseconds, so it is done without the lock to not stall the other threads (and the other compilations)
+    pipeline = state.is_compute() ? _create_compute_pipeline(state) : _create_graphics_pipeline(state);
+    std::unique_lock<std::shared_mutex> lock(_pipelines_mutex);
+    std::pair<std::unordered_map<PipelineState, VkPipeline, KeyHash>::iterator, bool> inserted = _pipelines.emplace(state, pipeline);
+    if (!inserted.second)
+    {
+        // Another thread compiled the same state in the meantime
+        vkDestroyPipeline(_device, pipeline, HostAllocator::callbacks());
+    }
+    return inserted.first->second;
+}
+
+VkPipeline ObjectCache::find_pipeline(const PipelineState& state)
+{
+    std::shared_lock<std::shared_mutex> lock(_pipelines_mutex);
+    std::unordered_map<PipelineState, VkPipeline, KeyHash>::iterator it = _pipelines.find(state);
+    return (it != _pipelines.end()) ? it->second : VK_NULL_HANDLE;
+}
+
+void ObjectCache::precompile(const std::vector<PipelineState>& states, JobCounter* counter)
+{
+    for (const PipelineState& state : states)
+    {
+        JobSystem::submit([this, state]()
+        {
+            // An exception escaping a job would terminate the program: a state failing to compile (error already printed) is skipped,
+            // find_pipeline keeps returning VK_NULL_HANDLE for it
+            try
+            {
+                pipeline(state);
+            }
+            catch (const std::runtime_error&)
+            {
+            }
+        }, counter);
+    }
+}
+
+std::vector<PipelineState> ObjectCache::pipelines_using(VkShaderModule module)
+{
+    std::vector<PipelineState> states;
+    std::shared_lock<std::shared_mutex> lock(_pipelines_mutex);
+    for (const std::pair<const PipelineState, VkPipeline>& pipeline : _pipelines)
+    {
+        for (const ShaderStage& stage : pipeline.first.stages)
+        {
+            if (stage.module == module)
+            {
+                states.push_back(pipeline.first);
+                break;
+            }
+        }
+    }
+    return states;
+}
+
+void ObjectCache::evict_pipelines(VkShaderModule module)
+{
+    std::vector<Retired> evicted;
+    {
+        std::unique_lock<std::shared_mutex> lock(_pipelines_mutex);
+        for (std::unordered_map<PipelineState, VkPipeline, KeyHash>::iterator it = _pipelines.begin(); it != _pipelines.end();)
+        {
+            bool uses_module = false;
+            for (const ShaderStage& stage : it->first.stages)
+            {
+                uses_module = uses_module || (stage.module == module);
+            }
+            if (uses_module)
+            {
+                Retired retired;
+                retired.pipeline = it->second;
+                evicted.push_back(retired);
+                it = _pipelines.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(_retired_mutex);
+    _retired.insert(_retired.end(), evicted.begin(), evicted.end());
+}
+
+void ObjectCache::retire(VkShaderModule module)
+{
+    Retired retired;
+    retired.module = module;
+    std::lock_guard<std::mutex> lock(_retired_mutex);
+    _retired.push_back(retired);
+}
+
+void ObjectCache::_begin_frame(unsigned int max_frames_in_flight)
+{
+    std::lock_guard<std::mutex> lock(_retired_mutex);
+    // The frame being recorded when an object was retired might use it too, hence the extra frame
+    unsigned int delay = (max_frames_in_flight + 1) * std::max(_n_swap_chains, 1u);
+    size_t kept = 0;
+    for (Retired& retired : _retired)
+    {
+        retired.frames++;
+        if (retired.frames > delay)
+        {
+            vkDestroyPipeline(_device, retired.pipeline, HostAllocator::callbacks());
+            vkDestroyShaderModule(_device, retired.module, HostAllocator::callbacks());
+        }
+        else
+        {
+            _retired[kept++] = retired;
+        }
+    }
+    _retired.resize(kept);
+}
+
+bool ObjectCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& other) const
+{
+    if (set_layouts != other.set_layouts || push_constants.size() != other.push_constants.size())
+    {
+        return false;
+    }
+    for (size_t i=0; i<push_constants.size(); i++)
+    {
+        if (push_constants[i].stageFlags != other.push_constants[i].stageFlags || push_constants[i].offset != other.push_constants[i].offset ||
+            push_constants[i].size != other.push_constants[i].size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ObjectCache::SamplerKey::operator==(const SamplerKey& other) const
+{
+    const VkSamplerCreateInfo& a = info;
+    const VkSamplerCreateInfo& b = other.info;
+    return a.flags == b.flags && a.magFilter == b.magFilter && a.minFilter == b.minFilter && a.mipmapMode == b.mipmapMode &&
+           a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV && a.addressModeW == b.addressModeW &&
+           a.mipLodBias == b.mipLodBias && a.anisotropyEnable == b.anisotropyEnable && a.maxAnisotropy == b.maxAnisotropy &&
+           a.compareEnable == b.compareEnable && a.compareOp == b.compareOp && a.minLod == b.minLod && a.maxLod == b.maxLod &&
+           a.borderColor == b.borderColor && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
+
+size_t ObjectCache::KeyHash::operator()(const PipelineLayoutKey& key) const
+{
+    uint64_t hash = Utilities::hash(key.set_layouts.data(), key.set_layouts.size() * sizeof(VkDescriptorSetLayout));
+    for (const VkPushConstantRange& range : key.push_constants)
+    {
+        Utilities::hash_combine(hash, (static_cast<uint64_t>(range.stageFlags) << 32) | range.offset);
+        Utilities::hash_combine(hash, range.size);
+    }
+    return static_cast<size_t>(hash);
+}
+
+size_t ObjectCache::KeyHash::operator()(const SamplerKey& key) const
+{
+    const VkSamplerCreateInfo& info = key.info;
+    const uint32_t fields[] = {info.flags, static_cast<uint32_t>(info.magFilter), static_cast<uint32_t>(info.minFilter),
+                               static_cast<uint32_t>(info.mipmapMode), static_cast<uint32_t>(info.addressModeU),
+                               static_cast<uint32_t>(info.addressModeV), static_cast<uint32_t>(info.addressModeW), info.anisotropyEnable,
+                               info.compareEnable, static_cast<uint32_t>(info.compareOp), static_cast<uint32_t>(info.borderColor),
+                               info.unnormalizedCoordinates};
+    const float float_fields[] = {info.mipLodBias, info.maxAnisotropy, info.minLod, info.maxLod};
+    uint64_t hash = Utilities::hash(fields, sizeof(fields));
+    return static_cast<size_t>(Utilities::hash(float_fields, sizeof(float_fields), hash));
+}
+
+size_t ObjectCache::KeyHash::operator()(const RenderPassState& key) const
+{
+    return static_cast<size_t>(key.hash());
+}
+
+size_t ObjectCache::KeyHash::operator()(const PipelineState& key) const
+{
+    return static_cast<size_t>(key.hash());
+}
+
+VkPipeline ObjectCache::_create_graphics_pipeline(const PipelineState& state)
+{
+    std::vector<VkSpecializationInfo> specializations(state.stages.size());
+    std::vector<VkPipelineShaderStageCreateInfo> stages(state.stages.size());
+    for (size_t i=0; i<state.stages.size(); i++)
+    {
+        stages[i] = _stage_info(state.stages[i], specializations[i]);
+    }
+    VkPipelineVertexInputStateCreateInfo vertex_input{};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = state.vertex_bindings.size();
+    vertex_input.pVertexBindingDescriptions = state.vertex_bindings.data();
+    vertex_input.vertexAttributeDescriptionCount = state.vertex_attributes.size();
+    vertex_input.pVertexAttributeDescriptions = state.vertex_attributes.data();
+    VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = state.topology;
+    VkPipelineViewportStateCreateInfo viewport{};
+    viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = state.polygon_mode;
+    rasterization.cullMode = state.cull_mode;
+    rasterization.frontFace = state.front_face;
+    rasterization.lineWidth = 1.f;
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = state.samples;
+    VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+    depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depth_stencil.depthTestEnable = state.depth_test;
+    depth_stencil.depthWriteEnable = state.depth_write;
+    depth_stencil.depthCompareOp = state.depth_compare;
+    VkPipelineColorBlendAttachmentState blend_attachment{};
+    blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blend_attachment.blendEnable = state.alpha_blending;
+    blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    std::vector<VkPipelineColorBlendAttachmentState> blend_attachments(state.color_attachment_count, blend_attachment);
+    VkPipelineColorBlendStateCreateInfo blend{};
+    blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    blend.attachmentCount = blend_attachments.size();
+    blend.pAttachments = blend_attachments.data();
+    VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamic_states;
+    VkGraphicsPipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.stageCount = stages.size();
+    pipeline_info.pStages = stages.data();
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport;
+    pipeline_info.pRasterizationState = &rasterization;
+    pipeline_info.pMultisampleState = &multisample;
+    pipeline_info.pDepthStencilState = &depth_stencil;
+    pipeline_info.pColorBlendState = &blend;
+    pipeline_info.pDynamicState = &dynamic;
+    pipeline_info.layout = state.layout;
+    pipeline_info.renderPass = state.render_pass;
+    pipeline_info.subpass = state.subpass;
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(_device, _vk_pipeline_cache, 1, &pipeline_info, HostAllocator::callbacks(), &pipeline) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the graphics pipeline")
+    }
+    return pipeline;
+}
+
+VkPipeline ObjectCache::_create_compute_pipeline(const PipelineState& state)
+{
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    VkSpecializationInfo specialization;
+    pipeline_info.stage = _stage_info(state.stages[0], specialization);
+    pipeline_info.layout = state.layout;
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(_device, _vk_pipeline_cache, 1, &pipeline_info, HostAllocator::callbacks(), &pipeline) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the compute pipeline")
+    }
+    return pipeline;
+}
+
+VkPipelineShaderStageCreateInfo ObjectCache::_stage_info(const ShaderStage& stage, VkSpecializationInfo& specialization)
+{
+    VkPipelineShaderStageCreateInfo stage_info{};
+    stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_info.stage = stage.stage;
+    stage_info.module = stage.module;
+    stage_info.pName = stage.entry_point.c_str();
+    if (!stage.specialization_entries.empty())
+    {
+        specialization.mapEntryCount = stage.specialization_entries.size();
+        specialization.pMapEntries = stage.specialization_entries.data();
+        specialization.dataSize = stage.specialization_data.size();
+        specialization.pData = stage.specialization_data.data();
+        stage_info.pSpecializationInfo = &specialization;
+    }
+    return stage_info;
+}
@@ -0,0 +1,159 @@
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+using namespace GameEngine;
+
+// Structures are hashed field by field, as their padding bytes are undefined
+template<typename T>
+static void hash_value(uint64_t& hash, const T& value)
+{
+    hash = Utilities::hash(&value, sizeof(T), hash);
+}
+
+bool ShaderStage::operator==(const ShaderStage& other) const
+{
+    if (stage != other.stage || module != other.module || entry_point != other.entry_point || specialization_data != other.specialization_data ||
+        specialization_entries.size() != other.specialization_entries.size())
+    {
+        return false;
+    }
+    for (size_t i=0; i<specialization_entries.size(); i++)
+    {
+        const VkSpecializationMapEntry& a = specialization_entries[i];
+        const VkSpecializationMapEntry& b = other.specialization_entries[i];
+        if (a.constantID != b.constantID || a.offset != b.offset || a.size != b.size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderPassState::operator==(const RenderPassState& other) const
+{
+    if (attachments.size() != other.attachments.size() || color_attachments != other.color_attachments || depth_attachment != other.depth_attachment)
+    {
+        return false;
+    }
+    for (size_t i=0; i<attachments.size(); i++)
+    {
+        const VkAttachmentDescription& a = attachments[i];
+        const VkAttachmentDescription& b = other.attachments[i];
+        if (a.flags != b.flags || a.format != b.format || a.samples != b.samples || a.loadOp != b.loadOp || a.storeOp != b.storeOp ||
+            a.stencilLoadOp != b.stencilLoadOp || a.stencilStoreOp != b.stencilStoreOp || a.initialLayout != b.initialLayout || a.finalLayout != b.finalLayout)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t RenderPassState::hash() const
+{
+    uint64_t hash = Utilities::hash(nullptr, 0);
+    for (const VkAttachmentDescription& attachment : attachments)
+    {
+        hash_value(hash, attachment.flags);
+        hash_value(hash, attachment.format);
+        hash_value(hash, attachment.samples);
+        hash_value(hash, attachment.loadOp);
+        hash_value(hash, attachment.storeOp);
+        hash_value(hash, attachment.stencilLoadOp);
+        hash_value(hash, attachment.stencilStoreOp);
+        hash_value(hash, attachment.initialLayout);
+        hash_value(hash, attachment.finalLayout);
+    }
+    for (uint32_t index : color_attachments)
+    {
+        hash_value(hash, index);
+    }
+    hash_value(hash, depth_attachment);
+    return hash;
+}
+
+bool PipelineState::is_compute() const
+{
+    return stages.size() == 1 && stages[0].stage == VK_SHADER_STAGE_COMPUTE_BIT;
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+    if (stages.size() != other.stages.size() || vertex_bindings.size() != other.vertex_bindings.size() ||
+        vertex_attributes.size() != other.vertex_attributes.size())
+    {
+        return false;
+    }
+    for (size_t i=0; i<stages.size(); i++)
+    {
+        if (!(stages[i] == other.stages[i]))
+        {
+            return false;
+        }
+    }
+    for (size_t i=0; i<vertex_bindings.size(); i++)
+    {
+        const VkVertexInputBindingDescription& a = vertex_bindings[i];
+        const VkVertexInputBindingDescription& b = other.vertex_bindings[i];
+        if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+        {
+            return false;
+        }
+    }
+    for (size_t i=0; i<vertex_attributes.size(); i++)
+    {
+        const VkVertexInputAttributeDescription& a = vertex_attributes[i];
+        const VkVertexInputAttributeDescription& b = other.vertex_attributes[i];
+        if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+        {
+            return false;
+        }
+    }
+    return topology == other.topology && polygon_mode == other.polygon_mode && cull_mode == other.cull_mode && front_face == other.front_face &&
+           depth_test == other.depth_test && depth_write == other.depth_write && depth_compare == other.depth_compare &&
+           alpha_blending == other.alpha_blending && color_attachment_count == other.color_attachment_count && samples == other.samples &&
+           layout == other.layout && render_pass == other.render_pass && subpass == other.subpass;
+}
+
+uint64_t PipelineState::hash() const
+{
+    uint64_t hash = Utilities::hash(nullptr, 0);
+    for (const ShaderStage& stage : stages)
+    {
+        hash_value(hash, stage.stage);
+        hash_value(hash, stage.module);
+        hash = Utilities::hash(stage.entry_point.data(), stage.entry_point.size(), hash);
+        for (const VkSpecializationMapEntry& entry : stage.specialization_entries)
+        {
+            hash_value(hash, entry.constantID);
+            hash_value(hash, entry.offset);
+            hash_value(hash, entry.size);
+        }
+        hash = Utilities::hash(stage.specialization_data.data(), stage.specialization_data.size(), hash);
+    }
+    for (const VkVertexInputBindingDescription& binding : vertex_bindings)
+    {
+        hash_value(hash, binding.binding);
+        hash_value(hash, binding.stride);
+        hash_value(hash, binding.inputRate);
+    }
+    for (const VkVertexInputAttributeDescription& attribute : vertex_attributes)
+    {
+        hash_value(hash, attribute.location);
+        hash_value(hash, attribute.binding);
+        hash_value(hash, attribute.format);
+        hash_value(hash, attribute.offset);
+    }
+    hash_value(hash, topology);
+    hash_value(hash, polygon_mode);
+    hash_value(hash, cull_mode);
+    hash_value(hash, front_face);
+    hash_value(hash, depth_test);
+    hash_value(hash, depth_write);
+    hash_value(hash, depth_compare);
+    hash_value(hash, alpha_blending);
+    hash_value(hash, color_attachment_count);
+    hash_value(hash, samples);
+    hash_value(hash, layout);
+    hash_value(hash, render_pass);
+    hash_value(hash, subpass);
+    return hash;
+}
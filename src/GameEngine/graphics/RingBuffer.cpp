@@ -0,0 +1,130 @@
+#include <GameEngine/graphics/RingBuffer.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <algorithm>
+using namespace GameEngine;
+
+RingBuffer::RingBuffer(const GPU& _gpu, VkDeviceSize frame_size, unsigned int max_frames_in_flight, VkDeviceSize max_allocation_size,
+                       VkBufferUsageFlags usage) : gpu(_gpu)
+{
+    const VkPhysicalDeviceLimits& limits = gpu._device_properties.limits;
+    // Alignments are all powers of 2, so the largest is a multiple of the others
+    _alignment = std::max({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, limits.nonCoherentAtomSize, VkDeviceSize(16)});
+    _frame_size = (frame_size + _alignment - 1) & ~(_alignment - 1);
+    _max_allocation_size = std::min((max_allocation_size + _alignment - 1) & ~(_alignment - 1), _frame_size);
+    _max_frames_in_flight = max_frames_in_flight;
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    // The bound range starts at the offset of an allocation, so the buffer is padded for the allocations at the end of the last region
+    buffer_info.size = _frame_size * max_frames_in_flight + _max_allocation_size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(gpu._logical_device, &buffer_info, HostAllocator::callbacks(), &_vk_buffer) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to create the ring buffer")
+    }
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(gpu._logical_device, _vk_buffer, &requirements);
+    // Prefer memory that is also device local (resizable BAR), then coherent memory that needs no flush
+    const VkMemoryPropertyFlags preferences[] = {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+    VkMemoryAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = requirements.size;
+    bool found = false;
+    for (VkMemoryPropertyFlags properties : preferences)
+    {
+        for (uint32_t i=0; i<gpu._device_memory.memoryTypeCount && !found; i++)
+        {
+            if ((requirements.memoryTypeBits & (1 << i)) && (gpu._device_memory.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                allocate_info.memoryTypeIndex = i;
+                _coherent = (properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                // device local host visible heaps are small on GPUs without resizable BAR, so a failure falls back to the next preference
+                found = (vkAllocateMemory(gpu._logical_device, &allocate_info, HostAllocator::callbacks(), &_vk_memory) == VK_SUCCESS);
+            }
+        }
+    }
+    if (!found)
+    {
+        THROW_ERROR("failed to allocate the ring buffer memory")
+    }
+    vkBindBufferMemory(gpu._logical_device, _vk_buffer, _vk_memory, 0);
+    void* mapped;
+    if (vkMapMemory(gpu._logical_device, _vk_memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to map the ring buffer memory")
+    }
+    _mapped = static_cast<char*>(mapped);
+}
+
+RingBuffer::~RingBuffer()
+{
+    vkUnmapMemory(gpu._logical_device, _vk_memory);
+    vkDestroyBuffer(gpu._logical_device, _vk_buffer, HostAllocator::callbacks());
+    vkFreeMemory(gpu._logical_device, _vk_memory, HostAllocator::callbacks());
+}
+
+RingBuffer::Allocation RingBuffer::allocate(VkDeviceSize size)
+{
+    if (size > _max_allocation_size)
+    {
+        THROW_ERROR("the ring buffer allocations are limited to " + std::to_string(_max_allocation_size) + " bytes, " + std::to_string(size) + " were requested")
+    }
+    // Rounding the sizes keeps every offset aligned, so a single atomic addition is enough
+    VkDeviceSize aligned_size = (size + _alignment - 1) & ~(_alignment - 1);
+    VkDeviceSize offset = _offset.fetch_add(aligned_size);
+    if (offset + aligned_size > _frame_size)
+    {
+        THROW_ERROR("the ring buffer region of the frame is full (" + std::to_string(_frame_size) + " bytes)")
+    }
+    Allocation allocation;
+    allocation.buffer = _vk_buffer;
+    allocation.offset = static_cast<uint32_t>(_frame_index * _frame_size + offset);
+    allocation.data = _mapped + allocation.offset;
+    allocation.size = size;
+    return allocation;
+}
+
+VkBuffer RingBuffer::buffer() const
+{
+    return _vk_buffer;
+}
+
+VkDeviceSize RingBuffer::frame_size() const
+{
+    return _frame_size;
+}
+
+VkDeviceSize RingBuffer::max_allocation_size() const
+{
+    return _max_allocation_size;
+}
+
+VkDeviceSize RingBuffer::used() const
+{
+    return std::min(_offset.load(), _frame_size);
+}
+
+void RingBuffer::_begin_frame(unsigned int frame_index)
+{
+    _frame_index = frame_index % _max_frames_in_flight;
+    _offset = 0;
+}
+
+void RingBuffer::_flush()
+{
+    VkDeviceSize used_size = used();
+    if (_coherent || used_size == 0)
+    {
+        return;
+    }
+    // The region and the used size are multiples of nonCoherentAtomSize
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = _vk_memory;
+    range.offset = _frame_index * _frame_size;
+    range.size = used_size;
+    vkFlushMappedMemoryRanges(gpu._logical_device, 1, &range);
+}
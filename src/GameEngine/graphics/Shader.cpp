@@ -1,44 +1,65 @@
 #include <GameEngine/graphics/Shader.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
 using namespace GameEngine;
 
-Shader::Shader(const Shader& other) : gpu(other.gpu)
+Shader::Shader(const GPU& _gpu, const std::string& file_path) : gpu(_gpu)
 {
-    _vk_shader = other._vk_shader;
+    MappedFile file(file_path);
+    if (file.size() % 4 != 0 || file.size() == 0)
+    {
+        THROW_ERROR("'" + file_path + "' is not a SPIR-V file: its size is not a non-zero multiple of 4 bytes")
+    }
+    _set_vk_shader(file.data(), file.size());
 }
 
-Shader::Shader(const GPU& _gpu, const std::string& file_path) : gpu(_gpu)
+Shader::Shader(const GPU& _gpu, const std::vector<unsigned char>& code) : gpu(_gpu)
 {
-    _set_vk_shader(load_binary(file_path));
+    _set_vk_shader(code.data(), code.size());
 }
 
-Shader::Shader(const GPU& _gpu, const std::vector<unsigned char>& code) : gpu(_gpu)
+Shader::Shader(const GPU& _gpu, const Archive& archive, const std::string& path) : gpu(_gpu)
 {
-    _set_vk_shader(code);
+    const ArchiveEntry* entry = archive.find(path);
+    if (entry == nullptr)
+    {
+        THROW_ERROR("The archive '" + archive._file.path() + "' has no shader '" + path + "'")
+    }
+    const unsigned char* code = archive.data(*entry);
+    if (entry->compression == ARCHIVE_UNCOMPRESSED && reinterpret_cast<uintptr_t>(code) % sizeof(uint32_t) == 0)
+    {
+        _set_vk_shader(code, entry->size);
+        return;
+    }
+    std::vector<unsigned char> decompressed = archive.read(*entry);
+    _set_vk_shader(decompressed.data(), decompressed.size());
 }
 
-std::vector<unsigned char> Shader::load_binary(const std::string& file_path)
+Shader::~Shader()
 {
-    std::ifstream file(file_path, std::ios::ate | std::ios::binary);
-    if (!file.is_open())
+    // The cached pipelines are keyed by the module handle, which the driver can reuse for a new module once this one is destroyed
+    if (_vk_shader != VK_NULL_HANDLE)
     {
-        THROW_ERROR("failed to open file")
+        gpu._object_cache->evict_pipelines(_vk_shader);
+        gpu._object_cache->retire(_vk_shader);
     }
-    size_t fileSize = static_cast<size_t>(file.tellg());
-    std::vector<unsigned char> buffer(fileSize);
-    file.seekg(0);
-    file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-    file.close();
-    return buffer;
 }
 
-void Shader::_set_vk_shader(const std::vector<unsigned char>& code)
+std::vector<unsigned char> Shader::load_binary(const std::string& file_path)
+{
+    MappedFile file(file_path);
+    return std::vector<unsigned char>(file.data(), file.data() + file.size());
+}
+
+void Shader::_set_vk_shader(const unsigned char* code, size_t size)
 {
+    reflection = ShaderReflection(code, size);
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-    if (vkCreateShaderModule(gpu._logical_device, &createInfo, nullptr, &_vk_shader) != VK_SUCCESS)
+    createInfo.codeSize = size;
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code);
+    if (vkCreateShaderModule(gpu._logical_device, &createInfo, HostAllocator::callbacks(), &_vk_shader) != VK_SUCCESS)
     {
         THROW_ERROR("failed to create shader module")
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,539 @@
+#include <GameEngine/graphics/ShaderReflection.hpp>
+#include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/DescriptorSets.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
+#include <GameEngine/graphics/PipelineState.hpp>
+#include <algorithm>
+#include <cstring>
+using namespace GameEngine;
+
+// SPIR-V opcodes, decorations and enumerants used by the reflection
+enum SpirvOpcode : uint32_t
+{
+    OpName = 5, OpEntryPoint = 15, OpTypeVoid = 19, OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24,
+    OpTypeImage = 25, OpTypeSampler = 26, OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30,
+    OpTypePointer = 32, OpConstant = 43, OpSpecConstantTrue = 48, OpSpecConstantFalse = 49, OpSpecConstant = 50, OpVariable = 59,
+    OpDecorate = 71, OpMemberDecorate = 72, OpTypeAccelerationStructureKHR = 5341
+};
+enum SpirvDecoration : uint32_t
+{
+    DecorationSpecId = 1, DecorationBlock = 2, DecorationBufferBlock = 3, DecorationArrayStride = 6, DecorationMatrixStride = 7, DecorationBuiltIn = 11,
+    DecorationLocation = 30, DecorationBinding = 33, DecorationDescriptorSet = 34, DecorationOffset = 35
+};
+enum SpirvStorageClass : uint32_t
+{
+    StorageClassUniformConstant = 0, StorageClassInput = 1, StorageClassUniform = 2, StorageClassPushConstant = 9, StorageClassStorageBuffer = 12
+};
+
+ShaderReflection::ShaderReflection()
+{
+}
+
+ShaderReflection::ShaderReflection(const std::vector<unsigned char>& code) : ShaderReflection(code.data(), code.size())
+{
+}
+
+ShaderReflection::ShaderReflection(const unsigned char* code, size_t size)
+{
+    if (size % 4 != 0)
+    {
+        THROW_ERROR("invalid SPIR-V code: the size is not a multiple of 4 bytes")
+    }
+    if (reinterpret_cast<uintptr_t>(code) % alignof(uint32_t) == 0)
+    {
+        _parse(reinterpret_cast<const uint32_t*>(code), size / 4);
+        return;
+    }
+    std::vector<uint32_t> words(size / 4);
+    std::memcpy(words.data(), code, size);
+    _parse(words.data(), words.size());
+}
+
+ShaderReflection::~ShaderReflection()
+{
+}
+
+VkShaderStageFlags ShaderReflection::stages() const
+{
+    VkShaderStageFlags flags = 0;
+    for (const EntryPoint& entry_point : entry_points)
+    {
+        flags |= entry_point.stage;
+    }
+    return flags;
+}
+
+void ShaderReflection::merge(const ShaderReflection& other)
+{
+    entry_points.insert(entry_points.end(), other.entry_points.begin(), other.entry_points.end());
+    for (const Binding& binding : other.bindings)
+    {
+        std::vector<Binding>::iterator it = std::find_if(bindings.begin(), bindings.end(),
+            [&binding](const Binding& b) {return b.set == binding.set && b.binding == binding.binding;});
+        if (it == bindings.end())
+        {
+            bindings.push_back(binding);
+        }
+        else if (it->type != binding.type || it->count != binding.count)
+        {
+            THROW_ERROR("The binding " + std::to_string(binding.binding) + " of set " + std::to_string(binding.set) + " is declared differently by two stages")
+        }
+        else
+        {
+            it->stages |= binding.stages;
+        }
+    }
+    std::sort(bindings.begin(), bindings.end(), [](const Binding& a, const Binding& b) {return (a.set != b.set) ? a.set < b.set : a.binding < b.binding;});
+    for (const VkPushConstantRange& range : other.push_constants)
+    {
+        std::vector<VkPushConstantRange>::iterator it = std::find_if(push_constants.begin(), push_constants.end(),
+            [&range](const VkPushConstantRange& r) {return r.offset == range.offset && r.size == range.size;});
+        if (it == push_constants.end())
+        {
+            push_constants.push_back(range);
+        }
+        else
+        {
+            it->stageFlags |= range.stageFlags;
+        }
+    }
+    vertex_inputs.insert(vertex_inputs.end(), other.vertex_inputs.begin(), other.vertex_inputs.end());
+    std::sort(vertex_inputs.begin(), vertex_inputs.end(), [](const VertexInput& a, const VertexInput& b) {return a.location < b.location;});
+    for (const SpecializationConstant& constant : other.specialization_constants)
+    {
+        std::vector<SpecializationConstant>::iterator it = std::find_if(specialization_constants.begin(), specialization_constants.end(),
+            [&constant](const SpecializationConstant& c) {return c.id == constant.id;});
+        if (it == specialization_constants.end())
+        {
+            specialization_constants.push_back(constant);
+        }
+        else if (it->size != constant.size)
+        {
+            THROW_ERROR("The specialization constant " + std::to_string(constant.id) + " is declared with different types by two stages")
+        }
+    }
+    std::sort(specialization_constants.begin(), specialization_constants.end(), [](const SpecializationConstant& a, const SpecializationConstant& b) {return a.id < b.id;});
+}
+
+VkPipelineLayout ShaderReflection::pipeline_layout(const GPU& gpu, DescriptorSets& descriptor_sets,
+                                                   const std::vector<VkDescriptorSetLayout>& fixed_set_layouts, bool dynamic_buffers) const
+{
+    uint32_t n_sets = fixed_set_layouts.size();
+    for (const Binding& binding : bindings)
+    {
+        n_sets = std::max(n_sets, binding.set + 1);
+    }
+    std::vector<VkDescriptorSetLayout> set_layouts(fixed_set_layouts);
+    for (uint32_t set = fixed_set_layouts.size(); set < n_sets; set++)
+    {
+        // Sets not used by any stage get an empty layout
+        std::vector<VkDescriptorSetLayoutBinding> set_bindings;
+        for (const Binding& binding : bindings)
+        {
+            if (binding.set != set)
+            {
+                continue;
+            }
+            if (binding.count == 0)
+            {
+                THROW_ERROR("The unbounded array '" + binding.name + "' of set " + std::to_string(set) + " must be in a fixed set layout")
+            }
+            VkDescriptorSetLayoutBinding set_binding{};
+            set_binding.binding = binding.binding;
+            set_binding.descriptorType = binding.type;
+            if (dynamic_buffers && binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            {
+                set_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+            else if (dynamic_buffers && binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            {
+                set_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            }
+            set_binding.descriptorCount = binding.count;
+            set_binding.stageFlags = binding.stages;
+            set_bindings.push_back(set_binding);
+        }
+        set_layouts.push_back(descriptor_sets.layout(set_bindings));
+    }
+    return gpu._object_cache->pipeline_layout(set_layouts, push_constants);
+}
+
+void ShaderReflection::vertex_input(PipelineState& state, const std::map<uint32_t, VkFormat>& formats, uint32_t binding) const
+{
+    state.vertex_bindings.clear();
+    state.vertex_attributes.clear();
+    uint32_t offset = 0;
+    for (const VertexInput& input : vertex_inputs)
+    {
+        std::map<uint32_t, VkFormat>::const_iterator it = formats.find(input.location);
+        VkFormat format = (it != formats.end()) ? it->second : input.format;
+        uint32_t size = _format_size(format);
+        if (size == 0)
+        {
+            THROW_ERROR("The vertex input '" + input.name + "' at location " + std::to_string(input.location) + " has no supported format")
+        }
+        state.vertex_attributes.push_back({input.location, binding, format, offset});
+        offset += size;
+    }
+    if (!vertex_inputs.empty())
+    {
+        state.vertex_bindings.push_back({binding, offset, VK_VERTEX_INPUT_RATE_VERTEX});
+    }
+}
+
+uint32_t ShaderReflection::_format_size(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8_UNORM: case VK_FORMAT_R8G8_SNORM: case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8_SINT:
+        case VK_FORMAT_R16_UNORM: case VK_FORMAT_R16_SNORM: case VK_FORMAT_R16_UINT: case VK_FORMAT_R16_SINT: case VK_FORMAT_R16_SFLOAT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SNORM: case VK_FORMAT_R8G8B8A8_UINT: case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32: case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
+        case VK_FORMAT_R16G16_UNORM: case VK_FORMAT_R16G16_SNORM: case VK_FORMAT_R16G16_UINT: case VK_FORMAT_R16G16_SINT: case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32_SINT: case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_UNORM: case VK_FORMAT_R16G16B16A16_SNORM: case VK_FORMAT_R16G16B16A16_UINT: case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R64_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32_UINT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: case VK_FORMAT_R32G32B32A32_SINT: case VK_FORMAT_R32G32B32A32_UINT: case VK_FORMAT_R64G64_SFLOAT:
+            return 16;
+        case VK_FORMAT_R64G64B64_SFLOAT:
+            return 24;
+        case VK_FORMAT_R64G64B64A64_SFLOAT:
+            return 32;
+        default:
+            return 0;
+    }
+}
+
+void ShaderReflection::_parse(const uint32_t* words, size_t n_words)
+{
+    if (n_words < 5 || words[0] != 0x07230203)
+    {
+        THROW_ERROR("invalid SPIR-V code: bad magic number")
+    }
+    std::vector<Id> ids(words[3]);
+    std::vector<uint32_t> variables;
+    std::vector<uint32_t> specialization_ids;
+    // Check every id read from the code, so that a corrupted module can't make the parser read out of bounds
+    auto id = [&ids](uint32_t index) -> Id&
+    {
+        if (index >= ids.size())
+        {
+            THROW_ERROR("invalid SPIR-V code: id out of bounds")
+        }
+        return ids[index];
+    };
+    auto literal_string = [](const uint32_t* operands, size_t n_words) -> std::string
+    {
+        const char* characters = reinterpret_cast<const char*>(operands);
+        return std::string(characters, strnlen(characters, n_words * 4));
+    };
+    for (size_t i = 5; i < n_words;)
+    {
+        uint32_t opcode = words[i] & 0xFFFF;
+        uint32_t word_count = words[i] >> 16;
+        if (word_count == 0 || i + word_count > n_words)
+        {
+            THROW_ERROR("invalid SPIR-V code: truncated instruction")
+        }
+        const uint32_t* operands = &words[i + 1];
+        size_t n = word_count - 1;
+        switch (opcode)
+        {
+            case OpEntryPoint:
+            {
+                if (n < 3)
+                {
+                    break;
+                }
+                static const std::map<uint32_t, VkShaderStageFlagBits> stages = {
+                    {0, VK_SHADER_STAGE_VERTEX_BIT}, {1, VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT}, {2, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT},
+                    {3, VK_SHADER_STAGE_GEOMETRY_BIT}, {4, VK_SHADER_STAGE_FRAGMENT_BIT}, {5, VK_SHADER_STAGE_COMPUTE_BIT},
+                    {5267, VK_SHADER_STAGE_TASK_BIT_NV}, {5268, VK_SHADER_STAGE_MESH_BIT_NV},
+                    {5313, VK_SHADER_STAGE_RAYGEN_BIT_KHR}, {5314, VK_SHADER_STAGE_INTERSECTION_BIT_KHR}, {5315, VK_SHADER_STAGE_ANY_HIT_BIT_KHR},
+                    {5316, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR}, {5317, VK_SHADER_STAGE_MISS_BIT_KHR}, {5318, VK_SHADER_STAGE_CALLABLE_BIT_KHR}};
+                std::map<uint32_t, VkShaderStageFlagBits>::const_iterator stage = stages.find(operands[0]);
+                if (stage == stages.end())
+                {
+                    THROW_ERROR("unsupported SPIR-V execution model " + std::to_string(operands[0]))
+                }
+                entry_points.push_back({literal_string(operands + 2, n - 2), stage->second});
+                break;
+            }
+            case OpName:
+                if (n >= 2)
+                {
+                    id(operands[0]).name = literal_string(operands + 1, n - 1);
+                }
+                break;
+            case OpDecorate:
+                if (n >= 2)
+                {
+                    id(operands[0]).decorations[operands[1]] = (n > 2) ? operands[2] : 1;
+                }
+                break;
+            case OpMemberDecorate:
+                if (n >= 3)
+                {
+                    id(operands[0]).member_decorations[operands[1]][operands[2]] = (n > 3) ? operands[3] : 1;
+                }
+                break;
+            case OpTypeVoid: case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix: case OpTypeImage:
+            case OpTypeSampler: case OpTypeSampledImage: case OpTypeArray: case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer:
+            case OpTypeAccelerationStructureKHR:
+                if (n >= 1)
+                {
+                    Id& type = id(operands[0]);
+                    type.opcode = opcode;
+                    type.operands.assign(operands + 1, operands + n);
+                }
+                break;
+            case OpConstant: case OpSpecConstantTrue: case OpSpecConstantFalse: case OpSpecConstant: case OpVariable:
+                if (n >= 2)
+                {
+                    Id& result = id(operands[1]);
+                    result.opcode = opcode;
+                    result.type = operands[0];
+                    result.operands.assign(operands + 2, operands + n);
+                    if (opcode == OpVariable)
+                    {
+                        variables.push_back(operands[1]);
+                    }
+                    else if (opcode != OpConstant)
+                    {
+                        specialization_ids.push_back(operands[1]);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        i += word_count;
+    }
+    VkShaderStageFlags module_stages = stages();
+    for (uint32_t variable_id : variables)
+    {
+        const Id& variable = ids[variable_id];
+        const Id& pointer = id(variable.type);
+        if (pointer.opcode != OpTypePointer || pointer.operands.size() < 2 || variable.operands.empty())
+        {
+            continue;
+        }
+        uint32_t storage_class = variable.operands[0];
+        uint32_t type = pointer.operands[1];
+        if (storage_class == StorageClassUniformConstant || storage_class == StorageClassUniform || storage_class == StorageClassStorageBuffer)
+        {
+            VkDescriptorType descriptor_type;
+            uint32_t count;
+            if (variable.decorations.count(DecorationDescriptorSet) == 0 || variable.decorations.count(DecorationBinding) == 0 ||
+                !_descriptor_type(ids, type, storage_class, descriptor_type, count))
+            {
+                continue;
+            }
+            // Blocks are often anonymous in GLSL, in which case the name of the block type is more telling
+            std::string name = variable.name.empty() ? id(type).name : variable.name;
+            bindings.push_back({variable.decorations.at(DecorationDescriptorSet), variable.decorations.at(DecorationBinding), descriptor_type, count, module_stages, name});
+        }
+        else if (storage_class == StorageClassPushConstant)
+        {
+            const Id& block = id(type);
+            uint32_t offset = UINT32_MAX;
+            for (const std::pair<const uint32_t, std::map<uint32_t, uint32_t>>& member : block.member_decorations)
+            {
+                if (member.second.count(DecorationOffset) > 0)
+                {
+                    offset = std::min(offset, member.second.at(DecorationOffset));
+                }
+            }
+            offset = (offset == UINT32_MAX) ? 0 : offset;
+            push_constants.push_back({module_stages, offset, _type_size(ids, type) - offset});
+        }
+        else if (storage_class == StorageClassInput && (module_stages & VK_SHADER_STAGE_VERTEX_BIT) && variable.decorations.count(DecorationLocation) > 0 &&
+                 variable.decorations.count(DecorationBuiltIn) == 0)
+        {
+            // A matrix input takes a location per column
+            uint32_t location = variable.decorations.at(DecorationLocation);
+            const Id& input_type = id(type);
+            uint32_t n_columns = (input_type.opcode == OpTypeMatrix) ? input_type.operands.at(1) : 1;
+            uint32_t column_type = (input_type.opcode == OpTypeMatrix) ? input_type.operands.at(0) : type;
+            for (uint32_t c=0; c<n_columns; c++)
+            {
+                vertex_inputs.push_back({location + c, _vertex_format(ids, column_type), variable.name});
+            }
+        }
+    }
+    for (uint32_t constant_id : specialization_ids)
+    {
+        const Id& constant = ids[constant_id];
+        if (constant.decorations.count(DecorationSpecId) == 0)
+        {
+            continue;
+        }
+        uint64_t value = (constant.opcode == OpSpecConstantTrue) ? 1 : 0;
+        if (constant.opcode == OpSpecConstant && !constant.operands.empty())
+        {
+            value = constant.operands[0];
+            if (constant.operands.size() > 1)
+            {
+                value |= static_cast<uint64_t>(constant.operands[1]) << 32;
+            }
+        }
+        specialization_constants.push_back({constant.decorations.at(DecorationSpecId), _type_size(ids, constant.type), value, constant.name});
+    }
+    std::sort(bindings.begin(), bindings.end(), [](const Binding& a, const Binding& b) {return (a.set != b.set) ? a.set < b.set : a.binding < b.binding;});
+    std::sort(vertex_inputs.begin(), vertex_inputs.end(), [](const VertexInput& a, const VertexInput& b) {return a.location < b.location;});
+    std::sort(specialization_constants.begin(), specialization_constants.end(), [](const SpecializationConstant& a, const SpecializationConstant& b) {return a.id < b.id;});
+}
+
+uint32_t ShaderReflection::_type_size(const std::vector<Id>& ids, uint32_t type_id) const
+{
+    if (type_id >= ids.size())
+    {
+        THROW_ERROR("invalid SPIR-V code: id out of bounds")
+    }
+    const Id& type = ids[type_id];
+    switch (type.opcode)
+    {
+        case OpTypeBool:
+            return 4;
+        case OpTypeInt:
+        case OpTypeFloat:
+            return type.operands.at(0) / 8;
+        case OpTypeVector:
+            return type.operands.at(1) * _type_size(ids, type.operands.at(0));
+        case OpTypeMatrix:
+            return type.operands.at(1) * _type_size(ids, type.operands.at(0));
+        case OpTypeArray:
+        {
+            const Id& length = ids.at(type.operands.at(1));
+            uint32_t n = length.operands.empty() ? 0 : length.operands[0];
+            std::map<uint32_t, uint32_t>::const_iterator stride = type.decorations.find(DecorationArrayStride);
+            return n * ((stride != type.decorations.end()) ? stride->second : _type_size(ids, type.operands.at(0)));
+        }
+        case OpTypeStruct:
+        {
+            // The explicit layout of the members gives the size, up to the end of the last member
+            uint32_t size = 0;
+            for (size_t m=0; m<type.operands.size(); m++)
+            {
+                std::map<uint32_t, std::map<uint32_t, uint32_t>>::const_iterator decorations = type.member_decorations.find(m);
+                uint32_t offset = size;
+                uint32_t member_size = _type_size(ids, type.operands[m]);
+                if (decorations != type.member_decorations.end())
+                {
+                    if (decorations->second.count(DecorationOffset) > 0)
+                    {
+                        offset = decorations->second.at(DecorationOffset);
+                    }
+                    const Id& member = ids.at(type.operands[m]);
+                    if (member.opcode == OpTypeMatrix && decorations->second.count(DecorationMatrixStride) > 0)
+                    {
+                        member_size = member.operands.at(1) * decorations->second.at(DecorationMatrixStride);
+                    }
+                }
+                size = std::max(size, offset + member_size);
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+VkFormat ShaderReflection::_vertex_format(const std::vector<Id>& ids, uint32_t type_id) const
+{
+    const Id& type = ids.at(type_id);
+    uint32_t n_components = 1;
+    const Id* component = &type;
+    if (type.opcode == OpTypeVector)
+    {
+        n_components = type.operands.at(1);
+        component = &ids.at(type.operands.at(0));
+    }
+    if (n_components < 1 || n_components > 4 || component->operands.empty())
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+    uint32_t width = component->operands[0];
+    static const VkFormat float32[4] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static const VkFormat float64[4] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+    static const VkFormat int32[4] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+    static const VkFormat uint32[4] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+    if (component->opcode == OpTypeFloat && width == 32)
+    {
+        return float32[n_components - 1];
+    }
+    else if (component->opcode == OpTypeFloat && width == 64)
+    {
+        return float64[n_components - 1];
+    }
+    else if (component->opcode == OpTypeInt && width == 32 && component->operands.size() > 1)
+    {
+        return component->operands[1] ? int32[n_components - 1] : uint32[n_components - 1];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+bool ShaderReflection::_descriptor_type(const std::vector<Id>& ids, uint32_t type_id, uint32_t storage_class, VkDescriptorType& descriptor_type, uint32_t& count) const
+{
+    count = 1;
+    const Id* type = &ids.at(type_id);
+    // Arrays of descriptors (possibly multidimensional, or unbounded)
+    while (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray)
+    {
+        if (type->opcode == OpTypeArray)
+        {
+            const Id& length = ids.at(type->operands.at(1));
+            count *= length.operands.empty() ? 1 : length.operands[0];
+        }
+        else
+        {
+            count = 0;
+        }
+        type = &ids.at(type->operands.at(0));
+    }
+    switch (type->opcode)
+    {
+        case OpTypeStruct:
+            descriptor_type = (storage_class == StorageClassStorageBuffer || type->decorations.count(DecorationBufferBlock) > 0) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            return true;
+        case OpTypeSampler:
+            descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            return true;
+        case OpTypeSampledImage:
+        {
+            const Id& image = ids.at(type->operands.at(0));
+            descriptor_type = (image.operands.at(1) == 5) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            return true;
+        }
+        case OpTypeImage:
+        {
+            // operands: sampled type, dim, depth, arrayed, multisampled, sampled (1: with a sampler, 2: storage), format
+            uint32_t dim = type->operands.at(1);
+            bool storage = (type->operands.at(5) == 2);
+            if (dim == 6)
+            {
+                descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            else if (dim == 5)
+            {
+                descriptor_type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            else
+            {
+                descriptor_type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            return true;
+        }
+        case OpTypeAccelerationStructureKHR:
+            descriptor_type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,87 @@
+#include <GameEngine/graphics/ShaderVariant.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+using namespace GameEngine;
+
+ShaderVariant::ShaderVariant(const Shader& _shader) : shader(_shader)
+{
+}
+
+ShaderVariant::~ShaderVariant()
+{
+}
+
+ShaderVariant& ShaderVariant::set(uint32_t id, bool value)
+{
+    VkBool32 boolean = value ? VK_TRUE : VK_FALSE;
+    _set(id, &boolean, sizeof(boolean));
+    return *this;
+}
+
+ShaderStage ShaderVariant::stage(size_t entry_point) const
+{
+    if (entry_point >= shader.reflection.entry_points.size())
+    {
+        THROW_ERROR("The shader has no entry point " + std::to_string(entry_point))
+    }
+    ShaderStage stage;
+    stage.stage = shader.reflection.entry_points[entry_point].stage;
+    stage.module = shader._vk_shader;
+    stage.entry_point = shader.reflection.entry_points[entry_point].name;
+    for (const std::pair<const uint32_t, std::vector<unsigned char>>& value : _values)
+    {
+        VkSpecializationMapEntry entry;
+        entry.constantID = value.first;
+        entry.offset = stage.specialization_data.size();
+        entry.size = value.second.size();
+        stage.specialization_entries.push_back(entry);
+        stage.specialization_data.insert(stage.specialization_data.end(), value.second.begin(), value.second.end());
+    }
+    return stage;
+}
+
+uint64_t ShaderVariant::hash() const
+{
+    uint64_t hash = Utilities::hash(nullptr, 0);
+    for (const std::pair<const uint32_t, std::vector<unsigned char>>& value : _values)
+    {
+        hash = Utilities::hash(&value.first, sizeof(value.first), hash);
+        hash = Utilities::hash(value.second.data(), value.second.size(), hash);
+    }
+    return hash;
+}
+
+bool ShaderVariant::operator==(const ShaderVariant& other) const
+{
+    return &shader == &other.shader && _values == other._values;
+}
+
+void ShaderVariant::_set(uint32_t id, const void* value, size_t size)
+{
+    for (const ShaderReflection::SpecializationConstant& constant : shader.reflection.specialization_constants)
+    {
+        if (constant.id != id)
+        {
+            continue;
+        }
+        if (constant.size != size)
+        {
+            THROW_ERROR("The specialization constant " + std::to_string(id) + " has a size of " + std::to_string(constant.size) + " bytes, not " + std::to_string(size))
+        }
+        const unsigned char* bytes = static_cast<const unsigned char*>(value);
+        _values[id].assign(bytes, bytes + size);
+        return;
+    }
+    THROW_ERROR("The shader has no specialization constant " + std::to_string(id))
+}
+
+uint32_t ShaderVariant::_id(const std::string& name) const
+{
+    for (const ShaderReflection::SpecializationConstant& constant : shader.reflection.specialization_constants)
+    {
+        if (constant.name == name)
+        {
+            return constant.id;
+        }
+    }
+    THROW_ERROR("The shader has no specialization constant named '" + name + "'")
+}
@@ -1,18 +1,250 @@
 #include <GameEngine/graphics/SwapChain.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
 #include <GameEngine/graphics/GPU.hpp>
+#include <GameEngine/graphics/ObjectCache.hpp>
 #include <GameEngine/user_interface/Window.hpp>
 using namespace GameEngine;
 
-SwapChain::SwapChain(const GPU& _gpu, const Window& window) : gpu(_gpu)
+SwapChain::SwapChain(const GPU& _gpu, const Window& window) : gpu(_gpu), dynamic_resolution(_gpu, max_frames_in_flight),
+    command_pools(_gpu, _gpu._graphics_family.value_or(0), max_frames_in_flight), frame_allocators(max_frames_in_flight),
+    dynamic_buffer(_gpu, 4*1024*1024, max_frames_in_flight), descriptor_sets(_gpu, max_frames_in_flight)
 {
     if (!gpu._graphics_queue.has_value() || !gpu._present_queue.has_value())
     {
         THROW_ERROR("The provided GPU does not supports presenting to windows")
     }
+    if (gpu._bindless_enabled)
+    {
+        bindless.reset(new BindlessResources(gpu, max_frames_in_flight));
+    }
+    if (gpu._compute_queue.has_value() && gpu._compute_queue != gpu._graphics_queue)
+    {
+        compute_command_pools.reset(new CommandPools(gpu, gpu._compute_family.value(), max_frames_in_flight));
+    }
+    // A minimized window has no surface to create the swap chain for yet: it is created by the first frame once the window is restored
+    if (_surface_has_area(window))
+    {
+        _create_swap_chain(window, VK_NULL_HANDLE);
+        _create_frames(window.low_latency() ? 1 : max_frames_in_flight);
+    }
+    else
+    {
+        _needs_recreation = true;
+    }
+    // Get the function to wait for an image to be displayed, if supported
+    if (gpu._present_wait_enabled)
+    {
+        _vk_wait_for_present = (PFN_vkWaitForPresentKHR) vkGetDeviceProcAddr(gpu._logical_device, "vkWaitForPresentKHR");
+    }
+    gpu._object_cache->_n_swap_chains++;
+}
+
+SwapChain::~SwapChain()
+{
+    {
+        std::lock_guard<std::mutex> queue_lock(*gpu._queue_mutex);
+        vkDeviceWaitIdle(gpu._logical_device);
+    }
+    gpu._object_cache->_n_swap_chains--;
+    _destroy_frames();
+    vkDestroySwapchainKHR(gpu._logical_device, _swap_chain, HostAllocator::callbacks());
+}
+
+void SwapChain::_recreate(const Window& window)
+{
+    // A swap chain can't have an empty extent: the recreation is postponed until the window is restored
+    if (!_surface_has_area(window))
+    {
+        _needs_recreation = true;
+        return;
+    }
+    _needs_recreation = false;
+    {
+        std::lock_guard<std::mutex> queue_lock(*gpu._queue_mutex);
+        vkDeviceWaitIdle(gpu._logical_device);
+    }
+    // the semaphores might be left signaled by an aborted frame, so they are recreated too
+    _destroy_frames();
+    _image_index.reset();
+    VkSwapchainKHR old_swap_chain = _swap_chain;
+    _create_swap_chain(window, old_swap_chain);
+    vkDestroySwapchainKHR(gpu._logical_device, old_swap_chain, HostAllocator::callbacks());
+    _create_frames(window.low_latency() ? 1 : max_frames_in_flight);
+    _present_id = 0;
+    window._get_state()->_window_resized = false;
+}
+
+void SwapChain::_begin_frame(const Window& window)
+{
+    // Nothing can be presented while the window is minimized
+    if (window._get_state()->_window_width == 0 || window._get_state()->_window_height == 0)
+    {
+        return;
+    }
+    if (_needs_recreation)
+    {
+        _recreate(window);
+        if (_needs_recreation)
+        {
+            return;
+        }
+    }
+    // In low latency mode, wait for the previous image to be on screen, so that the next frame starts as late as possible
+    if (window.low_latency() && _vk_wait_for_present != nullptr && _present_id > 0)
+    {
+        const uint64_t timeout = 100000000; // in nanoseconds
+        if (_vk_wait_for_present(gpu._logical_device, _swap_chain, _present_id, timeout) == VK_SUCCESS && _presented_input_time >= 0.)
+        {
+            _record_latency(window, _presented_input_time);
+        }
+        _presented_input_time = -1.;
+    }
+    Frame& frame = _frames[_current_frame];
+    // Wait for the GPU to be done with the frame that used these resources
+    vkWaitForFences(gpu._logical_device, 1, &frame.in_flight, VK_TRUE, UINT64_MAX);
+    command_pools._reset(_current_frame);
+    if (compute_command_pools != nullptr)
+    {
+        compute_command_pools->_reset(_current_frame);
+    }
+    frame.compute_command_buffer = VK_NULL_HANDLE;
+    frame_allocators._reset(_current_frame);
+    dynamic_buffer._begin_frame(_current_frame);
+    descriptor_sets._reset(_current_frame);
+    if (bindless != nullptr)
+    {
+        bindless->_begin_frame(_current_frame);
+    }
+    gpu._object_cache->_begin_frame(max_frames_in_flight);
+    uint32_t image_index;
+    VkResult result = vkAcquireNextImageKHR(gpu._logical_device, _swap_chain, UINT64_MAX, frame.image_available, VK_NULL_HANDLE, &image_index);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        _recreate(window);
+        return;
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+        THROW_ERROR("failed to acquire the swap chain image")
+    }
+    _image_index = image_index;
+}
+
+void SwapChain::_end_frame(const Window& window)
+{
+    if (!_image_index.has_value())
+    {
+        return;
+    }
+    uint32_t image_index = _image_index.value();
+    _image_index.reset();
+    Frame& frame = _frames[_current_frame];
+    vkResetFences(gpu._logical_device, 1, &frame.in_flight);
+    // Record and submit the rendering commands
+    frame.command_buffer = command_pools._allocate(_current_frame, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    _record_commands(frame.command_buffer, _current_frame, _vk_images[image_index]);
+    dynamic_buffer._flush();
+    // The async compute work runs concurrently with the beginning of the frame, and the draws wait for it from the indirect command reads
+    bool async_compute = (frame.compute_command_buffer != VK_NULL_HANDLE);
+    if (async_compute && vkEndCommandBuffer(frame.compute_command_buffer) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to record the async compute command buffer")
+    }
+    VkSemaphore wait_semaphores[2] = {frame.image_available, frame.compute_finished};
+    VkPipelineStageFlags wait_stages[2] = {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT};
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = async_compute ? 2 : 1;
+    submit_info.pWaitSemaphores = wait_semaphores;
+    submit_info.pWaitDstStageMask = wait_stages;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &frame.command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &frame.render_finished;
+    std::unique_lock<std::mutex> queue_lock(*gpu._queue_mutex);
+    if (async_compute)
+    {
+        VkSubmitInfo compute_info{};
+        compute_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        compute_info.commandBufferCount = 1;
+        compute_info.pCommandBuffers = &frame.compute_command_buffer;
+        compute_info.signalSemaphoreCount = 1;
+        compute_info.pSignalSemaphores = &frame.compute_finished;
+        if (vkQueueSubmit(gpu._compute_queue.value(), 1, &compute_info, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to submit the async compute command buffer")
+        }
+    }
+    if (vkQueueSubmit(gpu._graphics_queue.value(), 1, &submit_info, frame.in_flight) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to submit the draw command buffer")
+    }
+    // Present the image, with an id to be able to wait for it to be displayed
+    VkPresentIdKHR present_id{};
+    present_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    present_id.swapchainCount = 1;
+    uint64_t id = _present_id + 1;
+    present_id.pPresentIds = &id;
+    VkPresentInfoKHR present_info{};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.pNext = gpu._present_wait_enabled ? &present_id : nullptr;
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &frame.render_finished;
+    present_info.swapchainCount = 1;
+    present_info.pSwapchains = &_swap_chain;
+    present_info.pImageIndices = &image_index;
+    VkResult result = vkQueuePresentKHR(gpu._present_queue.value(), &present_info);
+    queue_lock.unlock();
+    _present_id = id;
+    _current_frame = (_current_frame + 1) % _frames.size();
+    // The latency is measured up to the display of the image if it can be waited for, otherwise up to the present call
+    double input_time = window._get_state()->_input_time;
+    if (window.low_latency() && _vk_wait_for_present != nullptr)
+    {
+        _presented_input_time = input_time;
+    }
+    else if (input_time >= 0.)
+    {
+        _record_latency(window, input_time);
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window._get_state()->_window_resized)
+    {
+        _recreate(window);
+    }
+    else if (result != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to present the swap chain image")
+    }
+}
+
+VkCommandBuffer SwapChain::async_compute_commands()
+{
+    if (compute_command_pools == nullptr || !_image_index.has_value())
+    {
+        return VK_NULL_HANDLE;
+    }
+    Frame& frame = _frames[_current_frame];
+    if (frame.compute_command_buffer == VK_NULL_HANDLE)
+    {
+        frame.compute_command_buffer = compute_command_pools->_allocate(_current_frame, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(frame.compute_command_buffer, &begin_info) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to begin recording the async compute command buffer")
+        }
+    }
+    return frame.compute_command_buffer;
+}
+
+void SwapChain::_create_swap_chain(const Window& window, VkSwapchainKHR old_swap_chain)
+{
     const VkSurfaceKHR& surface = window._get_vk_surface();
     VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> present_modes;
+    LinearAllocator& allocator = frame_allocators.get(_current_frame);
+    ArenaVector<VkSurfaceFormatKHR> formats(allocator);
+    ArenaVector<VkPresentModeKHR> present_modes(allocator);
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(gpu._physical_device, surface, &capabilities);
     uint32_t formatCount;
     vkGetPhysicalDeviceSurfaceFormatsKHR(gpu._physical_device, surface, &formatCount, nullptr);
@@ -28,10 +260,15 @@ SwapChain::SwapChain(const GPU& _gpu, const Window& window) : gpu(_gpu)
         present_modes.resize(presentModeCount);
         vkGetPhysicalDeviceSurfacePresentModesKHR(gpu._physical_device, surface, &presentModeCount, present_modes.data());
     }
+    if (!(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+    {
+        THROW_ERROR("The window surface does not support being written to by transfer operations")
+    }
     VkSurfaceFormatKHR surfaceFormat = _choose_swap_surface_format(formats);
-    VkPresentModeKHR presentMode = _choose_swap_present_mode(present_modes);
+    VkPresentModeKHR presentMode = _choose_swap_present_mode(present_modes, window.vsync());
     VkExtent2D extent = _choose_swap_extent(capabilities, window);
-    uint32_t imageCount = capabilities.minImageCount + 1;
+    // An additional image avoids waiting on the presentation engine, but queues one more frame before display
+    uint32_t imageCount = window.low_latency() ? capabilities.minImageCount : capabilities.minImageCount + 1;
     if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
     {
         imageCount = capabilities.maxImageCount;
@@ -44,13 +281,13 @@ SwapChain::SwapChain(const GPU& _gpu, const Window& window) : gpu(_gpu)
     swap_chain_infos.imageColorSpace = surfaceFormat.colorSpace;
     swap_chain_infos.imageExtent = extent;
     swap_chain_infos.imageArrayLayers = 1;
-    swap_chain_infos.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swap_chain_infos.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    uint32_t family_indices[2] = {gpu._graphics_family.value(), gpu._present_family.value()};
     if (gpu._graphics_queue != gpu._present_queue)
     {
-        std::vector<uint32_t> family_indices = {gpu._graphics_family.value(), gpu._present_family.value()};
         swap_chain_infos.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
         swap_chain_infos.queueFamilyIndexCount = 2;
-        swap_chain_infos.pQueueFamilyIndices = family_indices.data();
+        swap_chain_infos.pQueueFamilyIndices = family_indices;
     }
     else
     {
@@ -60,24 +297,110 @@ SwapChain::SwapChain(const GPU& _gpu, const Window& window) : gpu(_gpu)
     swap_chain_infos.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;//VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR;
     swap_chain_infos.presentMode = presentMode;
     swap_chain_infos.clipped = VK_TRUE;
-    swap_chain_infos.oldSwapchain = VK_NULL_HANDLE;
-    if (vkCreateSwapchainKHR(gpu._logical_device, &swap_chain_infos, nullptr, &_swap_chain) != VK_SUCCESS)
+    swap_chain_infos.oldSwapchain = old_swap_chain;
+    if (vkCreateSwapchainKHR(gpu._logical_device, &swap_chain_infos, HostAllocator::callbacks(), &_swap_chain) != VK_SUCCESS)
     {
         THROW_ERROR("failed to create the swap chain")
     }
     // Getting the vkImages
-    vkGetSwapchainImagesKHR(*gpu._logical_device, _swap_chain, &imageCount, nullptr);
+    vkGetSwapchainImagesKHR(gpu._logical_device, _swap_chain, &imageCount, nullptr);
     _vk_images.resize(imageCount);
-    vkGetSwapchainImagesKHR(*gpu._logical_device, _swap_chain, &imageCount, _vk_images.data());
+    vkGetSwapchainImagesKHR(gpu._logical_device, _swap_chain, &imageCount, _vk_images.data());
     _image_format = surfaceFormat.format;
+    _extent = extent;
+    _present_mode = presentMode;
+    _can_upscale = dynamic_resolution._supported(_image_format);
 }
 
-SwapChain::~SwapChain()
+void SwapChain::_create_frames(unsigned int n_frames)
+{
+    _frames.resize(n_frames);
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT; // so that the first wait on each frame returns immediately
+    for (unsigned int i=0; i<n_frames; i++)
+    {
+        Frame& frame = _frames[i];
+        if (vkCreateSemaphore(gpu._logical_device, &semaphore_info, HostAllocator::callbacks(), &frame.image_available) != VK_SUCCESS ||
+            vkCreateSemaphore(gpu._logical_device, &semaphore_info, HostAllocator::callbacks(), &frame.render_finished) != VK_SUCCESS ||
+            vkCreateSemaphore(gpu._logical_device, &semaphore_info, HostAllocator::callbacks(), &frame.compute_finished) != VK_SUCCESS ||
+            vkCreateFence(gpu._logical_device, &fence_info, HostAllocator::callbacks(), &frame.in_flight) != VK_SUCCESS)
+        {
+            THROW_ERROR("failed to create the synchronization objects of a frame")
+        }
+    }
+    _current_frame = 0;
+}
+
+void SwapChain::_destroy_frames()
+{
+    for (Frame& frame : _frames)
+    {
+        vkDestroySemaphore(gpu._logical_device, frame.image_available, HostAllocator::callbacks());
+        vkDestroySemaphore(gpu._logical_device, frame.render_finished, HostAllocator::callbacks());
+        vkDestroySemaphore(gpu._logical_device, frame.compute_finished, HostAllocator::callbacks());
+        vkDestroyFence(gpu._logical_device, frame.in_flight, HostAllocator::callbacks());
+    }
+    _frames.clear();
+}
+
+void SwapChain::_record_commands(VkCommandBuffer command_buffer, unsigned int frame_index, VkImage image)
+{
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to begin recording the command buffer")
+    }
+    if (dynamic_resolution.enabled && _can_upscale)
+    {
+        // Render the scene at a reduced resolution and upscale it to the swap chain image
+        dynamic_resolution._begin(command_buffer, frame_index, _extent, _image_format);
+        _record_scene(command_buffer, dynamic_resolution._render_target->_vk_image, dynamic_resolution._render_extent);
+        dynamic_resolution._end(command_buffer, frame_index);
+        Image::_layout_transition(command_buffer, image,
+                                  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        dynamic_resolution._upscale(command_buffer, image, _extent);
+    }
+    else
+    {
+        _record_scene(command_buffer, image, _extent);
+    }
+    // Transition the image to the layout expected by the presentation engine
+    Image::_layout_transition(command_buffer, image,
+                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        THROW_ERROR("failed to record the command buffer")
+    }
+}
+
+void SwapChain::_record_scene(VkCommandBuffer command_buffer, VkImage image, VkExtent2D extent)
 {
-    vkDestroySwapchainKHR(gpu._logical_device, _swap_chain, nullptr);
+    (void)extent;//The scene is only a clear color for now, which doesn't depend on the rendered region
+    // The previous content of the image is discarded
+    Image::_layout_transition(command_buffer, image,
+                              VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    VkImageSubresourceRange range{};
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+    VkClearColorValue clear_color = {{0.f, 0.f, 0.f, 1.f}};
+    vkCmdClearColorImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_color, 1, &range);
 }
 
-VkSurfaceFormatKHR SwapChain::_choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats)
+VkSurfaceFormatKHR SwapChain::_choose_swap_surface_format(const ArenaVector<VkSurfaceFormatKHR>& available_formats)
 {
     for (const auto& availableFormat : available_formats)
     {
@@ -88,18 +411,35 @@ VkSurfaceFormatKHR SwapChain::_choose_swap_surface_format(const std::vector<VkSu
     return available_formats[0];
 }
 
-VkPresentModeKHR SwapChain::_choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes)
+VkPresentModeKHR SwapChain::_choose_swap_present_mode(const ArenaVector<VkPresentModeKHR>& available_present_modes, bool vsync)
 {
-    for (const auto& availablePresentMode : available_present_modes)
+    // FIFO waits for the vertical blank, and is the only mode guaranteed to be available
+    if (vsync)
     {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+    // Without vsync, MAILBOX is preferred as it does not tear, otherwise IMMEDIATE is used
+    for (VkPresentModeKHR preferred_mode : {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR})
+    {
+        for (const auto& availablePresentMode : available_present_modes)
         {
-            return availablePresentMode;
+            if (availablePresentMode == preferred_mode)
+            {
+                return availablePresentMode;
+            }
         }
     }
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+bool SwapChain::_surface_has_area(const Window& window)
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(gpu._physical_device, window._get_vk_surface(), &capabilities);
+    VkExtent2D extent = _choose_swap_extent(capabilities, window);
+    return extent.width > 0 && extent.height > 0;
+}
+
 VkExtent2D SwapChain::_choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, const Window& window)
 {
     if (capabilities.currentExtent.width != UINT32_MAX)
@@ -119,3 +459,18 @@ VkExtent2D SwapChain::_choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabi
         return actualExtent;
     }
 }
+
+void SwapChain::_record_latency(const Window& window, double input_time)
+{
+    Handles& state = *window._get_state();
+    double latency = state._frame_timer.t() - input_time;
+    if (state._input_latency < 0.)
+    {
+        state._input_latency = latency;
+    }
+    else
+    {
+        const double alpha = 0.1;
+        state._input_latency += alpha * (latency - state._input_latency);
+    }
+}
@@ -0,0 +1,538 @@
+#include <GameEngine/multithreading/AsyncIO.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+using namespace GameEngine;
+
+AsyncFile::AsyncFile(const std::string& file_path, bool direct) : _path(file_path)
+{
+    #ifdef _WIN32
+    _handle = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, direct ? FILE_FLAG_NO_BUFFERING : 0, nullptr);
+    if (_handle == INVALID_HANDLE_VALUE)
+    {
+        _handle = nullptr;
+        THROW_ERROR("failed to open file '" + file_path + "' (error " + std::to_string(GetLastError()) + ")")
+    }
+    _direct = direct;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_handle, &size))
+    {
+        unsigned long error = GetLastError();
+        CloseHandle(_handle);
+        _handle = nullptr;
+        THROW_ERROR("failed to get the size of file '" + file_path + "' (error " + std::to_string(error) + ")")
+    }
+    _size = static_cast<uint64_t>(size.QuadPart);
+    #else
+    #ifdef O_DIRECT
+    if (direct)
+    {
+        _fd = open(file_path.c_str(), O_RDONLY | O_DIRECT);
+        _direct = (_fd >= 0);
+    }
+    #endif
+    // Some file systems (tmpfs for example) don't support direct I/O: the reads go through the page cache then
+    if (_fd < 0)
+    {
+        _fd = open(file_path.c_str(), O_RDONLY);
+    }
+    if (_fd < 0)
+    {
+        THROW_ERROR("failed to open file '" + file_path + "': " + std::string(strerror(errno)))
+    }
+    struct stat status;
+    if (fstat(_fd, &status) != 0)
+    {
+        int error = errno;
+        close(_fd);
+        _fd = -1;
+        THROW_ERROR("failed to get the size of file '" + file_path + "': " + std::string(strerror(error)))
+    }
+    _size = static_cast<uint64_t>(status.st_size);
+    #endif
+}
+
+AsyncFile::~AsyncFile()
+{
+    #ifdef _WIN32
+    if (_handle != nullptr)
+    {
+        CloseHandle(_handle);
+    }
+    #else
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+    #endif
+}
+
+uint64_t AsyncFile::size() const
+{
+    return _size;
+}
+
+bool AsyncFile::direct() const
+{
+    return _direct;
+}
+
+const std::string& AsyncFile::path() const
+{
+    return _path;
+}
+
+int64_t AsyncRead::wait()
+{
+    AsyncIO::flush();
+    JobSystem::wait(counter);
+    return result;
+}
+
+bool AsyncRead::done() const
+{
+    return counter.done();
+}
+
+std::mutex AsyncIO::_initialization_mutex;
+std::atomic<bool> AsyncIO::_initialized(false);
+std::atomic<bool> AsyncIO::_stopping(false);
+std::mutex AsyncIO::_queue_mutex;
+std::vector<AsyncRead*> AsyncIO::_queued;
+std::atomic<int> AsyncIO::_in_flight(0);
+std::vector<std::thread> AsyncIO::_threads;
+std::deque<AsyncRead*> AsyncIO::_pending;
+std::condition_variable AsyncIO::_pending_cv;
+#ifdef __linux__
+AsyncIO::Uring AsyncIO::_uring;
+std::thread AsyncIO::_completion_thread;
+#endif
+
+void AsyncIO::initialize(unsigned int queue_depth, unsigned int n_fallback_threads)
+{
+    // Called lazily by the first read, possibly from several threads at once
+    if (_initialized.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> initialization_lock(_initialization_mutex);
+    if (_initialized.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    _stopping = false;
+    // Completed reads run their callbacks as jobs, so the job system must outlive the I/O backend (atexit calls are in reverse order)
+    JobSystem::initialize();
+    #ifdef __linux__
+    bool uring = _setup_uring(queue_depth);
+    if (uring)
+    {
+        _completion_thread = std::thread(_completion_loop);
+    }
+    #else
+    bool uring = false;
+    #endif
+    for (unsigned int i=0; !uring && i<std::max(n_fallback_threads, 1u); i++)
+    {
+        _threads.emplace_back(_fallback_loop);
+    }
+    static bool terminate_registered = false;
+    if (!terminate_registered)
+    {
+        std::atexit(AsyncIO::terminate);
+        terminate_registered = true;
+    }
+    _initialized.store(true, std::memory_order_release);
+}
+
+void AsyncIO::terminate()
+{
+    std::lock_guard<std::mutex> initialization_lock(_initialization_mutex);
+    if (!_initialized)
+    {
+        return;
+    }
+    flush();
+    #ifdef __linux__
+    if (uses_io_uring())
+    {
+        // A no-op entry wakes up the completion thread, which stops once the reads in flight completed
+        {
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            _stopping = true;
+            unsigned int tail = *_uring.sq_tail;
+            unsigned int index = tail & *_uring.sq_mask;
+            io_uring_sqe* sqe = static_cast<io_uring_sqe*>(_uring.sqes) + index;
+            std::memset(sqe, 0, sizeof(io_uring_sqe));
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = 0;
+            _uring.sq_array[index] = index;
+            __atomic_store_n(_uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+            while (syscall(__NR_io_uring_enter, _uring.fd, 1, 0, 0, nullptr, 0) < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY))
+            {
+            }
+        }
+        _completion_thread.join();
+        _destroy_uring();
+        _initialized = false;
+        return;
+    }
+    #endif
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _stopping = true;
+        _pending_cv.notify_all();
+    }
+    for (std::thread& thread : _threads)
+    {
+        thread.join();
+    }
+    _threads.clear();
+    _initialized = false;
+}
+
+std::shared_ptr<AsyncRead> AsyncIO::read(const AsyncFile& file, uint64_t offset, size_t size, void* destination,
+                                         const std::function<void(AsyncRead&)>& callback, JobCounter* group)
+{
+    initialize();
+    if (file.direct() && (offset % AsyncFile::direct_alignment != 0 || size % AsyncFile::direct_alignment != 0 ||
+                          reinterpret_cast<uintptr_t>(destination) % AsyncFile::direct_alignment != 0))
+    {
+        THROW_ERROR("Direct reads of '" + file.path() + "' must have an offset, a size and a destination aligned to " + std::to_string(AsyncFile::direct_alignment) + " bytes")
+    }
+    std::shared_ptr<AsyncRead> read = std::make_shared<AsyncRead>();
+    read->_file = &file;
+    read->_offset = offset;
+    read->_size = size;
+    read->_destination = destination;
+    read->_callback = callback;
+    read->_group = group;
+    read->_self = read;
+    read->counter._increment();
+    if (group != nullptr)
+    {
+        group->_increment();
+    }
+    _in_flight.fetch_add(1);
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    _queued.push_back(read.get());
+    return read;
+}
+
+void AsyncIO::flush()
+{
+    if (!_initialized)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    if (_queued.empty())
+    {
+        return;
+    }
+    #ifdef __linux__
+    if (uses_io_uring())
+    {
+        _submit_uring();
+        return;
+    }
+    #endif
+    _pending.insert(_pending.end(), _queued.begin(), _queued.end());
+    _queued.clear();
+    _pending_cv.notify_all();
+}
+
+bool AsyncIO::uses_io_uring()
+{
+    #ifdef __linux__
+    return _uring.fd >= 0;
+    #else
+    return false;
+    #endif
+}
+
+size_t AsyncIO::aligned_size(size_t size)
+{
+    return (size + AsyncFile::direct_alignment - 1) / AsyncFile::direct_alignment * AsyncFile::direct_alignment;
+}
+
+#ifdef __linux__
+bool AsyncIO::_setup_uring(unsigned int queue_depth)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+    // io_uring might be missing (kernels older than 5.1) or forbidden (by seccomp in containers)
+    if (fd < 0)
+    {
+        return false;
+    }
+    // IORING_OP_READ exists since the kernel that introduced IORING_FEAT_RW_CUR_POS (5.6)
+    if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        close(fd);
+        return false;
+    }
+    Uring& ring = _uring;
+    ring.entries = params.sq_entries;
+    ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+    {
+        ring.sq_ring_size = std::max(ring.sq_ring_size, ring.cq_ring_size);
+        ring.cq_ring_size = ring.sq_ring_size;
+    }
+    ring.sq_ring = mmap(nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring.cq_ring = single_mmap ? ring.sq_ring : mmap(nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring.sqes = mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    ring.fd = fd;
+    if (ring.sq_ring == MAP_FAILED || ring.cq_ring == MAP_FAILED || ring.sqes == MAP_FAILED)
+    {
+        _destroy_uring();
+        return false;
+    }
+    char* sq = static_cast<char*>(ring.sq_ring);
+    ring.sq_head = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    ring.sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    ring.sq_mask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    ring.sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(ring.cq_ring);
+    ring.cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    ring.cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    ring.cq_mask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    ring.cqes = cq + params.cq_off.cqes;
+    return true;
+}
+
+void AsyncIO::_destroy_uring()
+{
+    Uring& ring = _uring;
+    if (ring.sqes != nullptr && ring.sqes != MAP_FAILED)
+    {
+        munmap(ring.sqes, ring.sqes_size);
+    }
+    if (ring.cq_ring != nullptr && ring.cq_ring != MAP_FAILED && ring.cq_ring != ring.sq_ring)
+    {
+        munmap(ring.cq_ring, ring.cq_ring_size);
+    }
+    if (ring.sq_ring != nullptr && ring.sq_ring != MAP_FAILED)
+    {
+        munmap(ring.sq_ring, ring.sq_ring_size);
+    }
+    if (ring.fd >= 0)
+    {
+        close(ring.fd);
+    }
+    ring = Uring();
+}
+
+void AsyncIO::_submit_uring()
+{
+    Uring& ring = _uring;
+    unsigned int head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    unsigned int tail = *ring.sq_tail;
+    size_t n = 0;
+    // Reads that don't fit in the submission queue stay queued, and are submitted by the completion thread as entries are consumed
+    for (; n < _queued.size() && tail - head < ring.entries; n++, tail++)
+    {
+        const AsyncRead& read = *_queued[n];
+        unsigned int index = tail & *ring.sq_mask;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(ring.sqes) + index;
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        // The rest of the read, in a request of at most MAX_RW_COUNT bytes (the kernel would shorten it, and 'len' is 32 bits)
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = read._file->_fd;
+        sqe->off = read._offset + read._done;
+        sqe->addr = reinterpret_cast<uint64_t>(static_cast<char*>(read._destination) + read._done);
+        sqe->len = static_cast<uint32_t>(std::min(read._size - read._done, _max_request_size));
+        sqe->user_data = reinterpret_cast<uint64_t>(_queued[n]);
+        ring.sq_array[index] = index;
+    }
+    if (n == 0)
+    {
+        return;
+    }
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+    _queued.erase(_queued.begin(), _queued.begin() + n);
+    while (syscall(__NR_io_uring_enter, ring.fd, n, 0, 0, nullptr, 0) < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            THROW_ERROR("io_uring submission failed: " + std::string(strerror(errno)))
+        }
+        std::this_thread::yield();
+    }
+}
+
+void AsyncIO::_completion_loop()
+{
+    Uring& ring = _uring;
+    while (true)
+    {
+        if (syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            THROW_ERROR("waiting for io_uring completions failed: " + std::string(strerror(errno)))
+        }
+        unsigned int head = *ring.cq_head;
+        unsigned int tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        std::vector<AsyncRead*> continued;
+        for (; head != tail; head++)
+        {
+            const io_uring_cqe& cqe = static_cast<const io_uring_cqe*>(ring.cqes)[head & *ring.cq_mask];
+            AsyncRead* read = reinterpret_cast<AsyncRead*>(cqe.user_data);
+            int64_t result = cqe.res;
+            // the entry can be reused by the kernel once the head moved past it
+            __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+            if (read == nullptr)
+            {
+                continue;
+            }
+            if (result == -EINTR || result == -EAGAIN)
+            {
+                continued.push_back(read);
+                continue;
+            }
+            if (result < 0)
+            {
+                _complete(read, result);
+                continue;
+            }
+            read->_done += result;
+            // A short read is continued, unless it reached the end of the file. Direct reads can't continue from an unaligned offset,
+            // which only happens at the end of the file.
+            bool end_of_file = (result == 0) || (read->_file->direct() && read->_done % AsyncFile::direct_alignment != 0);
+            if (read->_done < read->_size && !end_of_file)
+            {
+                continued.push_back(read);
+            }
+            else
+            {
+                _complete(read, read->_done);
+            }
+        }
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _queued.insert(_queued.begin(), continued.begin(), continued.end());
+        if (_stopping && _in_flight.load() == 0)
+        {
+            return;
+        }
+        _submit_uring();
+    }
+}
+#endif
+
+void AsyncIO::_fallback_loop()
+{
+    while (true)
+    {
+        AsyncRead* read;
+        {
+            std::unique_lock<std::mutex> lock(_queue_mutex);
+            _pending_cv.wait(lock, []() {return _stopping || !_pending.empty();});
+            // The pending reads are all done before stopping
+            if (_pending.empty())
+            {
+                return;
+            }
+            read = _pending.front();
+            _pending.pop_front();
+        }
+        _complete(read, _blocking_read(*read));
+    }
+}
+
+int64_t AsyncIO::_blocking_read(const AsyncRead& read)
+{
+    size_t done = 0;
+    char* destination = static_cast<char*>(read._destination);
+    // Loop over short reads, until the requested size or the end of the file
+    while (done < read._size)
+    {
+        #ifdef _WIN32
+        OVERLAPPED overlapped{};
+        uint64_t offset = read._offset + done;
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD n = 0;
+        if (!ReadFile(read._file->_handle, destination + done, static_cast<DWORD>(std::min(read._size - done, _max_request_size)), &n, &overlapped))
+        {
+            DWORD error = GetLastError();
+            if (error == ERROR_HANDLE_EOF)
+            {
+                break;
+            }
+            return -static_cast<int64_t>(error);
+        }
+        #else
+        ssize_t n = pread(read._file->_fd, destination + done, read._size - done, read._offset + done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -errno;
+        }
+        #endif
+        if (n == 0)
+        {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+void AsyncIO::_complete(AsyncRead* read, int64_t result)
+{
+    read->result = result;
+    // The read keeps itself alive until the counters were decremented, even if the caller dropped it
+    std::shared_ptr<AsyncRead> self = std::move(read->_self);
+    _in_flight.fetch_sub(1);
+    auto finish = [self]()
+    {
+        if (self->_callback)
+        {
+            self->_callback(*self);
+        }
+        JobCounter* group = self->_group;
+        JobSystem::decrement(self->counter);
+        if (group != nullptr)
+        {
+            JobSystem::decrement(*group);
+        }
+    };
+    // Callbacks run as jobs, so that slow callbacks (decompression, uploads) don't delay the next completions
+    if (self->_callback)
+    {
+        JobSystem::submit(finish);
+    }
+    else
+    {
+        finish();
+    }
+}
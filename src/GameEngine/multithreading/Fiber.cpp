@@ -0,0 +1,91 @@
+#include <GameEngine/multithreading/Fiber.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <cstdint>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+using namespace GameEngine;
+
+Fiber::Fiber()
+{
+    #ifdef _WIN32
+    if (IsThreadAFiber())
+    {
+        _handle = GetCurrentFiber();
+    }
+    else
+    {
+        _handle = ConvertThreadToFiber(nullptr);
+        _thread_converted = true;
+    }
+    if (_handle == nullptr)
+    {
+        THROW_ERROR("failed to convert the thread to a fiber")
+    }
+    #endif
+    // With ucontext the context is saved on the first switch from this fiber
+}
+
+Fiber::Fiber(const std::function<void()>& entry, size_t stack_size) : _entry(entry)
+{
+    #ifdef _WIN32
+    _handle = CreateFiber(stack_size, reinterpret_cast<LPFIBER_START_ROUTINE>(&Fiber::_start), this);
+    if (_handle == nullptr)
+    {
+        THROW_ERROR("failed to create a fiber")
+    }
+    #else
+    _stack.reset(new char[stack_size]);
+    if (getcontext(&_context) != 0)
+    {
+        THROW_ERROR("failed to get the thread context")
+    }
+    _context.uc_stack.ss_sp = _stack.get();
+    _context.uc_stack.ss_size = stack_size;
+    _context.uc_link = nullptr;
+    // makecontext only passes int arguments, so the pointer is split in two halves
+    uintptr_t address = reinterpret_cast<uintptr_t>(this);
+    makecontext(&_context, reinterpret_cast<void(*)()>(&Fiber::_start), 2, static_cast<unsigned int>(static_cast<uint64_t>(address) >> 32), static_cast<unsigned int>(address & 0xFFFFFFFFu));
+    #endif
+}
+
+Fiber::~Fiber()
+{
+    #ifdef _WIN32
+    if (_thread_converted)
+    {
+        ConvertFiberToThread();
+    }
+    else if (_entry && _handle != nullptr)
+    {
+        DeleteFiber(_handle);
+    }
+    #endif
+}
+
+void Fiber::_switch(Fiber& from, Fiber& to)
+{
+    #ifdef _WIN32
+    (void)from;
+    SwitchToFiber(to._handle);
+    #else
+    if (swapcontext(&from._context, &to._context) != 0)
+    {
+        THROW_ERROR("failed to switch fiber")
+    }
+    #endif
+}
+
+#ifdef _WIN32
+void __stdcall Fiber::_start(void* fiber)
+{
+    static_cast<Fiber*>(fiber)->_entry();
+}
+#else
+void Fiber::_start(unsigned int high, unsigned int low)
+{
+    uintptr_t address = static_cast<uintptr_t>((static_cast<uint64_t>(high) << 32) | static_cast<uint64_t>(low));
+    reinterpret_cast<Fiber*>(address)->_entry();
+}
+#endif
@@ -0,0 +1,59 @@
+#include <GameEngine/multithreading/JobCounter.hpp>
+#include <thread>
+using namespace GameEngine;
+
+JobCounter::JobCounter(int value) : _value(value), _updating(0)
+{
+}
+
+JobCounter::~JobCounter()
+{
+}
+
+bool JobCounter::done() const
+{
+    // The value must be read first: if it is zero the decrementing thread already registered itself as updating
+    return _value.load() == 0 && _updating.load() == 0;
+}
+
+int JobCounter::value() const
+{
+    return _value.load();
+}
+
+void JobCounter::_increment(int n)
+{
+    _value.fetch_add(n);
+}
+
+void JobCounter::_decrement(std::vector<Job*>& ready_jobs)
+{
+    _updating.fetch_add(1);
+    if (_value.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ready_jobs.insert(ready_jobs.end(), _waiting_jobs.begin(), _waiting_jobs.end());
+        _waiting_jobs.clear();
+    }
+    // last access to the counter, after which it may be destroyed by a waiting thread
+    _updating.fetch_sub(1);
+}
+
+bool JobCounter::_add_waiting_job(Job* job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // checked under the lock, so that the job can't be missed by a concurrent decrement to zero
+        if (_value.load() != 0)
+        {
+            _waiting_jobs.push_back(job);
+            return true;
+        }
+    }
+    // The dependent job might destroy the counter, so a decrement to zero still in progress must be finished first
+    while (_updating.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    return false;
+}
@@ -0,0 +1,521 @@
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+using namespace GameEngine;
+
+std::mutex JobSystem::_initialization_mutex;
+std::atomic<bool> JobSystem::_initialized(false);
+std::atomic<bool> JobSystem::_stopping(false);
+std::vector<std::thread> JobSystem::_workers;
+std::vector<std::unique_ptr<WorkStealingDeque<Job>>> JobSystem::_deques;
+std::mutex JobSystem::_injection_mutex;
+std::deque<Job*> JobSystem::_injected_jobs;
+std::atomic<int> JobSystem::_queued_jobs(0);
+std::atomic<int> JobSystem::_sleeping_workers(0);
+std::mutex JobSystem::_sleep_mutex;
+std::condition_variable JobSystem::_wake_up;
+std::mutex JobSystem::_fiber_mutex;
+std::vector<std::unique_ptr<Fiber>> JobSystem::_fibers;
+std::vector<Fiber*> JobSystem::_free_fibers;
+std::mutex JobSystem::_fence_mutex;
+std::vector<JobSystem::FenceWait> JobSystem::_fence_waits;
+std::atomic<int> JobSystem::_n_fence_waits(0);
+
+void JobSystem::initialize(unsigned int n_workers)
+{
+    // Called lazily by the first submit, possibly from several threads at once
+    if (_initialized.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> initialization_lock(_initialization_mutex);
+    if (_initialized.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    if (n_workers == 0)
+    {
+        unsigned int n_cores = std::thread::hardware_concurrency();
+        n_workers = (n_cores > 1) ? n_cores - 1 : 1;
+    }
+    _stopping = false;
+    // The calling thread gets the first deque
+    _deques.clear();
+    for (unsigned int i=0; i<n_workers+1; i++)
+    {
+        _deques.emplace_back(new WorkStealingDeque<Job>());
+    }
+    _thread_state().slot = 0;
+    // The deques must all exist before the workers start stealing
+    for (unsigned int i=1; i<n_workers+1; i++)
+    {
+        _workers.emplace_back(_worker_loop, i);
+    }
+    // Initializing again after a terminate doesn't register the handler twice
+    static bool terminate_registered = false;
+    if (!terminate_registered)
+    {
+        std::atexit(JobSystem::terminate);
+        terminate_registered = true;
+    }
+    _initialized.store(true, std::memory_order_release);
+}
+
+void JobSystem::terminate()
+{
+    std::lock_guard<std::mutex> initialization_lock(_initialization_mutex);
+    if (!_initialized)
+    {
+        return;
+    }
+    _stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _wake_up.notify_all();
+    }
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+    // Discard the jobs that were never run
+    for (std::unique_ptr<WorkStealingDeque<Job>>& deque : _deques)
+    {
+        for (Job* job = deque->steal(); job != nullptr; job = deque->steal())
+        {
+            delete job;
+        }
+    }
+    for (Job* job : _injected_jobs)
+    {
+        delete job;
+    }
+    _injected_jobs.clear();
+    _deques.clear();
+    _queued_jobs = 0;
+    // The fibers of the jobs still suspended are discarded with them
+    _fence_waits.clear();
+    _n_fence_waits = 0;
+    _free_fibers.clear();
+    _fibers.clear();
+    _discard_bound_jobs();
+    _thread_state().slot = -1;
+    _initialized = false;
+}
+
+unsigned int JobSystem::n_threads()
+{
+    initialize();
+    return _deques.size();
+}
+
+void JobSystem::submit(const std::function<void()>& function, JobCounter* counter, JobCounter* dependency)
+{
+    initialize();
+    Job* job = new Job();
+    job->function = function;
+    job->counter = counter;
+    if (counter != nullptr)
+    {
+        counter->_increment();
+    }
+    // A job with an unfinished dependency is started by the thread that completes the dependency
+    if (dependency != nullptr && dependency->_add_waiting_job(job))
+    {
+        return;
+    }
+    _schedule(job);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    if (counter.done())
+    {
+        return;
+    }
+    ThreadState& state = _thread_state();
+    // Inside a job the fiber is registered on the counter only once suspended, as it could be resumed right away by another thread
+    if (state.current_fiber != nullptr)
+    {
+        state.wait_counter = &counter;
+        _suspend(state, WAIT_COUNTER);
+        return;
+    }
+    // The jobs bound to the thread can only be resumed by it, so it keeps running jobs until they are done
+    while (!counter.done() || state.bound_jobs.n_suspended.load() > 0)
+    {
+        Job* job = _find_job();
+        if (job != nullptr)
+        {
+            _run(job);
+        }
+        else if (!_poll_fences())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::wait(VkDevice device, VkFence fence)
+{
+    if (vkGetFenceStatus(device, fence) != VK_NOT_READY)
+    {
+        return;
+    }
+    ThreadState& state = _thread_state();
+    if (state.current_fiber != nullptr)
+    {
+        state.wait_device = device;
+        state.wait_fence = fence;
+        _suspend(state, WAIT_FENCE);
+        return;
+    }
+    while (vkGetFenceStatus(device, fence) == VK_NOT_READY || state.bound_jobs.n_suspended.load() > 0)
+    {
+        Job* job = _find_job();
+        if (job != nullptr)
+        {
+            _run(job);
+        }
+        else if (!_poll_fences())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::decrement(JobCounter& counter)
+{
+    std::vector<Job*> ready_jobs;
+    counter._decrement(ready_jobs);
+    for (Job* ready_job : ready_jobs)
+    {
+        _schedule(ready_job);
+    }
+}
+
+bool JobSystem::in_job()
+{
+    return _thread_state().current_fiber != nullptr;
+}
+
+void JobSystem::bind_to_thread()
+{
+    ThreadState& state = _thread_state();
+    if (state.current_fiber != nullptr)
+    {
+        state.current_fiber->_job->bound_thread = &state.bound_jobs;
+    }
+}
+
+void JobSystem::parallel_for(size_t begin, size_t end, const std::function<void(size_t, size_t)>& function, size_t min_chunk)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+    if (min_chunk == 0)
+    {
+        min_chunk = std::max((end - begin) / (8 * n_threads()), size_t(1));
+    }
+    JobCounter counter;
+    submit([begin, end, &function, min_chunk, &counter]() {_parallel_for_range(begin, end, function, min_chunk, counter);}, &counter);
+    wait(counter);
+}
+
+JobSystem::ThreadState& JobSystem::_thread_state()
+{
+    thread_local ThreadState state;
+    // The volatile access keeps the compiler from assuming the function always returns the same address
+    ThreadState* volatile address = &state;
+    return *address;
+}
+
+void JobSystem::_schedule(Job* job)
+{
+    if (job->bound_thread != nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(job->bound_thread->mutex);
+            job->bound_thread->resumes.push_back(job);
+            job->bound_thread->n_resumes.fetch_add(1);
+        }
+        // The sleeping worker to wake up is the one the job is bound to
+        if (_sleeping_workers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _wake_up.notify_all();
+        }
+        return;
+    }
+    int slot = _thread_state().slot;
+    if (slot >= 0)
+    {
+        _deques[slot]->push(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(_injection_mutex);
+        _injected_jobs.push_back(job);
+    }
+    _queued_jobs.fetch_add(1);
+    // The lock ensures a worker can't miss the notification between checking for jobs and going to sleep
+    if (_sleeping_workers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _wake_up.notify_one();
+    }
+}
+
+Job* JobSystem::_find_job()
+{
+    Job* job = nullptr;
+    ThreadState& state = _thread_state();
+    int slot = state.slot;
+    // The jobs bound to the thread first, no other thread can run them
+    if (state.bound_jobs.n_resumes.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(state.bound_jobs.mutex);
+        if (!state.bound_jobs.resumes.empty())
+        {
+            job = state.bound_jobs.resumes.back();
+            state.bound_jobs.resumes.pop_back();
+            state.bound_jobs.n_resumes.fetch_sub(1);
+            state.bound_jobs.n_suspended.fetch_sub(1);
+            return job;
+        }
+    }
+    // Newest job of the calling thread first, as its data is likely still in cache
+    if (slot >= 0)
+    {
+        job = _deques[slot]->pop();
+    }
+    // Then steal the oldest job of another thread, starting from a random victim
+    if (job == nullptr)
+    {
+        thread_local uint32_t random_state = 2463534242u + 7919u * static_cast<uint32_t>(slot + 1);
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        size_t n = _deques.size();
+        size_t start = random_state % n;
+        for (size_t i=0; i<n && job == nullptr; i++)
+        {
+            size_t victim = (start + i) % n;
+            if (static_cast<int>(victim) != slot)
+            {
+                job = _deques[victim]->steal();
+            }
+        }
+    }
+    // Finally the jobs submitted from other threads
+    if (job == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_injection_mutex);
+        if (!_injected_jobs.empty())
+        {
+            job = _injected_jobs.front();
+            _injected_jobs.pop_front();
+        }
+    }
+    if (job != nullptr)
+    {
+        _queued_jobs.fetch_sub(1);
+    }
+    return job;
+}
+
+void JobSystem::_run(Job* job)
+{
+    ThreadState& state = _thread_state();
+    if (state.context == nullptr)
+    {
+        state.context.reset(new Fiber());
+    }
+    Fiber* fiber = job->fiber;
+    if (fiber == nullptr)
+    {
+        fiber = _acquire_fiber();
+        fiber->_job = job;
+    }
+    else
+    {
+        delete job;
+    }
+    state.current_fiber = fiber;
+    state.action = NONE;
+    Fiber::_switch(*state.context, *fiber);
+    // The thread's own context never moves, so 'state' is still the calling thread's state
+    state.current_fiber = nullptr;
+    if (state.action == FINISHED)
+    {
+        std::lock_guard<std::mutex> lock(_fiber_mutex);
+        _free_fibers.push_back(fiber);
+    }
+    else if (state.action == WAIT_COUNTER)
+    {
+        Job* resume = new Job();
+        resume->fiber = fiber;
+        resume->bound_thread = fiber->_job->bound_thread;
+        if (resume->bound_thread != nullptr)
+        {
+            state.bound_jobs.n_suspended.fetch_add(1);
+        }
+        if (!state.wait_counter->_add_waiting_job(resume))
+        {
+            _schedule(resume);
+        }
+    }
+    else if (state.action == WAIT_FENCE)
+    {
+        std::lock_guard<std::mutex> lock(_fence_mutex);
+        if (fiber->_job->bound_thread != nullptr)
+        {
+            state.bound_jobs.n_suspended.fetch_add(1);
+        }
+        _fence_waits.push_back({state.wait_device, state.wait_fence, fiber});
+        _n_fence_waits.fetch_add(1);
+    }
+}
+
+void JobSystem::_fiber_loop()
+{
+    while (true)
+    {
+        Job* job = _thread_state().current_fiber->_job;
+        job->function();
+        if (job->counter != nullptr)
+        {
+            decrement(*job->counter);
+        }
+        delete job;
+        // The job might have been resumed by another thread, so the thread state is fetched again
+        ThreadState& state = _thread_state();
+        state.current_fiber->_job = nullptr;
+        _suspend(state, FINISHED);
+    }
+}
+
+void JobSystem::_suspend(ThreadState& state, FiberAction action)
+{
+    state.action = action;
+    Fiber::_switch(*state.current_fiber, *state.context);
+}
+
+Fiber* JobSystem::_acquire_fiber()
+{
+    std::lock_guard<std::mutex> lock(_fiber_mutex);
+    if (_free_fibers.empty())
+    {
+        _fibers.emplace_back(new Fiber(_fiber_loop));
+        return _fibers.back().get();
+    }
+    Fiber* fiber = _free_fibers.back();
+    _free_fibers.pop_back();
+    return fiber;
+}
+
+bool JobSystem::_poll_fences()
+{
+    if (_n_fence_waits.load() == 0)
+    {
+        return false;
+    }
+    // A single thread polls at a time, the others have better things to do
+    std::unique_lock<std::mutex> lock(_fence_mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return false;
+    }
+    std::vector<Fiber*> ready_fibers;
+    for (size_t i=0; i<_fence_waits.size();)
+    {
+        if (vkGetFenceStatus(_fence_waits[i].device, _fence_waits[i].fence) != VK_NOT_READY)
+        {
+            ready_fibers.push_back(_fence_waits[i].fiber);
+            _fence_waits[i] = _fence_waits.back();
+            _fence_waits.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+    _n_fence_waits.store(static_cast<int>(_fence_waits.size()));
+    lock.unlock();
+    for (Fiber* fiber : ready_fibers)
+    {
+        Job* resume = new Job();
+        resume->fiber = fiber;
+        resume->bound_thread = fiber->_job->bound_thread;
+        _schedule(resume);
+    }
+    return !ready_fibers.empty();
+}
+
+void JobSystem::_worker_loop(unsigned int slot)
+{
+    _thread_state().slot = slot;
+    unsigned int failed_attempts = 0;
+    while (!_stopping.load())
+    {
+        Job* job = _find_job();
+        if (job != nullptr)
+        {
+            _run(job);
+            failed_attempts = 0;
+        }
+        else if (_poll_fences())
+        {
+            failed_attempts = 0;
+        }
+        // Spin a little before sleeping, as jobs often come in bursts
+        else if (failed_attempts < 64)
+        {
+            failed_attempts++;
+            std::this_thread::yield();
+        }
+        // Fences don't notify the workers, so they can only nap while some are waited for
+        else if (_n_fence_waits.load() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(_sleep_mutex);
+            _sleeping_workers.fetch_add(1);
+            BoundJobs& bound_jobs = _thread_state().bound_jobs;
+            _wake_up.wait_for(lock, std::chrono::milliseconds(10), [&bound_jobs]() {return _queued_jobs.load() > 0 || bound_jobs.n_resumes.load() > 0 || _stopping.load();});
+            _sleeping_workers.fetch_sub(1);
+            failed_attempts = 0;
+        }
+    }
+    _discard_bound_jobs();
+}
+
+void JobSystem::_discard_bound_jobs()
+{
+    BoundJobs& bound_jobs = _thread_state().bound_jobs;
+    std::lock_guard<std::mutex> lock(bound_jobs.mutex);
+    for (Job* job : bound_jobs.resumes)
+    {
+        delete job;
+    }
+    bound_jobs.resumes.clear();
+    bound_jobs.n_resumes = 0;
+    bound_jobs.n_suspended = 0;
+}
+
+void JobSystem::_parallel_for_range(size_t begin, size_t end, const std::function<void(size_t, size_t)>& function, size_t min_chunk, JobCounter& counter)
+{
+    // Lazy binary splitting: the upper half is handed to the other threads only while the local deque is almost empty,
+    // so the chunks stay large when all threads are busy and get smaller when some threads are starving
+    while (end - begin > min_chunk && (_thread_state().slot < 0 || _deques[_thread_state().slot]->size() < 2))
+    {
+        size_t middle = begin + (end - begin) / 2;
+        submit([middle, end, &function, min_chunk, &counter]() {_parallel_for_range(middle, end, function, min_chunk, counter);}, &counter);
+        end = middle;
+    }
+    function(begin, end);
+}
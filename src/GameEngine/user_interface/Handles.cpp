@@ -1,4 +1,5 @@
 #include <GameEngine/user_interface/Handles.hpp>
+#include <GameEngine/graphics/HostAllocator.hpp>
 #include <GameEngine/Engine.hpp>
 
 using namespace GameEngine;
@@ -26,7 +27,7 @@ Handles::Handles(const WindowSettings& settings)
 Handles::~Handles()
 {
     glfwDestroyWindow(_glfw_window);
-    vkDestroySurfaceKHR(Engine::get_vulkan_instance(), _vk_surface, nullptr);
+    vkDestroySurfaceKHR(Engine::get_vulkan_instance(), _vk_surface, HostAllocator::callbacks());
 }
 
 void Handles::_window_resize_callback(GLFWwindow* window, int width, int height)
@@ -34,6 +35,7 @@ void Handles::_window_resize_callback(GLFWwindow* window, int width, int height)
     Handles* h = static_cast<Handles*>(glfwGetWindowUserPointer(window));
     h->_window_width = width;
     h->_window_height = height;
+    h->_window_resized = true;
     // glfwSetWindowSize(h->_glfw_window, width, height);
 }
 
@@ -41,6 +43,7 @@ void Handles::_mouse_button_callback(GLFWwindow* window, int button, int action,
 {
     (void)mods;//Silence the annoying unused parameter warning
     Handles* h = static_cast<Handles*>(glfwGetWindowUserPointer(window));
+    h->_record_input_time();
     std::string name;
     if (button == GLFW_MOUSE_BUTTON_LEFT)
     {
@@ -74,6 +77,7 @@ void Handles::_mouse_button_callback(GLFWwindow* window, int button, int action,
 void Handles::_mouse_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
     Handles* h = static_cast<Handles*>(glfwGetWindowUserPointer(window));
+    h->_record_input_time();
     h->_mouse_dx = xpos - h->_mouse_x;
     h->_mouse_dy = ypos - h->_mouse_y;
     h->_mouse_x = xpos;
@@ -83,6 +87,7 @@ void Handles::_mouse_position_callback(GLFWwindow* window, double xpos, double y
 void Handles::_mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     Handles* h = static_cast<Handles*>(glfwGetWindowUserPointer(window));
+    h->_record_input_time();
     h->_mouse_wheel_x = xoffset;
     h->_mouse_wheel_y = yoffset;
 }
@@ -91,6 +96,7 @@ void Handles::_keyboard_button_callback(GLFWwindow* window, int key, int scancod
 {
     (void)mods;//Silence the annoying unused parameter warning
     Handles* h = static_cast<Handles*>(glfwGetWindowUserPointer(window));
+    h->_record_input_time();
     std::string name = _get_key_name(key, scancode);
     Button& button = h->_keyboard_buttons[name];
     if (action == GLFW_PRESS)
@@ -225,6 +231,15 @@ void Handles::_set_unchanged()
     _mouse_dy = 0.;
     _mouse_wheel_x = 0.;
     _mouse_wheel_y = 0.;
+    _input_time = -1.;
+}
+
+void Handles::_record_input_time()
+{
+    if (_input_time < 0.)
+    {
+        _input_time = _frame_timer.t();
+    }
 }
 
 void Handles::_initialize(const WindowSettings& settings)
@@ -249,6 +264,10 @@ void Handles::_initialize(const WindowSettings& settings)
         glfwSetWindowSize(_glfw_window, width, height);
     }
     _window_vsync = settings.vsync;
+    _window_max_fps = settings.max_fps;
+    _window_low_latency = settings.low_latency;
+    _window_width = width;
+    _window_height = height;
     _window_title = settings.title;
     _glfw_window = glfwCreateWindow(width, height, _window_title.c_str(), monitor, nullptr);
     if (_glfw_window == nullptr)
@@ -284,7 +303,7 @@ void Handles::_initialize(const WindowSettings& settings)
     // Setup window events
     glfwSetWindowSizeCallback(_glfw_window, _window_resize_callback);
     // Create the vkSurface
-    VkResult result = glfwCreateWindowSurface(Engine::get_vulkan_instance(), _glfw_window, NULL, &_vk_surface);
+    VkResult result = glfwCreateWindowSurface(Engine::get_vulkan_instance(), _glfw_window, HostAllocator::callbacks(), &_vk_surface);
     if (result != VK_SUCCESS)
     {
         THROW_ERROR("Failed to create the Vulkan surface")
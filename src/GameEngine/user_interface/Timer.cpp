@@ -1,4 +1,6 @@
 #include <GameEngine/user_interface/Timer.hpp>
+#include <thread>
+#include <cmath>
 using namespace GameEngine;
 
 Timer::Timer()
@@ -35,11 +37,38 @@ double Timer::dt()
 
 void Timer::reset_dt()
 {
-    _last = std::chrono::steady_clock::now();;
+    _last = std::chrono::steady_clock::now();
 }
 
 void Timer::restart()
 {
     _start = std::chrono::steady_clock::now();
     _last = _start;
-}
\ No newline at end of file
+}
+
+void Timer::sleep_until(double time)
+{
+    // Sleep by short steps as long as the remaining time is larger than a pessimistic estimate of the sleep duration
+    double remaining = time - t();
+    while (remaining > _sleep_mean + std::sqrt(_sleep_variance))
+    {
+        std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::chrono::duration<double> slept = std::chrono::steady_clock::now() - before;
+        _record_sleep_duration(slept.count());
+        remaining = time - t();
+    }
+    // Spin for the last fraction of a millisecond, where the OS scheduler is not precise enough
+    while (t() < time)
+    {
+    }
+}
+
+void Timer::_record_sleep_duration(double duration)
+{
+    // exponential moving average, so that the estimate follows changes of the OS scheduler resolution
+    const double alpha = 0.05;
+    double delta = duration - _sleep_mean;
+    _sleep_mean += alpha * delta;
+    _sleep_variance = (1. - alpha) * (_sleep_variance + alpha * delta * delta);
+}
@@ -27,13 +27,15 @@ Window::~Window()
 
 void Window::update()
 {
+    //Drawing to screen
+    swap_chain._end_frame(*this);
+    //Waiting for the next frame if the frame rate is limited
+    _limit_frame_rate();
+    //Waiting for the GPU to be ready for the next frame, before polling events so that the inputs are as recent as possible
+    swap_chain._begin_frame(*this);
     //Polling events
     _state->_set_unchanged();
     glfwPollEvents();
-    //Drawing to screen
-
-    //Engine::shader_test->draw();
-    glfwSwapBuffers(_state->_glfw_window);
 }
 
 unsigned int Window::x() const
@@ -183,15 +185,45 @@ bool Window::vsync() const
 
 void Window::vsync(bool enabled)
 {
-    _state->_window_vsync = enabled;
-    if (enabled)
+    if (enabled == _state->_window_vsync)
     {
-        glfwSwapInterval(1);
+        return;
     }
-    else
+    _state->_window_vsync = enabled;
+    // The present mode can only be changed by recreating the swap chain
+    swap_chain._recreate(*this);
+}
+
+double Window::max_fps() const
+{
+    return _state->_window_max_fps;
+}
+
+void Window::max_fps(double fps)
+{
+    _state->_window_max_fps = std::max(fps, 0.);
+    _state->_next_frame_time = 0.;
+}
+
+bool Window::low_latency() const
+{
+    return _state->_window_low_latency;
+}
+
+void Window::low_latency(bool enabled)
+{
+    if (enabled == _state->_window_low_latency)
     {
-        glfwSwapInterval(0);
+        return;
     }
+    _state->_window_low_latency = enabled;
+    // The number of frames in flight and of swap chain images depend on the mode
+    swap_chain._recreate(*this);
+}
+
+double Window::input_latency() const
+{
+    return _state->_input_latency;
 }
 
 const std::shared_ptr<Handles>& Window::_get_state() const
@@ -202,4 +234,25 @@ const std::shared_ptr<Handles>& Window::_get_state() const
 const VkSurfaceKHR& Window::_get_vk_surface() const
 {
     return _state->_vk_surface;
-}
\ No newline at end of file
+}
+
+void Window::_limit_frame_rate()
+{
+    if (_state->_window_max_fps <= 0.)
+    {
+        return;
+    }
+    double period = 1. / _state->_window_max_fps;
+    Timer& timer = _state->_frame_timer;
+    // Frames are scheduled at fixed deadlines so that the waiting errors don't accumulate.
+    // If the frame is more than a period late, the schedule is reset instead of rushing the next frames.
+    if (timer.t() - _state->_next_frame_time > period)
+    {
+        _state->_next_frame_time = timer.t();
+    }
+    else
+    {
+        timer.sleep_until(_state->_next_frame_time);
+    }
+    _state->_next_frame_time += period;
+}
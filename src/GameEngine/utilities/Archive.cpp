@@ -0,0 +1,292 @@
+#include <GameEngine/utilities/Archive.hpp>
+#include <GameEngine/utilities/Compression.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+using namespace GameEngine;
+
+constexpr char Archive::_magic[8];
+
+static_assert(sizeof(ArchiveHeader) == 56, "the archive header must have no padding");
+static_assert(sizeof(ArchiveEntry) == 48, "archive entries must have no padding");
+
+// Returns true if [offset, offset + size) is in a file of 'file_size' bytes. The offsets read from a corrupted file can be anything,
+// so the end is never computed, as it could wrap around
+static bool in_file(uint64_t offset, uint64_t size, uint64_t file_size)
+{
+    return offset <= file_size && size <= file_size - offset;
+}
+
+Archive::Archive(const std::string& file_path) : _file(file_path)
+{
+    // Validate the layout once, so that lookups don't have to check anything
+    if (_file.size() < sizeof(ArchiveHeader) || std::memcmp(_file.data(), _magic, sizeof(_magic)) != 0)
+    {
+        THROW_ERROR("'" + file_path + "' is not an archive")
+    }
+    _header = reinterpret_cast<const ArchiveHeader*>(_file.data());
+    if (_header->version != _version)
+    {
+        THROW_ERROR("'" + file_path + "' is an archive of version " + std::to_string(_header->version) + ", expected version " + std::to_string(_version))
+    }
+    uint64_t n_buckets = _header->n_buckets;
+    if (n_buckets == 0 || (n_buckets & (n_buckets - 1)) != 0 ||
+        !in_file(_header->entries_offset, uint64_t(_header->n_entries) * sizeof(ArchiveEntry), _file.size()) || _header->entries_offset % alignof(ArchiveEntry) != 0 ||
+        !in_file(_header->buckets_offset, (n_buckets + 1) * sizeof(uint32_t), _file.size()) || _header->buckets_offset % alignof(uint32_t) != 0 ||
+        _header->paths_offset > _file.size())
+    {
+        THROW_ERROR("The table of contents of archive '" + file_path + "' is corrupted")
+    }
+    _entries = reinterpret_cast<const ArchiveEntry*>(_file.data() + _header->entries_offset);
+    _buckets = reinterpret_cast<const uint32_t*>(_file.data() + _header->buckets_offset);
+    _paths = reinterpret_cast<const char*>(_file.data() + _header->paths_offset);
+    _bucket_shift = 64 - _bucket_bits(_header->n_buckets);
+    for (uint32_t i=0; i<_header->n_entries; i++)
+    {
+        const ArchiveEntry& entry = _entries[i];
+        if (!in_file(entry.offset, entry.size, _file.size()) || !in_file(entry.path_offset, entry.path_size, _file.size() - _header->paths_offset))
+        {
+            THROW_ERROR("The entry " + std::to_string(i) + " of archive '" + file_path + "' is out of the file")
+        }
+    }
+    for (uint64_t b=0; b<n_buckets; b++)
+    {
+        if (_buckets[b] > _buckets[b + 1] || _buckets[b + 1] > _header->n_entries)
+        {
+            THROW_ERROR("The bucket table of archive '" + file_path + "' is corrupted")
+        }
+    }
+}
+
+Archive::~Archive()
+{
+}
+
+const ArchiveEntry* Archive::find(const std::string& path) const
+{
+    std::string normalized = normalize_path(path);
+    uint64_t hash = path_hash(normalized);
+    uint64_t bucket = (_bucket_shift < 64) ? (hash >> _bucket_shift) : 0;
+    for (uint32_t i=_buckets[bucket]; i<_buckets[bucket + 1]; i++)
+    {
+        const ArchiveEntry& entry = _entries[i];
+        if (entry.hash == hash && entry.path_size == normalized.size() && std::memcmp(_paths + entry.path_offset, normalized.data(), normalized.size()) == 0)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool Archive::contains(const std::string& path) const
+{
+    return find(path) != nullptr;
+}
+
+const unsigned char* Archive::data(const ArchiveEntry& entry) const
+{
+    return _file.data() + entry.offset;
+}
+
+std::vector<unsigned char> Archive::read(const std::string& path) const
+{
+    const ArchiveEntry* entry = find(path);
+    if (entry == nullptr)
+    {
+        THROW_ERROR("The archive '" + _file.path() + "' has no file '" + path + "'")
+    }
+    return read(*entry);
+}
+
+std::vector<unsigned char> Archive::read(const ArchiveEntry& entry) const
+{
+    const unsigned char* blob = data(entry);
+    switch (entry.compression)
+    {
+        case ARCHIVE_UNCOMPRESSED:
+            return std::vector<unsigned char>(blob, blob + entry.size);
+        case ARCHIVE_LZ4:
+        {
+            std::vector<unsigned char> content(entry.uncompressed_size);
+            Compression::decompress(blob, entry.size, content.data(), content.size());
+            return content;
+        }
+        default:
+            THROW_ERROR("The file '" + path(entry) + "' of archive '" + _file.path() + "' has an unknown compression " + std::to_string(entry.compression))
+    }
+}
+
+std::string Archive::path(const ArchiveEntry& entry) const
+{
+    return std::string(_paths + entry.path_offset, entry.path_size);
+}
+
+const ArchiveEntry* Archive::entries() const
+{
+    return _entries;
+}
+
+uint32_t Archive::size() const
+{
+    return _header->n_entries;
+}
+
+std::string Archive::normalize_path(const std::string& path)
+{
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    return Utilities::simplify_path(normalized);
+}
+
+uint64_t Archive::path_hash(const std::string& normalized_path)
+{
+    return Utilities::hash(normalized_path.data(), normalized_path.size());
+}
+
+unsigned int Archive::_bucket_bits(uint32_t n_buckets)
+{
+    unsigned int bits = 0;
+    while ((1u << bits) < n_buckets)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+ArchiveWriter::ArchiveWriter(uint32_t alignment, DerivedDataCache* cache) : _alignment(alignment), _cache(cache)
+{
+    if (_alignment == 0 || (_alignment & (_alignment - 1)) != 0)
+    {
+        THROW_ERROR("The alignment of the archive blobs must be a power of 2")
+    }
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+}
+
+void ArchiveWriter::add(const std::string& path, const std::vector<unsigned char>& content, bool compress)
+{
+    File file;
+    file.path = Archive::normalize_path(path);
+    file.hash = Archive::path_hash(file.path);
+    std::unordered_map<uint64_t, size_t>::const_iterator it = _indices.find(file.hash);
+    if (it != _indices.end())
+    {
+        const File& other = _files[it->second];
+        std::string error = (other.path == file.path) ? "The file '" + file.path + "' was added twice to the archive" :
+                            "The paths '" + file.path + "' and '" + other.path + "' have the same hash";
+        THROW_ERROR(error)
+    }
+    file.uncompressed_size = content.size();
+    file.compression = ARCHIVE_UNCOMPRESSED;
+    if (compress && _cache != nullptr)
+    {
+        DerivedDataCache::Key key("lz4", 1);
+        key.add(content.data(), content.size());
+        file.blob = _cache->get_or_cook(key, [&content]() {return Compression::compress(content.data(), content.size());});
+        file.compression = ARCHIVE_LZ4;
+    }
+    else if (compress)
+    {
+        file.blob = Compression::compress(content.data(), content.size());
+        file.compression = ARCHIVE_LZ4;
+    }
+    if (!compress || file.blob.size() >= content.size())
+    {
+        file.blob = content;
+        file.compression = ARCHIVE_UNCOMPRESSED;
+    }
+    _indices.emplace(file.hash, _files.size());
+    _files.push_back(std::move(file));
+}
+
+void ArchiveWriter::add_file(const std::string& path, const std::string& file_path, bool compress)
+{
+    MappedFile file(file_path);
+    add(path, std::vector<unsigned char>(file.data(), file.data() + file.size()), compress);
+}
+
+void ArchiveWriter::write(const std::string& file_path) const
+{
+    std::vector<const File*> files;
+    for (const File& file : _files)
+    {
+        files.push_back(&file);
+    }
+    std::sort(files.begin(), files.end(), [](const File* a, const File* b) {return a->hash < b->hash;});
+    // About one entry per bucket
+    uint32_t n_buckets = 1;
+    while (n_buckets < files.size())
+    {
+        n_buckets *= 2;
+    }
+    unsigned int shift = 64 - Archive::_bucket_bits(n_buckets);
+    auto align = [](uint64_t offset, uint64_t alignment) {return (offset + alignment - 1) / alignment * alignment;};
+    ArchiveHeader header{};
+    std::memcpy(header.magic, Archive::_magic, sizeof(header.magic));
+    header.version = Archive::_version;
+    header.alignment = _alignment;
+    header.n_entries = files.size();
+    header.n_buckets = n_buckets;
+    header.entries_offset = align(sizeof(ArchiveHeader), alignof(ArchiveEntry));
+    header.buckets_offset = header.entries_offset + files.size() * sizeof(ArchiveEntry);
+    header.paths_offset = header.buckets_offset + (n_buckets + 1) * sizeof(uint32_t);
+    std::vector<ArchiveEntry> entries(files.size());
+    std::string paths;
+    for (size_t i=0; i<files.size(); i++)
+    {
+        entries[i].path_offset = paths.size();
+        entries[i].path_size = files[i]->path.size();
+        paths += files[i]->path;
+    }
+    header.data_offset = align(header.paths_offset + paths.size(), _alignment);
+    uint64_t offset = header.data_offset;
+    std::vector<uint32_t> buckets(n_buckets + 1, 0);
+    for (size_t i=0; i<files.size(); i++)
+    {
+        offset = align(offset, _alignment);
+        entries[i].hash = files[i]->hash;
+        entries[i].offset = offset;
+        entries[i].size = files[i]->blob.size();
+        entries[i].uncompressed_size = files[i]->uncompressed_size;
+        entries[i].compression = files[i]->compression;
+        offset += files[i]->blob.size();
+        uint64_t bucket = (shift < 64) ? (files[i]->hash >> shift) : 0;
+        buckets[bucket + 1]++;
+    }
+    // Start of each bucket in the sorted entries
+    for (uint32_t b=0; b<n_buckets; b++)
+    {
+        buckets[b + 1] += buckets[b];
+    }
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        THROW_ERROR("failed to create the archive '" + file_path + "'")
+    }
+    std::vector<char> padding(std::max<uint64_t>(_alignment, alignof(ArchiveEntry)), 0);
+    uint64_t position = 0;
+    auto write = [&file, &position](const void* data, size_t size)
+    {
+        file.write(static_cast<const char*>(data), size);
+        position += size;
+    };
+    auto pad_to = [&write, &position, &padding](uint64_t offset) {write(padding.data(), offset - position);};
+    write(&header, sizeof(header));
+    pad_to(header.entries_offset);
+    write(entries.data(), entries.size() * sizeof(ArchiveEntry));
+    write(buckets.data(), buckets.size() * sizeof(uint32_t));
+    write(paths.data(), paths.size());
+    for (size_t i=0; i<files.size(); i++)
+    {
+        pad_to(entries[i].offset);
+        write(files[i]->blob.data(), files[i]->blob.size());
+    }
+    if (!file.good())
+    {
+        THROW_ERROR("failed to write the archive '" + file_path + "'")
+    }
+}
@@ -0,0 +1,440 @@
+#include <GameEngine/utilities/Compression.hpp>
+#include <GameEngine/multithreading/JobSystem.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+using namespace GameEngine;
+
+// Constants of the LZ4 block format
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t LAST_LITERALS = 5; // the last 5 bytes are always literals
+static constexpr size_t MATCH_FIND_LIMIT = 12; // the last match starts at least 12 bytes before the end
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr unsigned int HASH_BITS = 16;
+
+static inline uint32_t read32(const unsigned char* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash32(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Write a length continuation (the part of a length not fitting in the token nibble)
+static inline unsigned char* write_length(unsigned char* op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+size_t Compression::block_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t Compression::compress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity)
+{
+    // positions + 1 of the last sequences seen with each hash (0 for none)
+    thread_local std::vector<uint32_t> table;
+    table.assign(size_t(1) << HASH_BITS, 0);
+    unsigned char* op = destination;
+    unsigned char* const op_end = destination + capacity;
+    size_t anchor = 0; // start of the pending literals
+    auto emit = [&](size_t literals_end, size_t offset, size_t match_length) -> bool
+    {
+        size_t n_literals = literals_end - anchor;
+        // token + literal length + literals + offset + match length
+        if (static_cast<size_t>(op_end - op) < 1 + n_literals / 255 + 1 + n_literals + 2 + match_length / 255 + 1)
+        {
+            return false;
+        }
+        unsigned char* token = op++;
+        *token = static_cast<unsigned char>(std::min<size_t>(n_literals, 15) << 4);
+        if (n_literals >= 15)
+        {
+            op = write_length(op, n_literals - 15);
+        }
+        std::memcpy(op, source + anchor, n_literals);
+        op += n_literals;
+        if (match_length == 0)
+        {
+            return true;
+        }
+        *op++ = static_cast<unsigned char>(offset);
+        *op++ = static_cast<unsigned char>(offset >> 8);
+        size_t length = match_length - MIN_MATCH;
+        *token |= static_cast<unsigned char>(std::min<size_t>(length, 15));
+        if (length >= 15)
+        {
+            op = write_length(op, length - 15);
+        }
+        return true;
+    };
+    if (size > MATCH_FIND_LIMIT)
+    {
+        size_t match_limit = size - LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < size - MATCH_FIND_LIMIT)
+        {
+            uint32_t sequence = read32(source + ip);
+            uint32_t h = hash32(sequence);
+            size_t candidate = table[h];
+            table[h] = ip + 1;
+            if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read32(source + candidate - 1) != sequence)
+            {
+                // Skip faster through data that doesn't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            size_t match = candidate - 1;
+            // Extend the match backwards over the pending literals, and forwards
+            while (ip > anchor && match > 0 && source[ip - 1] == source[match - 1])
+            {
+                ip--;
+                match--;
+            }
+            size_t length = MIN_MATCH;
+            while (ip + length + 8 <= match_limit)
+            {
+                uint64_t a, b;
+                std::memcpy(&a, source + ip + length, 8);
+                std::memcpy(&b, source + match + length, 8);
+                if (a != b)
+                {
+                    break;
+                }
+                length += 8;
+            }
+            while (ip + length < match_limit && source[ip + length] == source[match + length])
+            {
+                length++;
+            }
+            if (!emit(ip, ip - match, length))
+            {
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+            if (ip < size - MATCH_FIND_LIMIT)
+            {
+                table[hash32(read32(source + ip - 2))] = ip - 2 + 1;
+            }
+        }
+    }
+    if (!emit(size, 0, 0))
+    {
+        return 0;
+    }
+    return op - destination;
+}
+
+size_t Compression::decompress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity)
+{
+    size_t decompressed = _decompress_block(source, size, destination, capacity);
+    if (decompressed == SIZE_MAX)
+    {
+        THROW_ERROR("corrupted LZ4 block")
+    }
+    return decompressed;
+}
+
+// Copy a match whose offset is shorter than 8 bytes, so that the bytes to repeat overlap the bytes written.
+// The first 8 bytes are copied so that the distance to the match becomes at least 8, then the rest 8 bytes at a time.
+// Writes up to 8 bytes past op + length, the caller checks there is room.
+static inline void copy_short_offset_match(unsigned char* op, const unsigned char* match, size_t offset, size_t length)
+{
+    static const unsigned int increments[8] = {0, 1, 2, 1, 0, 4, 4, 4};
+    static const int decrements[8] = {0, 0, 0, -1, -4, 1, 2, 3};
+    unsigned char* const end = op + length;
+    op[0] = match[0];
+    op[1] = match[1];
+    op[2] = match[2];
+    op[3] = match[3];
+    match += increments[offset];
+    std::memcpy(op + 4, match, 4);
+    match -= decrements[offset];
+    op += 8;
+    while (op < end)
+    {
+        std::memcpy(op, match, 8);
+        op += 8;
+        match += 8;
+    }
+}
+
+size_t Compression::_decompress_block(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity)
+{
+    const unsigned char* ip = source;
+    const unsigned char* const ip_end = source + size;
+    unsigned char* op = destination;
+    unsigned char* const op_end = destination + capacity;
+    while (true)
+    {
+        if (ip >= ip_end)
+        {
+            return SIZE_MAX;
+        }
+        unsigned int token = *ip++;
+        size_t n_literals = token >> 4;
+        // Fast path for the most common sequences: less than 15 literals and a match shorter than 19 bytes, far from the ends of the buffers.
+        // Literals and match are copied with fixed size copies, without loops nor length continuations.
+        if (n_literals != 15 && ip_end - ip >= 16 + 2 && op_end - op >= 32)
+        {
+            std::memcpy(op, ip, 16);
+            op += n_literals;
+            ip += n_literals;
+            size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            size_t length = token & 15;
+            if (length != 15 && offset >= 8 && offset <= static_cast<size_t>(op - destination))
+            {
+                ip += 2;
+                const unsigned char* match = op - offset;
+                std::memcpy(op, match, 8);
+                std::memcpy(op + 8, match + 8, 8);
+                std::memcpy(op + 16, match + 16, 2);
+                op += length + MIN_MATCH;
+                continue;
+            }
+            // Short offsets (repeated patterns) and long matches continue with the match of the general path
+        }
+        else
+        {
+            if (n_literals == 15)
+            {
+                unsigned char s;
+                do
+                {
+                    if (ip >= ip_end)
+                    {
+                        return SIZE_MAX;
+                    }
+                    s = *ip++;
+                    n_literals += s;
+                } while (s == 255);
+            }
+            if (n_literals > static_cast<size_t>(ip_end - ip) || n_literals > static_cast<size_t>(op_end - op))
+            {
+                return SIZE_MAX;
+            }
+            // Literals are copied 16 bytes at a time when there is room, which is most of the time
+            if (static_cast<size_t>(ip_end - ip) >= n_literals + 16 && static_cast<size_t>(op_end - op) >= n_literals + 16)
+            {
+                for (size_t i=0; i<n_literals; i+=16)
+                {
+                    std::memcpy(op + i, ip + i, 16);
+                }
+            }
+            else
+            {
+                std::memcpy(op, ip, n_literals);
+            }
+            op += n_literals;
+            ip += n_literals;
+            // The last sequence has no match
+            if (ip == ip_end)
+            {
+                break;
+            }
+            if (ip_end - ip < 2)
+            {
+                return SIZE_MAX;
+            }
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - destination))
+        {
+            return SIZE_MAX;
+        }
+        size_t length = token & 15;
+        if (length == 15)
+        {
+            unsigned char s;
+            do
+            {
+                if (ip >= ip_end)
+                {
+                    return SIZE_MAX;
+                }
+                s = *ip++;
+                length += s;
+            } while (s == 255);
+        }
+        length += MIN_MATCH;
+        if (length > static_cast<size_t>(op_end - op))
+        {
+            return SIZE_MAX;
+        }
+        const unsigned char* match = op - offset;
+        // Copies by chunks may write past the match end (rewritten by the next sequences), but never read bytes not written yet
+        if (static_cast<size_t>(op_end - op) < length + 16)
+        {
+            for (size_t i=0; i<length; i++)
+            {
+                op[i] = match[i];
+            }
+        }
+        else if (offset >= 16)
+        {
+            for (size_t i=0; i<length; i+=16)
+            {
+                std::memcpy(op + i, match + i, 16);
+            }
+        }
+        else if (offset >= 8)
+        {
+            for (size_t i=0; i<length; i+=8)
+            {
+                std::memcpy(op + i, match + i, 8);
+            }
+        }
+        else
+        {
+            copy_short_offset_match(op, match, offset, length);
+        }
+        op += length;
+    }
+    return op - destination;
+}
+
+std::vector<unsigned char> Compression::compress(const unsigned char* data, size_t size, uint32_t block_size)
+{
+    if (block_size == 0 || block_size >= _stored_bit)
+    {
+        THROW_ERROR("invalid compression block size " + std::to_string(block_size))
+    }
+    size_t n_blocks = (size + block_size - 1) / block_size;
+    std::vector<std::vector<unsigned char>> blocks(n_blocks);
+    std::vector<uint32_t> sizes(n_blocks);
+    JobSystem::parallel_for(0, n_blocks, [&](size_t begin, size_t end)
+    {
+        for (size_t b=begin; b<end; b++)
+        {
+            const unsigned char* block = data + b * block_size;
+            size_t block_length = std::min<size_t>(block_size, size - b * block_size);
+            blocks[b].resize(block_length);
+            // The block is stored as is if compressing doesn't make it smaller
+            size_t compressed = compress_block(block, block_length, blocks[b].data(), block_length - 1);
+            if (compressed == 0)
+            {
+                std::memcpy(blocks[b].data(), block, block_length);
+                sizes[b] = block_length | _stored_bit;
+            }
+            else
+            {
+                blocks[b].resize(compressed);
+                sizes[b] = compressed;
+            }
+        }
+    }, 1);
+    Header header;
+    std::memcpy(header.magic, "GELZ", 4);
+    header.block_size = block_size;
+    header.size = size;
+    size_t total = sizeof(Header) + n_blocks * sizeof(uint32_t);
+    for (const std::vector<unsigned char>& block : blocks)
+    {
+        total += block.size();
+    }
+    std::vector<unsigned char> result(total);
+    std::memcpy(result.data(), &header, sizeof(Header));
+    unsigned char* position = result.data() + sizeof(Header);
+    for (size_t b=0; b<n_blocks; b++, position += sizeof(uint32_t))
+    {
+        std::memcpy(position, &sizes[b], sizeof(uint32_t));
+    }
+    for (const std::vector<unsigned char>& block : blocks)
+    {
+        std::memcpy(position, block.data(), block.size());
+        position += block.size();
+    }
+    return result;
+}
+
+uint64_t Compression::decompressed_size(const unsigned char* data, size_t size)
+{
+    return _header(data, size).size;
+}
+
+void Compression::decompress(const unsigned char* data, size_t size, unsigned char* destination, size_t capacity)
+{
+    Header header = _header(data, size);
+    if (capacity < header.size)
+    {
+        THROW_ERROR("The decompressed data doesn't fit in the destination")
+    }
+    size_t n_blocks = (header.size + header.block_size - 1) / header.block_size;
+    if (sizeof(Header) + n_blocks * sizeof(uint32_t) > size)
+    {
+        THROW_ERROR("corrupted compressed data: truncated block table")
+    }
+    std::vector<uint32_t> sizes(n_blocks);
+    std::copy(data + sizeof(Header), data + sizeof(Header) + n_blocks * sizeof(uint32_t), reinterpret_cast<unsigned char*>(sizes.data()));
+    // Offset of each block in the compressed data
+    std::vector<size_t> offsets(n_blocks + 1);
+    offsets[0] = sizeof(Header) + n_blocks * sizeof(uint32_t);
+    for (size_t b=0; b<n_blocks; b++)
+    {
+        offsets[b + 1] = offsets[b] + (sizes[b] & ~_stored_bit);
+    }
+    if (offsets[n_blocks] > size)
+    {
+        THROW_ERROR("corrupted compressed data: truncated blocks")
+    }
+    // Errors can't propagate out of the jobs, so they are reported after the parallel loop
+    std::atomic<bool> corrupted(false);
+    JobSystem::parallel_for(0, n_blocks, [&](size_t begin, size_t end)
+    {
+        for (size_t b=begin; b<end && !corrupted.load(); b++)
+        {
+            unsigned char* block = destination + b * header.block_size;
+            size_t block_length = std::min<uint64_t>(header.block_size, header.size - b * header.block_size);
+            size_t decompressed;
+            if (sizes[b] & _stored_bit)
+            {
+                decompressed = sizes[b] & ~_stored_bit;
+                if (decompressed == block_length)
+                {
+                    std::memcpy(block, data + offsets[b], decompressed);
+                }
+            }
+            else
+            {
+                decompressed = _decompress_block(data + offsets[b], offsets[b + 1] - offsets[b], block, block_length);
+            }
+            if (decompressed != block_length)
+            {
+                corrupted = true;
+            }
+        }
+    }, 1);
+    if (corrupted)
+    {
+        THROW_ERROR("corrupted compressed data")
+    }
+}
+
+Compression::Header Compression::_header(const unsigned char* data, size_t size)
+{
+    if (size < sizeof(Header) || std::memcmp(data, "GELZ", 4) != 0)
+    {
+        THROW_ERROR("The data was not compressed with Compression::compress")
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.block_size == 0 || header.block_size >= _stored_bit)
+    {
+        THROW_ERROR("corrupted compressed data: invalid block size")
+    }
+    return header;
+}
@@ -0,0 +1,205 @@
+#include <GameEngine/utilities/DerivedDataCache.hpp>
+#include <GameEngine/utilities/MappedFile.hpp>
+#include <GameEngine/utilities/Functions.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <cstring>
+using namespace GameEngine;
+
+constexpr char DerivedDataCache::_magic[4];
+
+static_assert(sizeof(DerivedDataCache::FileHeader) == 40, "the cached output header must have no padding");
+
+DerivedDataCache::Key::Key(const std::string& step, uint32_t version)
+{
+    _hash[0] = 14695981039346656037ull;
+    _hash[1] = 0x84222325cbf29ce4ull;
+    add(step);
+    add(version);
+}
+
+DerivedDataCache::Key& DerivedDataCache::Key::add(const void* data, size_t size)
+{
+    uint64_t length = size;
+    for (uint64_t& hash : _hash)
+    {
+        hash = Utilities::hash(&length, sizeof(length), hash);
+        hash = Utilities::hash(data, size, hash);
+    }
+    return *this;
+}
+
+DerivedDataCache::Key& DerivedDataCache::Key::add(const std::string& value)
+{
+    return add(value.data(), value.size());
+}
+
+DerivedDataCache::Key& DerivedDataCache::Key::add(const char* value)
+{
+    return add(value, std::strlen(value));
+}
+
+DerivedDataCache::Key& DerivedDataCache::Key::add_file(const std::string& file_path)
+{
+    MappedFile file(file_path);
+    return add(file.data(), file.size());
+}
+
+std::string DerivedDataCache::Key::string() const
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hexadecimal;
+    for (uint64_t hash : _hash)
+    {
+        for (int shift = 60; shift >= 0; shift -= 4)
+        {
+            hexadecimal.push_back(digits[(hash >> shift) & 0xF]);
+        }
+    }
+    return hexadecimal;
+}
+
+bool DerivedDataCache::Key::operator==(const Key& other) const
+{
+    return _hash[0] == other._hash[0] && _hash[1] == other._hash[1];
+}
+
+DerivedDataCache::DerivedDataCache(const std::string& local_directory, const std::string& shared_directory) :
+    _local_directory(local_directory), _shared_directory(shared_directory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(_local_directory, error);
+    if (!std::filesystem::is_directory(_local_directory, error))
+    {
+        THROW_ERROR("failed to create the cache directory '" + _local_directory + "'")
+    }
+}
+
+DerivedDataCache::~DerivedDataCache()
+{
+}
+
+bool DerivedDataCache::get(const Key& key, std::vector<unsigned char>& output)
+{
+    if (_read(_path(_local_directory, key), key, output))
+    {
+        _hits++;
+        return true;
+    }
+    if (!_shared_directory.empty() && _read(_path(_shared_directory, key), key, output))
+    {
+        _write(_path(_local_directory, key), key, output);
+        _hits++;
+        return true;
+    }
+    _misses++;
+    return false;
+}
+
+void DerivedDataCache::put(const Key& key, const std::vector<unsigned char>& output)
+{
+    _write(_path(_local_directory, key), key, output);
+    if (!_shared_directory.empty())
+    {
+        _write(_path(_shared_directory, key), key, output);
+    }
+}
+
+std::vector<unsigned char> DerivedDataCache::get_or_cook(const Key& key, const std::function<std::vector<unsigned char>()>& cook)
+{
+    std::vector<unsigned char> output;
+    if (!get(key, output))
+    {
+        output = cook();
+        put(key, output);
+    }
+    return output;
+}
+
+uint64_t DerivedDataCache::hits() const
+{
+    return _hits.load();
+}
+
+uint64_t DerivedDataCache::misses() const
+{
+    return _misses.load();
+}
+
+std::string DerivedDataCache::_path(const std::string& directory, const Key& key)
+{
+    std::string name = key.string();
+    return directory + "/" + name.substr(0, 2) + "/" + name;
+}
+
+bool DerivedDataCache::_read(const std::string& file_path, const Key& key, std::vector<unsigned char>& output)
+{
+    // Missing files are the common case, so they are not opened with MappedFile (which reports the failure as an error)
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, _magic, sizeof(_magic)) != 0 ||
+        header.version != _version || header.key[0] != key._hash[0] || header.key[1] != key._hash[1])
+    {
+        return false;
+    }
+    // The size is checked against the file before allocating, as a corrupted header could ask for anything
+    std::streamoff content_start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = file.tellg();
+    if (content_start < 0 || file_size < content_start || header.size != static_cast<uint64_t>(file_size - content_start))
+    {
+        return false;
+    }
+    file.seekg(content_start);
+    std::vector<unsigned char> content(header.size);
+    if (!file.read(reinterpret_cast<char*>(content.data()), content.size()) || Utilities::hash(content.data(), content.size()) != header.checksum)
+    {
+        return false;
+    }
+    output = std::move(content);
+    return true;
+}
+
+bool DerivedDataCache::_write(const std::string& file_path, const Key& key, const std::vector<unsigned char>& output)
+{
+    FileHeader header{};
+    std::memcpy(header.magic, _magic, sizeof(_magic));
+    header.version = _version;
+    header.key[0] = key._hash[0];
+    header.key[1] = key._hash[1];
+    header.size = output.size();
+    header.checksum = Utilities::hash(output.data(), output.size());
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(file_path).parent_path(), error);
+    // The temporary name is unique among the threads and processes writing the same output, the last rename wins
+    thread_local std::mt19937_64 random(std::random_device{}());
+    std::string temporary_path = file_path + "." + std::to_string(random()) + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(output.data()), output.size());
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary_path, file_path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
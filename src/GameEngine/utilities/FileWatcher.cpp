@@ -0,0 +1,238 @@
+#include <GameEngine/utilities/FileWatcher.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#include <algorithm>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+using namespace GameEngine;
+
+#ifdef __linux__
+// Events of the watched directories: files written and closed or moved in (editors often save to a temporary file then rename it),
+// and subdirectories created or moved in (files created are reported once closed)
+static const uint32_t watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+#endif
+
+FileWatcher::FileWatcher(const std::vector<std::string>& directories, bool recursive, double poll_interval) : _recursive(recursive)
+{
+    for (const std::string& directory : directories)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(directory, error))
+        {
+            THROW_ERROR("can't watch '" + directory + "': it is not a directory")
+        }
+        _directories.push_back(normalize_path(directory));
+    }
+    _poll_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(poll_interval));
+    #ifdef __linux__
+    _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify >= 0)
+    {
+        try
+        {
+            for (const std::string& directory : _directories)
+            {
+                _watch(directory, nullptr);
+            }
+        }
+        catch (const std::runtime_error&)
+        {
+            // Out of inotify watches (the limit is per user): poll the modification times instead
+            close(_inotify);
+            _inotify = -1;
+            _watches.clear();
+        }
+    }
+    if (_inotify >= 0)
+    {
+        return;
+    }
+    #endif
+    // The first scan records the modification times without reporting the files
+    std::vector<std::string> existing;
+    _scan(existing);
+    _last_poll = std::chrono::steady_clock::now();
+}
+
+FileWatcher::~FileWatcher()
+{
+    #ifdef __linux__
+    if (_inotify >= 0)
+    {
+        close(_inotify);
+    }
+    #endif
+}
+
+std::vector<std::string> FileWatcher::changes()
+{
+    std::vector<std::string> changed;
+    #ifdef __linux__
+    if (_inotify >= 0)
+    {
+        _read_events(changed);
+    }
+    else
+    #endif
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - _last_poll >= _poll_interval)
+        {
+            _scan(changed);
+            _last_poll = now;
+        }
+    }
+    // A file saved once can generate several events
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+bool FileWatcher::uses_notifications() const
+{
+    #ifdef __linux__
+    return _inotify >= 0;
+    #else
+    return false;
+    #endif
+}
+
+std::string FileWatcher::normalize_path(const std::string& path)
+{
+    std::error_code error;
+    std::string normalized = std::filesystem::absolute(path, error).lexically_normal().generic_string();
+    if (normalized.size() > 1 && normalized.back() == '/')
+    {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+void FileWatcher::_scan(std::vector<std::string>& changed)
+{
+    // Files can be deleted or replaced while iterating, so errors skip the file rather than throwing
+    for (const std::string& directory : _directories)
+    {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, error);
+        for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!_recursive)
+            {
+                it.disable_recursion_pending();
+            }
+            std::error_code file_error;
+            if (!it->is_regular_file(file_error))
+            {
+                continue;
+            }
+            std::filesystem::file_time_type write_time = it->last_write_time(file_error);
+            if (file_error)
+            {
+                continue;
+            }
+            std::string path = it->path().generic_string();
+            std::unordered_map<std::string, std::filesystem::file_time_type>::iterator known = _write_times.find(path);
+            if (known == _write_times.end())
+            {
+                _write_times.emplace(path, write_time);
+                changed.push_back(path);
+            }
+            else if (known->second != write_time)
+            {
+                known->second = write_time;
+                changed.push_back(path);
+            }
+        }
+    }
+}
+
+#ifdef __linux__
+void FileWatcher::_watch(const std::string& directory, std::vector<std::string>* changed)
+{
+    int watch = inotify_add_watch(_inotify, directory.c_str(), watch_mask);
+    if (watch < 0)
+    {
+        if (errno == ENOSPC || errno == ENOMEM || changed == nullptr)
+        {
+            THROW_ERROR("failed to watch the directory '" + directory + "' (errno " + std::to_string(errno) + ")")
+        }
+        return; // the new directory was already removed
+    }
+    _watches[watch] = directory;
+    std::error_code error;
+    std::filesystem::directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, error);
+    for (; !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        std::error_code file_error;
+        if (_recursive && it->is_directory(file_error))
+        {
+            _watch(it->path().generic_string(), changed);
+        }
+        else if (changed != nullptr && it->is_regular_file(file_error))
+        {
+            // Written before the directory was watched
+            changed->push_back(it->path().generic_string());
+        }
+    }
+}
+
+void FileWatcher::_read_events(std::vector<std::string>& changed)
+{
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(_inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            break; // EAGAIN: no more events
+        }
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // Events were lost: fall back to the modification times (every file is reported on the first overflow)
+                _scan(changed);
+                continue;
+            }
+            std::unordered_map<int, std::string>::iterator watched = _watches.find(event->wd);
+            if (watched == _watches.end())
+            {
+                continue;
+            }
+            if (event->mask & IN_IGNORED)
+            {
+                _watches.erase(watched); // the directory was removed
+                continue;
+            }
+            if (event->len == 0)
+            {
+                continue;
+            }
+            std::string path = watched->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (_recursive && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                {
+                    try
+                    {
+                        _watch(path, &changed);
+                    }
+                    catch (const std::runtime_error&)
+                    {
+                        // Out of watches: the new directory is not watched, the error was reported
+                    }
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                changed.push_back(path);
+            }
+        }
+    }
+}
+#endif
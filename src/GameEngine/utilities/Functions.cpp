@@ -1,4 +1,7 @@
 #include <GameEngine/utilities/Functions.hpp>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 using namespace GameEngine;
 
 unsigned int Utilities::log2(unsigned int x)
@@ -96,3 +99,68 @@ unsigned int Utilities::replace_substrings(std::string& str, const std::string&
     }
     return k;
 }
+
+// The indices of the exited threads are reused by the new ones, so that the per thread tables stay small whatever the number of threads created
+struct ThreadIndices
+{
+    std::mutex mutex;
+    std::vector<unsigned int> free;
+    unsigned int count = 0;
+};
+
+static ThreadIndices& thread_indices()
+{
+    // Never destroyed, as threads may exit after the static objects are destroyed
+    static ThreadIndices* indices = new ThreadIndices();
+    return *indices;
+}
+
+// Index of a thread, taken on its first call to thread_index and given back when it exits
+struct ThreadIndex
+{
+    unsigned int index;
+    ThreadIndex()
+    {
+        ThreadIndices& indices = thread_indices();
+        std::lock_guard<std::mutex> lock(indices.mutex);
+        if (indices.free.empty())
+        {
+            index = indices.count++;
+        }
+        else
+        {
+            // the smallest free index, to keep the used indices dense
+            std::vector<unsigned int>::iterator smallest = std::min_element(indices.free.begin(), indices.free.end());
+            index = *smallest;
+            indices.free.erase(smallest);
+        }
+    }
+    ~ThreadIndex()
+    {
+        ThreadIndices& indices = thread_indices();
+        std::lock_guard<std::mutex> lock(indices.mutex);
+        indices.free.push_back(index);
+    }
+};
+
+unsigned int Utilities::thread_index()
+{
+    thread_local ThreadIndex thread;
+    return thread.index;
+}
+
+uint64_t Utilities::hash(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i=0; i<size; i++)
+    {
+        seed ^= bytes[i];
+        seed *= 1099511628211ull;
+    }
+    return seed;
+}
+
+void Utilities::hash_combine(uint64_t& seed, uint64_t value)
+{
+    seed ^= value + 0x9E3779B97F4A7C15ull + (seed << 12) + (seed >> 4);
+}
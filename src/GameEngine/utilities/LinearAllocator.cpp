@@ -0,0 +1,65 @@
+#include <GameEngine/utilities/LinearAllocator.hpp>
+#include <algorithm>
+using namespace GameEngine;
+
+LinearAllocator::LinearAllocator(size_t block_size)
+{
+    _block_size = block_size;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment)
+{
+    if (!_blocks.empty())
+    {
+        uintptr_t start = reinterpret_cast<uintptr_t>(_blocks.back().get()) + _offset;
+        size_t padding = (alignment - (start & (alignment - 1))) & (alignment - 1);
+        if (_offset + padding + size <= _block_sizes.back())
+        {
+            _offset += padding + size;
+            _used += padding + size;
+            return reinterpret_cast<void*>(start + padding);
+        }
+    }
+    // The new block is big enough for the allocation even in the worst alignment case
+    size_t block_size = std::max(_block_size, size + alignment);
+    _blocks.emplace_back(new char[block_size]);
+    _block_sizes.push_back(block_size);
+    uintptr_t start = reinterpret_cast<uintptr_t>(_blocks.back().get());
+    size_t padding = (alignment - (start & (alignment - 1))) & (alignment - 1);
+    _offset = padding + size;
+    _used += padding + size;
+    return reinterpret_cast<void*>(start + padding);
+}
+
+void LinearAllocator::reset()
+{
+    if (_blocks.size() > 1)
+    {
+        size_t total = capacity();
+        _blocks.clear();
+        _block_sizes.clear();
+        _blocks.emplace_back(new char[total]);
+        _block_sizes.push_back(total);
+    }
+    _offset = 0;
+    _used = 0;
+}
+
+size_t LinearAllocator::used() const
+{
+    return _used;
+}
+
+size_t LinearAllocator::capacity() const
+{
+    size_t total = 0;
+    for (size_t size : _block_sizes)
+    {
+        total += size;
+    }
+    return total;
+}
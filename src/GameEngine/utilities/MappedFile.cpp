@@ -0,0 +1,132 @@
+#include <GameEngine/utilities/MappedFile.hpp>
+#include <GameEngine/utilities/Macro.hpp>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+using namespace GameEngine;
+
+MappedFile::MappedFile(const std::string& file_path) : _path(file_path)
+{
+    #ifdef _WIN32
+    _file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        _file = nullptr;
+        THROW_ERROR("failed to open file '" + file_path + "' (error " + std::to_string(GetLastError()) + ")")
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size))
+    {
+        unsigned long error = GetLastError();
+        _close();
+        THROW_ERROR("failed to get the size of file '" + file_path + "' (error " + std::to_string(error) + ")")
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+    // Empty files can't be mapped
+    if (_size == 0)
+    {
+        return;
+    }
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping == nullptr)
+    {
+        unsigned long error = GetLastError();
+        _close();
+        THROW_ERROR("failed to map file '" + file_path + "' (error " + std::to_string(error) + ")")
+    }
+    _data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr)
+    {
+        unsigned long error = GetLastError();
+        _close();
+        THROW_ERROR("failed to map file '" + file_path + "' (error " + std::to_string(error) + ")")
+    }
+    #else
+    _file = open(file_path.c_str(), O_RDONLY);
+    if (_file < 0)
+    {
+        THROW_ERROR("failed to open file '" + file_path + "': " + std::string(strerror(errno)))
+    }
+    struct stat status;
+    if (fstat(_file, &status) != 0)
+    {
+        int error = errno;
+        _close();
+        THROW_ERROR("failed to get the size of file '" + file_path + "': " + std::string(strerror(error)))
+    }
+    _size = static_cast<size_t>(status.st_size);
+    // Empty files can't be mapped
+    if (_size == 0)
+    {
+        return;
+    }
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED)
+    {
+        int error = errno;
+        _close();
+        THROW_ERROR("failed to map file '" + file_path + "': " + std::string(strerror(error)))
+    }
+    _data = static_cast<const unsigned char*>(data);
+    // The whole file is usually read right away: start reading it ahead
+    madvise(data, _size, MADV_WILLNEED);
+    #endif
+}
+
+MappedFile::~MappedFile()
+{
+    _close();
+}
+
+const unsigned char* MappedFile::data() const
+{
+    return _data;
+}
+
+size_t MappedFile::size() const
+{
+    return _size;
+}
+
+const std::string& MappedFile::path() const
+{
+    return _path;
+}
+
+void MappedFile::_close()
+{
+    #ifdef _WIN32
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping != nullptr)
+    {
+        CloseHandle(_mapping);
+    }
+    if (_file != nullptr)
+    {
+        CloseHandle(_file);
+    }
+    _mapping = nullptr;
+    _file = nullptr;
+    #else
+    if (_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(_data), _size);
+    }
+    if (_file >= 0)
+    {
+        close(_file);
+    }
+    _file = -1;
+    #endif
+    _data = nullptr;
+}
@@ -0,0 +1,87 @@
+#include <GameEngine/utilities/Archive.hpp>
+#include <filesystem>
+#include <memory>
+#include <iostream>
+#include <string>
+using namespace GameEngine;
+
+// Pack the files of directories into an archive. Each file is stored under its path relative to the directory it was found in.
+// Compressed files are kept in a derived data cache if --cache is given, so that unchanged files are not compressed again by the next builds.
+// usage: archive_packer <output archive> <directory> [<directory> ...] [--alignment <bytes>] [--compress] [--cache <directory>] [--shared-cache <directory>]
+int main(int argc, char** argv)
+{
+    std::string output;
+    std::vector<std::string> directories;
+    uint32_t alignment = 16;
+    bool compress = false;
+    std::string cache_directory;
+    std::string shared_cache_directory;
+    for (int i=1; i<argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--alignment" && i+1 < argc)
+        {
+            alignment = std::stoul(argv[++i]);
+        }
+        else if (argument == "--compress")
+        {
+            compress = true;
+        }
+        else if (argument == "--cache" && i+1 < argc)
+        {
+            cache_directory = argv[++i];
+        }
+        else if (argument == "--shared-cache" && i+1 < argc)
+        {
+            shared_cache_directory = argv[++i];
+        }
+        else if (output.empty())
+        {
+            output = argument;
+        }
+        else
+        {
+            directories.push_back(argument);
+        }
+    }
+    if (output.empty() || directories.empty() || (cache_directory.empty() && !shared_cache_directory.empty()))
+    {
+        std::cerr << "usage: archive_packer <output archive> <directory> [<directory> ...] [--alignment <bytes>] [--compress]"
+                     " [--cache <directory>] [--shared-cache <directory>]" << std::endl;
+        return 1;
+    }
+    try
+    {
+        std::unique_ptr<DerivedDataCache> cache;
+        if (!cache_directory.empty())
+        {
+            cache.reset(new DerivedDataCache(cache_directory, shared_cache_directory));
+        }
+        ArchiveWriter writer(alignment, cache.get());
+        size_t n_files = 0;
+        for (const std::string& directory : directories)
+        {
+            for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(directory))
+            {
+                if (!entry.is_regular_file())
+                {
+                    continue;
+                }
+                writer.add_file(std::filesystem::relative(entry.path(), directory).generic_string(), entry.path().string(), compress);
+                n_files++;
+            }
+        }
+        writer.write(output);
+        std::cout << "packed " << n_files << " files into " << output << std::endl;
+        if (cache != nullptr && compress)
+        {
+            std::cout << cache->hits() << " compressed files reused from the cache, " << cache->misses() << " compressed" << std::endl;
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}